@@ -0,0 +1,223 @@
+#pragma once
+
+#include "lib/std_lib.h"
+#include "container/container.h"
+#include "core/perf_counters.h"
+
+//minimal benchmark harness, a case registers itself with a static bench::suite like the ut suites of the tests
+namespace hyecs::bench
+{
+    struct options
+    {
+        std::string filter; //substring of the case name
+        std::string loop; //case name to run in a loop, for profilers and flamegraphs
+        double loop_seconds = 10.0;
+        size_t max_entities = std::numeric_limits<size_t>::max();
+        bool csv = false;
+        std::string trace; //chrome trace output path, needs a HYECS_TRACE build
+        bool counters = false; //hardware counters per case
+    };
+
+    struct result
+    {
+        std::string name;
+        size_t entity_count = 0;
+        size_t archetype_count = 0;
+        double ns_per_entity = 0;
+        double bytes_per_entity = 0;
+        perf::counter_values counters; //of one measured run, empty without --counters
+    };
+
+    //the counters read around the measured sections, set by main with --counters
+    inline const perf::counter_group*& counter_source()
+    {
+        static const perf::counter_group* source = nullptr;
+        return source;
+    }
+
+    inline perf::counter_values read_counters()
+    {
+        auto* source = counter_source();
+        return source ? source->read() : perf::counter_values{};
+    }
+
+    //sums the deltas of the sections of one measure
+    inline void add_counters(perf::counter_values& total, const perf::counter_values& delta)
+    {
+        total.valid_mask = total.empty() ? delta.valid_mask : total.valid_mask & delta.valid_mask;
+        for (size_t i = 0; i < perf::counter_count; i++) total.values[i] += delta.values[i];
+    }
+
+    inline perf::counter_values per_run(perf::counter_values counters, size_t runs)
+    {
+        for (auto& value: counters.values) value /= std::max<size_t>(runs, 1);
+        return counters;
+    }
+
+    class context
+    {
+        const options& m_options;
+        vector<result> m_results;
+        bool m_quiet = false;
+
+    public:
+        context(const options& opts) : m_options(opts) {}
+
+        const options& get_options() const { return m_options; }
+
+        //suppress the reporting, used by the loop mode
+        void set_quiet(bool quiet) { m_quiet = quiet; }
+
+        bool enabled(std::string_view name) const
+        {
+            return name.find(m_options.filter) != std::string_view::npos;
+        }
+
+        bool scale_enabled(size_t entity_count) const
+        {
+            return entity_count <= m_options.max_entities;
+        }
+
+        void report(const result& res)
+        {
+            m_results.push_back(res);
+            if (m_quiet) return;
+            if (m_options.csv)
+                std::cout << std::format("{},{},{},{:.3f},{:.1f}\n",
+                                         res.name, res.entity_count, res.archetype_count,
+                                         res.ns_per_entity, res.bytes_per_entity);
+            else
+                std::cout << std::format("{:<40}{:>10}{:>12}{:>14.3f}{:>16.1f}\n",
+                                         res.name, res.entity_count, res.archetype_count,
+                                         res.ns_per_entity, res.bytes_per_entity);
+            report_counters(res.name, res.counters, res.entity_count);
+        }
+
+        //counters of a case, per entity when the entity count is given, a comment line so the csv stays parseable
+        void report_counters(std::string_view case_name, const perf::counter_values& counters, size_t entity_count = 0) const
+        {
+            if (m_quiet || counters.empty()) return;
+            std::string line = std::format("# {} counters{}", case_name, entity_count ? " per entity" : "");
+            for (size_t i = 0; i < perf::counter_count; i++)
+            {
+                if (!counters.has(perf::counter(i))) continue;
+                if (entity_count)
+                    std::format_to(std::back_inserter(line), " {}={:.3f}", perf::counter_names[i],
+                                   double(counters.values[i]) / double(entity_count));
+                else
+                    std::format_to(std::back_inserter(line), " {}={}", perf::counter_names[i], counters.values[i]);
+            }
+            if (counters.has(perf::counter::cycles) && counters.has(perf::counter::instructions) && counters[perf::counter::cycles])
+                std::format_to(std::back_inserter(line), " ipc={:.2f}",
+                               double(counters[perf::counter::instructions]) / double(counters[perf::counter::cycles]));
+            std::cout << line << "\n";
+        }
+
+        void print_header() const
+        {
+            if (m_options.csv)
+                std::cout << "case,entities,archetypes,ns_per_entity,bytes_per_entity\n";
+            else
+                std::cout << std::format("{:<40}{:>10}{:>12}{:>14}{:>16}\n",
+                                         "case", "entities", "archetypes", "ns/entity", "bytes/entity");
+        }
+
+        const vector<result>& results() const { return m_results; }
+    };
+
+    struct case_info
+    {
+        std::string name;
+        std::function<void(context&)> run;
+    };
+
+    inline vector<case_info>& cases()
+    {
+        static vector<case_info> registered;
+        return registered;
+    }
+
+    struct suite
+    {
+        suite(std::string name, std::function<void(context&)> run)
+        {
+            cases().push_back({std::move(name), std::move(run)});
+        }
+    };
+
+    //keep a value alive so the measured loop is not optimized out
+    template<typename T>
+    void do_not_optimize(const T& value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const T* sink;
+        sink = &value;
+#endif
+    }
+
+    using clock = std::chrono::steady_clock;
+
+    inline double elapsed_ns(clock::time_point begin)
+    {
+        return std::chrono::duration<double, std::nano>(clock::now() - begin).count();
+    }
+
+    //repeat func until min_ns elapsed and at least min_repeat runs, returns the average ns of a run
+    //counters gets the average counters of a run
+    template<typename Func>
+    double measure(Func&& func, perf::counter_values& counters, double min_ns = 50'000'000.0, size_t min_repeat = 3)
+    {
+        size_t repeat = 0;
+        auto counters_begin = read_counters();
+        auto begin = clock::now();
+        double elapsed = 0;
+        do
+        {
+            func();
+            repeat++;
+            elapsed = elapsed_ns(begin);
+        } while (repeat < min_repeat || elapsed < min_ns);
+        counters = per_run(read_counters() - counters_begin, repeat);
+        return elapsed / double(repeat);
+    }
+
+    template<typename Func>
+    double measure(Func&& func, double min_ns = 50'000'000.0, size_t min_repeat = 3)
+    {
+        perf::counter_values counters;
+        return measure(std::forward<Func>(func), counters, min_ns, min_repeat);
+    }
+
+    //deterministic generator, benchmarks must not depend on the std distribution implementations
+    class xorshift
+    {
+        uint64_t m_state;
+
+    public:
+        xorshift(uint64_t seed = 0x9E3779B97F4A7C15ull) : m_state(seed) {}
+
+        uint64_t operator()()
+        {
+            m_state ^= m_state << 13;
+            m_state ^= m_state >> 7;
+            m_state ^= m_state << 17;
+            return m_state;
+        }
+
+        template<typename T>
+        void shuffle(vector<T>& values)
+        {
+            for (size_t i = values.size(); i > 1; i--)
+                std::swap(values[i - 1], values[(*this)() % i]);
+        }
+    };
+
+    //live bytes and allocation count of the global operator new, counted in bench_alloc.cpp
+    size_t allocated_bytes();
+    size_t allocation_count();
+
+    inline constexpr size_t entity_scales[] = {1'000, 100'000, 1'000'000};
+    inline constexpr size_t archetype_scales[] = {1, 10, 1000};
+}
@@ -0,0 +1,12 @@
+#include "pch.h"
+#include "bench.h"
+
+//global allocation accounting of the benchmark executable
+#include "core/alloc_counter_hook.h"
+
+namespace hyecs::bench
+{
+    size_t allocated_bytes() { return alloc::live_bytes(); }
+
+    size_t allocation_count() { return alloc::allocation_count(); }
+}
@@ -0,0 +1,81 @@
+#include "pch.h"
+#include "bench.h"
+
+#include "ecs/storage/table.h"
+
+using namespace hyecs;
+
+//iteration throughput of a single column table over the chunk sizes, to check the sizes chunk_size_policy picks
+//the case of the size the policy picks for the row is suffixed with .policy
+namespace bench_chunk_size
+{
+    template<size_t N>
+    struct payload
+    {
+        float v[N];
+    };
+
+    template<size_t N>
+    void run_row_size(bench::context& ctx, uint32_t entity_count)
+    {
+        const size_t row_size = sizeof(entity) + sizeof(payload<N>);
+        const size_t policy_size = chunk_size_policy{}.chunk_size(row_size);
+
+        component_group_index g = component_group_info{
+                .id = component_group_id{}
+        };
+        component_type_info info(generic::type_info::of<payload<N>>(), g, false);
+        component_type_index c = info;
+        vector<component_type_index> components = {c};
+
+        vector<entity> entities;
+        entities.reserve(entity_count);
+        for (uint32_t i = 0; i < entity_count; i++)
+            entities.push_back(entity{i, 0});
+
+        for (size_t chunk_size = component_table_chunk_traits::min_size;
+             chunk_size <= component_table_chunk_traits::max_size;
+             chunk_size *= 2)
+        {
+            table table(sorted_sequence_cref(sequence_cref(components)), chunk_size);
+            auto accessor = table.get_allocate_accessor(sequence_ref(entities).as_const(), [](entity, storage_key) {});
+            for (auto& component_accessor: accessor)
+            {
+                float i = 0;
+                for (void* addr: component_accessor)
+                {
+                    auto* p = new(addr) payload<N>{};
+                    p->v[0] = i++;
+                }
+            }
+            accessor.notify_construct_finish();
+
+            uint32_t index = 0;
+            perf::counter_values counters;
+            double ns = bench::measure([&]
+            {
+                float sum = 0;
+                table.dynamic_for_each(sequence_cref(&index, &index + 1), [&](sequence_ref<void*> addresses)
+                {
+                    sum += static_cast<payload<N>*>(addresses[0])->v[0];
+                });
+                bench::do_not_optimize(sum);
+            }, counters);
+
+            //the bytes of a chunk per row it holds
+            double bytes_per_entity = double(chunk_size) / double(chunk_size_policy::chunk_capacity(chunk_size, row_size));
+            ctx.report({std::format("table.chunk_size.row{}.{}{}", row_size, chunk_size, chunk_size == policy_size ? ".policy" : ""),
+                        entity_count, 1, ns / double(entity_count), bytes_per_entity, counters});
+        }
+    }
+
+    bench::suite chunk_size_suite("table.chunk_size", [](bench::context& ctx)
+    {
+        constexpr uint32_t entity_count = 100'000;
+        if (!ctx.scale_enabled(entity_count)) return;
+        run_row_size<2>(ctx, entity_count);
+        run_row_size<14>(ctx, entity_count);
+        run_row_size<48>(ctx, entity_count);
+        run_row_size<254>(ctx, entity_count);
+    });
+}
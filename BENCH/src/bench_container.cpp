@@ -0,0 +1,404 @@
+#include "pch.h"
+#include "bench.h"
+
+#include "container/entt/dense_map.h"
+#include "ecs/storage/entity_map.h"
+
+using namespace hyecs;
+
+//the entity keyed containers side by side, to pick the containers of storage_key_registry, table_tag_query and data_registry
+namespace bench_container
+{
+    //key sets of the workloads, in insertion order
+    vector<entity> dense_keys(size_t n)
+    {
+        vector<entity> keys;
+        keys.reserve(n);
+        for (uint32_t i = 0; i < n; i++) keys.emplace_back(i, 0);
+        return keys;
+    }
+
+    //ids after a churn: the survivors, then the freed half reused in lifo order with a new version
+    vector<entity> recycled_keys(size_t n)
+    {
+        vector<uint32_t> ids(n);
+        std::iota(ids.begin(), ids.end(), 0);
+        bench::xorshift rng;
+        rng.shuffle(ids);
+        vector<uint32_t> freed(ids.begin(), ids.begin() + n / 2);
+        vector<bool> is_freed(n);
+        for (auto id: freed) is_freed[id] = true;
+
+        vector<entity> keys;
+        keys.reserve(n);
+        for (uint32_t i = 0; i < n; i++)
+            if (!is_freed[i]) keys.emplace_back(i, 0);
+        for (auto iter = freed.rbegin(); iter != freed.rend(); ++iter)
+            keys.emplace_back(*iter, 1);
+        return keys;
+    }
+
+    //unique ids over a range 16 times the count
+    vector<entity> random_keys(size_t n)
+    {
+        bench::xorshift rng;
+        vector<entity> keys;
+        keys.reserve(n);
+        for (uint32_t i = 0; i < n; i++) keys.emplace_back(i * 16 + uint32_t(rng() % 16), 0);
+        rng.shuffle(keys);
+        return keys;
+    }
+
+    struct workload
+    {
+        const char* name;
+        vector<entity> (*make)(size_t);
+    };
+
+    constexpr workload workloads[] = {
+        {"dense", dense_keys},
+        {"recycled", recycled_keys},
+        {"random", random_keys},
+    };
+
+    //adapters give the containers a common insert/find/erase/iterate interface
+    //iterate returns the sum of the values, find returns the value of the key
+    template<typename Map>
+    struct std_like_adapter
+    {
+        using container = Map;
+        static constexpr bool has_erase = true;
+        static constexpr bool has_iterate = true;
+
+        static void insert(container& c, entity e, uint32_t value) { c.emplace(e, value); }
+
+        static uint32_t find(container& c, entity e) { return c.find(e)->second; }
+
+        static void erase(container& c, entity e) { c.erase(e); }
+
+        static uint64_t iterate(container& c)
+        {
+            uint64_t sum = 0;
+            for (auto&& [e, value]: c) sum += value;
+            return sum;
+        }
+    };
+
+    using entt_map = entt::dense_map<entity, uint32_t, std::hash<entity>, std::equal_to<entity>,
+                                     std::allocator<std::pair<const entity, uint32_t>>>;
+
+    struct entt_dense_map_adapter : std_like_adapter<entt_map>
+    {
+        static constexpr const char* name = "entt_dense_map";
+    };
+
+    struct unordered_dense_adapter : std_like_adapter<unordered_map<entity, uint32_t>>
+    {
+        static constexpr const char* name = "unordered_dense";
+    };
+
+    struct entity_dense_map_adapter : std_like_adapter<dense_map<entity, uint32_t>>
+    {
+        static constexpr const char* name = "entity_dense_map";
+
+        static uint32_t find(container& c, entity e) { return c.at(e); }
+    };
+
+    struct entity_sparse_table_adapter
+    {
+        using container = entity_sparse_map<uint32_t>;
+        static constexpr const char* name = "entity_sparse_table";
+        static constexpr bool has_erase = true;
+        static constexpr bool has_iterate = false; //no dense storage to iterate
+
+        static void insert(container& c, entity e, uint32_t value) { c.emplace(e, value); }
+
+        static uint32_t find(container& c, entity e) { return c.at(e); }
+
+        static void erase(container& c, entity e) { c.erase(e); }
+
+        static uint64_t iterate(container&) { return 0; }
+    };
+
+    struct entity_dense_set_adapter
+    {
+        using container = dense_set<entity>;
+        static constexpr const char* name = "entity_dense_set";
+        static constexpr bool has_erase = true;
+        static constexpr bool has_iterate = true;
+
+        static void insert(container& c, entity e, uint32_t) { c.insert(e); }
+
+        static uint32_t find(container& c, entity e) { return c.contains(e); }
+
+        static void erase(container& c, entity e) { c.erase(e); }
+
+        static uint64_t iterate(container& c)
+        {
+            uint64_t sum = 0;
+            for (entity e: c) sum += e.id();
+            return sum;
+        }
+    };
+
+    struct raw_entity_dense_map_adapter
+    {
+        struct container : raw_entity_dense_map
+        {
+            container() : raw_entity_dense_map(sizeof(uint32_t), alignof(uint32_t)) {}
+        };
+
+        static constexpr const char* name = "raw_entity_dense_map";
+        static constexpr bool has_erase = true;
+        static constexpr bool has_iterate = true;
+
+        static void insert(container& c, entity e, uint32_t value) { *static_cast<uint32_t*>(c.allocate_value(e)) = value; }
+
+        static uint32_t find(container& c, entity e) { return *static_cast<uint32_t*>(c.at(e)); }
+
+        static void erase(container& c, entity e) { c.deallocate_value(e); }
+
+        static uint64_t iterate(container& c)
+        {
+            uint64_t sum = 0;
+            for (auto pair: c) sum += *static_cast<uint32_t*>(pair.value);
+            return sum;
+        }
+    };
+
+    struct vaildref_map_adapter
+    {
+        using container = vaildref_map<entity, uint32_t>;
+        static constexpr const char* name = "vaildref_map";
+        static constexpr bool has_erase = false; //vaildref_map never erases
+        static constexpr bool has_iterate = true;
+
+        static void insert(container& c, entity e, uint32_t value) { c.emplace(e, value); }
+
+        static uint32_t find(container& c, entity e) { return c.at(e); }
+
+        static void erase(container&, entity) {}
+
+        static uint64_t iterate(container& c)
+        {
+            uint64_t sum = 0;
+            for (auto [e, value]: c) sum += value;
+            return sum;
+        }
+    };
+
+    template<size_t N>
+    struct small_vector_adapter
+    {
+        using container = small_vector<std::pair<entity, uint32_t>, N>;
+        static constexpr const char* name = "small_vector";
+        static constexpr bool has_erase = true;
+        static constexpr bool has_iterate = true;
+
+        static void insert(container& c, entity e, uint32_t value) { c.emplace_back(e, value); }
+
+        static auto find_iter(container& c, entity e)
+        {
+            return std::ranges::find(c, e, &std::pair<entity, uint32_t>::first);
+        }
+
+        static uint32_t find(container& c, entity e) { return find_iter(c, e)->second; }
+
+        static void erase(container& c, entity e)
+        {
+            auto iter = find_iter(c, e);
+            *iter = c.back();
+            c.pop_back();
+        }
+
+        static uint64_t iterate(container& c)
+        {
+            uint64_t sum = 0;
+            for (auto& [e, value]: c) sum += value;
+            return sum;
+        }
+    };
+
+    //average ns of op on a fresh state from make, the construction and destruction are not measured
+    //counters gets the average counters of an op
+    template<typename Make, typename Op>
+    double measure_fresh(Make&& make, Op&& op, perf::counter_values& counters,
+                         double min_ns = 50'000'000.0, size_t min_repeat = 3)
+    {
+        double total_ns = 0;
+        size_t repeat = 0;
+        perf::counter_values total;
+        while (repeat < min_repeat || total_ns < min_ns)
+        {
+            auto state = make();
+            auto counters_begin = bench::read_counters();
+            auto begin = bench::clock::now();
+            op(*state);
+            total_ns += bench::elapsed_ns(begin);
+            bench::add_counters(total, bench::read_counters() - counters_begin);
+            repeat++;
+        }
+        counters = bench::per_run(total, repeat);
+        return total_ns / double(repeat);
+    }
+
+    //measures one container with one key set, insert and erase work on fresh containers
+    template<typename Adapter>
+    void run_container(bench::context& ctx, const char* workload_name, const vector<entity>& keys)
+    {
+        using container = typename Adapter::container;
+        size_t n = keys.size();
+        auto lookup = keys;
+        bench::xorshift rng(n);
+        rng.shuffle(lookup);
+
+        auto fill = [&](container& c)
+        {
+            for (uint32_t i = 0; i < n; i++) Adapter::insert(c, keys[i], i);
+        };
+
+        size_t bytes_before = bench::allocated_bytes();
+        auto filled = std::make_unique<container>();
+        fill(*filled);
+        double bytes_per_entity = double(bench::allocated_bytes() - bytes_before) / double(n);
+
+        //the measure is evaluated before the report, it sets the counters of the row
+        perf::counter_values counters;
+        auto report = [&](const char* op, double ns)
+        {
+            ctx.report({std::format("container.{}.{}.{}", Adapter::name, workload_name, op),
+                        n, 0, ns / double(n), bytes_per_entity, counters});
+        };
+
+        report("insert", measure_fresh([] { return std::make_unique<container>(); }, fill, counters));
+
+        report("find", bench::measure([&]
+        {
+            uint64_t sum = 0;
+            for (auto e: lookup) sum += Adapter::find(*filled, e);
+            bench::do_not_optimize(sum);
+        }, counters));
+
+        if constexpr (Adapter::has_iterate)
+        {
+            report("iterate", bench::measure([&]
+            {
+                bench::do_not_optimize(Adapter::iterate(*filled));
+            }, counters));
+        }
+
+        if constexpr (Adapter::has_erase)
+        {
+            report("erase", measure_fresh([&]
+            {
+                auto c = std::make_unique<container>();
+                fill(*c);
+                return c;
+            }, [&](container& c)
+            {
+                for (auto e: lookup) Adapter::erase(c, e);
+            }, counters));
+        }
+    }
+
+    template<typename... Adapters>
+    void run_containers(bench::context& ctx)
+    {
+        for (size_t n: bench::entity_scales)
+        {
+            if (!ctx.scale_enabled(n)) continue;
+            for (auto& load: workloads)
+            {
+                auto keys = load.make(n);
+                (run_container<Adapters>(ctx, load.name, keys), ...);
+            }
+        }
+    }
+
+    bench::suite map_suite("container.map", [](bench::context& ctx)
+    {
+        run_containers<entt_dense_map_adapter,
+                       unordered_dense_adapter,
+                       entity_sparse_table_adapter,
+                       entity_dense_map_adapter,
+                       entity_dense_set_adapter,
+                       raw_entity_dense_map_adapter,
+                       vaildref_map_adapter>(ctx);
+    });
+
+    //linear search, only meaningful at the sizes of the per access caches
+    bench::suite small_vector_suite("container.small_vector", [](bench::context& ctx)
+    {
+        for (size_t n: {4, 16, 64})
+        {
+            for (auto& load: workloads)
+                run_container<small_vector_adapter<16>>(ctx, load.name, load.make(n));
+        }
+    });
+
+    //index keyed, allocate and release from the back like the archetype storages do on a churn free frame
+    bench::suite segmented_vector_suite("container.raw_segmented_vector", [](bench::context& ctx)
+    {
+        for (size_t n: bench::entity_scales)
+        {
+            if (!ctx.scale_enabled(n)) continue;
+            struct segments
+            {
+                raw_segmented_vector values{sizeof(uint32_t), alignof(uint32_t)};
+                vector<std::pair<void*, raw_segmented_vector::index_t>> slots;
+            };
+            auto fill = [&](segments& s)
+            {
+                s.slots.resize(n);
+                for (uint32_t i = 0; i < n; i++)
+                {
+                    s.slots[i] = s.values.allocate_value();
+                    *static_cast<uint32_t*>(s.slots[i].first) = i;
+                }
+            };
+
+            size_t bytes_before = bench::allocated_bytes();
+            auto filled = std::make_unique<segments>();
+            fill(*filled);
+            double bytes_per_entity = double(bench::allocated_bytes() - bytes_before) / double(n);
+            perf::counter_values counters;
+            auto report = [&](const char* op, double ns)
+            {
+                ctx.report({std::format("container.raw_segmented_vector.{}", op), n, 0, ns / double(n), bytes_per_entity,
+                            counters});
+            };
+
+            report("insert", measure_fresh([] { return std::make_unique<segments>(); }, fill, counters));
+
+            vector<raw_segmented_vector::index_t> lookup(n);
+            for (size_t i = 0; i < n; i++) lookup[i] = filled->slots[i].second;
+            bench::xorshift rng(n);
+            rng.shuffle(lookup);
+            report("find", bench::measure([&]
+            {
+                uint64_t sum = 0;
+                for (auto index: lookup) sum += *static_cast<const uint32_t*>(filled->values.at(index));
+                bench::do_not_optimize(sum);
+            }, counters));
+
+            report("iterate", bench::measure([&]
+            {
+                uint64_t sum = 0;
+                for (auto iter = filled->values.begin(); iter != filled->values.end(); ++iter)
+                    sum += *static_cast<uint32_t*>(*iter);
+                bench::do_not_optimize(sum);
+            }, counters));
+
+            report("erase", measure_fresh([&]
+            {
+                auto s = std::make_unique<segments>();
+                fill(*s);
+                return s;
+            }, [&](segments& s)
+            {
+                for (size_t i = n; i-- > 0;)
+                    s.values.deallocate_value(s.slots[i].first, s.slots[i].second, [] {});
+            }, counters));
+        }
+    });
+}
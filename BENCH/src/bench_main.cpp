@@ -0,0 +1,86 @@
+#include "pch.h"
+#include "bench.h"
+#include "core/trace.h"
+
+using namespace hyecs;
+
+//usage: HYECS_BENCH [filter] [--csv] [--max-entities N] [--loop case [seconds]] [--trace file.json] [--counters]
+int main(int argc, char** argv)
+{
+    bench::options opts;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+        if (arg == "--csv") opts.csv = true;
+        else if (arg == "--max-entities" && i + 1 < argc) opts.max_entities = std::stoull(argv[++i]);
+        else if (arg == "--loop" && i + 1 < argc)
+        {
+            opts.loop = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-') opts.loop_seconds = std::stod(argv[++i]);
+        }
+        else if (arg == "--trace" && i + 1 < argc) opts.trace = argv[++i];
+        else if (arg == "--counters") opts.counters = true;
+        else opts.filter = arg;
+    }
+
+#if !defined(HYECS_TRACE)
+    if (!opts.trace.empty()) std::cerr << "--trace needs a build with HYECS_TRACE\n";
+#endif
+    //the ring keeps the latest events of each thread, the trace holds the tail of a long run
+    auto write_trace = [&]
+    {
+#if defined(HYECS_TRACE)
+        if (!opts.trace.empty() && !trace::write_chrome_trace(opts.trace))
+            std::cerr << "cannot write " << opts.trace << "\n";
+#endif
+    };
+
+    //the hardware counters are optional, without them the cases run as usual
+    const perf::counter_group* counters = nullptr;
+    if (opts.counters)
+    {
+        auto& group = perf::thread_counters();
+        if (group.available()) counters = &group;
+        else std::cerr << "hardware counters unavailable (" << group.error() << ")\n";
+#if defined(HYECS_TRACE)
+        trace::enable_counters();
+#endif
+    }
+    bench::counter_source() = counters;
+
+    bench::context ctx(opts);
+    if (!opts.loop.empty())
+    {
+        //run a single case over and over so a sampling profiler sees only its hot path
+        auto iter = std::ranges::find(bench::cases(), opts.loop, &bench::case_info::name);
+        if (iter == bench::cases().end())
+        {
+            std::cerr << "unknown case " << opts.loop << "\n";
+            return 1;
+        }
+        ctx.set_quiet(true);
+        auto begin = bench::clock::now();
+        size_t runs = 0;
+        auto counters_begin = bench::read_counters();
+        while (bench::elapsed_ns(begin) < opts.loop_seconds * 1e9)
+        {
+            iter->run(ctx);
+            runs++;
+        }
+        std::cout << std::format("{} ran {} times\n", opts.loop, runs);
+        ctx.set_quiet(false);
+        ctx.report_counters(opts.loop, bench::read_counters() - counters_begin);
+        write_trace();
+        return 0;
+    }
+
+    ctx.print_header();
+    for (auto& bench_case: bench::cases())
+    {
+        if (!ctx.enabled(bench_case.name)) continue;
+        //the counters of the measured sections are reported with each row
+        bench_case.run(ctx);
+    }
+    write_trace();
+    return 0;
+}
@@ -0,0 +1,366 @@
+#include "pch.h"
+#include "bench.h"
+
+#include "ecs/data_registry.h"
+#include "ecs/type/component_group.h"
+
+using namespace hyecs;
+
+namespace bench_registry
+{
+#define CONCATENATE_DIRECT(a, b) a##b
+#define CONCATENATE(a, b) CONCATENATE_DIRECT(a, b)
+#define ANON CONCATENATE(_ecs_register_, __COUNTER__)
+
+    constexpr auto group_bench = named_component_group<"Bench">();
+    constexpr auto group_bench_other = named_component_group<"Bench Other">();
+    ecs_rtti_group_register ANON(group_bench);
+    ecs_rtti_group_register ANON(group_bench_other);
+
+    //iterated components
+    template<size_t N>
+    struct data_component
+    {
+        float value[4];
+    };
+
+    //spread entities over archetypes, 10 variants give up to 1024 archetypes
+    template<size_t N>
+    struct variant_component
+    {
+        uint32_t value;
+    };
+
+    struct bench_tag
+    {
+    };
+
+    struct other_component
+    {
+        float value;
+    };
+
+    constexpr size_t data_component_count = 8;
+    constexpr size_t variant_component_count = 10;
+
+    template<template<size_t> typename T, size_t... I>
+    struct component_registers
+    {
+        std::tuple<ecs_rtti_register<T<I>, group_bench>...> registers;
+    };
+
+    template<template<size_t> typename T, size_t... I>
+    component_registers<T, I...> make_registers(std::index_sequence<I...>);
+
+    decltype(make_registers<data_component>(std::make_index_sequence<data_component_count>{})) ANON;
+    decltype(make_registers<variant_component>(std::make_index_sequence<variant_component_count>{})) ANON;
+    ecs_rtti_register<bench_tag, group_bench> ANON;
+    ecs_rtti_register<other_component, group_bench_other> ANON;
+
+    struct component_entry
+    {
+        component_type_index type;
+        generic::constructor constructor;
+    };
+
+    template<template<size_t> typename T, size_t... I>
+    vector<component_entry> indexed_components(data_registry& registry, std::index_sequence<I...>)
+    {
+        return {component_entry{registry.get_component_index(type_hash::of<T<I>>()), generic::constructor(T<I>{})}...};
+    }
+
+    //sorted component list of an archetype
+    struct recipe
+    {
+        vector<component_type_index> types;
+        vector<generic::constructor> constructors;
+    };
+
+    struct fixture
+    {
+        data_registry registry;
+        vector<component_entry> data;
+        vector<component_entry> variants;
+        component_entry tag;
+        component_entry other;
+        vector<entity> entities;
+
+        fixture(const storage_policy& policy = {}) : registry(ecs_global_rtti_context::register_context())
+        {
+            registry.set_storage_policy(policy);
+            data = indexed_components<data_component>(registry, std::make_index_sequence<data_component_count>{});
+            variants = indexed_components<variant_component>(registry, std::make_index_sequence<variant_component_count>{});
+            tag = {registry.get_component_index(type_hash::of<bench_tag>()), generic::constructor(bench_tag{})};
+            other = {registry.get_component_index(type_hash::of<other_component>()), generic::constructor(other_component{})};
+        }
+
+        //the data components and the variant components selected by the bits of the archetype number
+        recipe make_recipe(size_t archetype, size_t data_count = data_component_count, bool tagged = false, bool crossed = false) const
+        {
+            vector<component_entry> entries(data.begin(), data.begin() + data_count);
+            for (size_t bit = 0; bit < variant_component_count; bit++)
+                if (archetype & (size_t(1) << bit)) entries.push_back(variants[bit]);
+            if (tagged) entries.push_back(tag);
+            if (crossed) entries.push_back(other);
+            std::ranges::sort(entries, [](const component_entry& a, const component_entry& b) { return a.type < b.type; });
+            recipe res;
+            for (auto& entry: entries)
+            {
+                res.types.push_back(entry.type);
+                res.constructors.push_back(entry.constructor);
+            }
+            return res;
+        }
+
+        void spawn(const recipe& rec, size_t count)
+        {
+            size_t offset = entities.size();
+            entities.resize(offset + count);
+            registry.emplace(sorted_sequence_cref(sequence_cref(rec.types)),
+                             sorted_sequence_cref(sequence_cref(rec.constructors)),
+                             sequence_ref(entities.data() + offset, entities.data() + offset + count));
+        }
+
+        //entity_count entities spread evenly over archetype_count archetypes
+        template<typename RecipeFunc>
+        void spawn_spread(size_t entity_count, size_t archetype_count, RecipeFunc&& make)
+        {
+            for (size_t arch = 0; arch < archetype_count; arch++)
+            {
+                size_t count = entity_count / archetype_count + (arch < entity_count % archetype_count ? 1 : 0);
+                if (count) spawn(make(arch), count);
+            }
+        }
+
+        double bytes_per_entity()
+        {
+            return double(registry.memory_report().total_bytes()) / double(std::max<size_t>(entities.size(), 1));
+        }
+    };
+
+    vector<component_type_index> sorted_types(const vector<component_entry>& entries, size_t count)
+    {
+        vector<component_type_index> types;
+        for (size_t i = 0; i < count; i++) types.push_back(entries[i].type);
+        std::ranges::sort(types);
+        return types;
+    }
+
+    storage_policy fixed_layout(storage_layout layout)
+    {
+        storage_policy policy;
+        policy.select = [layout](const storage_policy_context&) { return layout; };
+        return policy;
+    }
+
+    template<typename Func>
+    void for_each_scale(bench::context& ctx, Func&& func)
+    {
+        for (size_t entity_count: bench::entity_scales)
+        {
+            if (!ctx.scale_enabled(entity_count)) continue;
+            for (size_t archetype_count: bench::archetype_scales)
+                func(entity_count, archetype_count);
+        }
+    }
+
+    //read the first float of every accessed component
+    size_t iterate(query& q, const vector<component_type_index>& access)
+    {
+        auto& info = q.get_access_info(sequence_cref(access));
+        size_t count = 0;
+        float sum = 0;
+        q.dynamic_for_each(info, [&](entity, sequence_ref<void*> components)
+        {
+            for (void* component: components)
+                sum += static_cast<float*>(component)[0];
+            count++;
+        });
+        bench::do_not_optimize(sum);
+        return count;
+    }
+
+    const char* layout_name(storage_layout layout)
+    {
+        return layout == storage_layout::chunk ? "chunk" : "sparse";
+    }
+
+    bench::suite spawn_suite("registry.spawn", [](bench::context& ctx)
+    {
+        for_each_scale(ctx, [&](size_t entity_count, size_t archetype_count)
+        {
+            fixture fx;
+            auto recipes = vector<recipe>();
+            for (size_t arch = 0; arch < archetype_count; arch++)
+                recipes.push_back(fx.make_recipe(arch, 4));
+            auto counters_begin = bench::read_counters();
+            auto begin = bench::clock::now();
+            fx.spawn_spread(entity_count, archetype_count, [&](size_t arch) -> const recipe& { return recipes[arch]; });
+            double ns = bench::elapsed_ns(begin);
+            auto counters = bench::read_counters() - counters_begin;
+            ctx.report({"registry.spawn", entity_count, archetype_count, ns / double(entity_count), fx.bytes_per_entity(),
+                        counters});
+        });
+    });
+
+    bench::suite for_each_suite("registry.for_each", [](bench::context& ctx)
+    {
+        //chunk and sparse by forcing the layout, mixed iterates the tagged half of chunk archetypes through the table tag queries
+        enum class mode { chunk, sparse, mixed };
+        for (mode m: {mode::chunk, mode::sparse, mode::mixed})
+        {
+            for (size_t data_count: {1, 2, 4, 8})
+            {
+                const char* mode_name = m == mode::chunk ? "chunk" : m == mode::sparse ? "sparse" : "mixed";
+                auto name = std::format("registry.for_each.{}.{}", mode_name, data_count);
+                for_each_scale(ctx, [&](size_t entity_count, size_t archetype_count)
+                {
+                    fixture fx(fixed_layout(m == mode::sparse ? storage_layout::sparse : storage_layout::chunk));
+                    if (m == mode::mixed)
+                    {
+                        //every table holds tagged and untagged rows
+                        fx.spawn_spread(entity_count / 2, archetype_count, [&](size_t arch) { return fx.make_recipe(arch, data_count); });
+                        fx.spawn_spread(entity_count - entity_count / 2, archetype_count, [&](size_t arch)
+                        {
+                            return fx.make_recipe(arch, data_count, true);
+                        });
+                    }
+                    else fx.spawn_spread(entity_count, archetype_count, [&](size_t arch) { return fx.make_recipe(arch, data_count); });
+                    auto access = sorted_types(fx.data, data_count);
+                    auto condition = access;
+                    if (m == mode::mixed) condition.push_back(fx.tag.type);
+                    std::ranges::sort(condition);
+                    auto& q = fx.registry.get_query({sequence_cref(condition), {}, {}});
+                    size_t iterated = 0;
+                    perf::counter_values counters;
+                    double ns = bench::measure([&] { iterated = iterate(q, access); }, counters);
+                    ctx.report({name, iterated, archetype_count, ns / double(std::max<size_t>(iterated, 1)), fx.bytes_per_entity(),
+                                counters});
+                });
+            }
+        }
+    });
+
+    bench::suite random_access_suite("registry.random_access", [](bench::context& ctx)
+    {
+        for (storage_layout layout: {storage_layout::chunk, storage_layout::sparse})
+        {
+            auto name = std::format("registry.random_access.{}", layout_name(layout));
+            for_each_scale(ctx, [&](size_t entity_count, size_t archetype_count)
+            {
+                fixture fx(fixed_layout(layout));
+                fx.spawn_spread(entity_count, archetype_count, [&](size_t arch) { return fx.make_recipe(arch, 4); });
+                auto order = fx.entities;
+                bench::xorshift rng;
+                rng.shuffle(order);
+                auto types = sorted_types(fx.data, 2);
+                vector<void*> addresses(types.size());
+                perf::counter_values counters;
+                double ns = bench::measure([&]
+                {
+                    float sum = 0;
+                    for (auto e: order)
+                    {
+                        fx.registry.component_ramdom_access(e, sorted_sequence_cref(sequence_cref(types)), sequence_ref(addresses));
+                        sum += static_cast<float*>(addresses[0])[0] + static_cast<float*>(addresses[1])[0];
+                    }
+                    bench::do_not_optimize(sum);
+                }, counters);
+                ctx.report({name, entity_count, archetype_count, ns / double(entity_count), fx.bytes_per_entity(), counters});
+            });
+        }
+    });
+
+    bench::suite cross_query_suite("registry.cross_query", [](bench::context& ctx)
+    {
+        for_each_scale(ctx, [&](size_t entity_count, size_t archetype_count)
+        {
+            fixture fx;
+            //half of the archetypes join the other group
+            fx.spawn_spread(entity_count, archetype_count, [&](size_t arch)
+            {
+                return fx.make_recipe(arch, 2, false, archetype_count == 1 || arch % 2 == 0);
+            });
+            vector<component_type_index> condition = {fx.data[0].type, fx.other.type};
+            std::ranges::sort(condition);
+            auto& q = fx.registry.get_cross_query({sequence_cref(condition), {}, {}});
+            vector<component_type_index> access = {fx.data[0].type, fx.other.type};
+            auto& info = q.get_access_info(sequence_cref(access));
+            size_t iterated = 0;
+            perf::counter_values counters;
+            double ns = bench::measure([&]
+            {
+                iterated = 0;
+                float sum = 0;
+                q.dynamic_for_each(info, [&](entity, sequence_ref<void*> components)
+                {
+                    sum += static_cast<float*>(components[0])[0] + static_cast<float*>(components[1])[0];
+                    iterated++;
+                });
+                bench::do_not_optimize(sum);
+            }, counters);
+            ctx.report({"registry.cross_query", iterated, archetype_count,
+                        ns / double(std::max<size_t>(iterated, 1)), fx.bytes_per_entity(), counters});
+        });
+    });
+
+    bench::suite conversion_suite("registry.sparse_to_chunk", [](bench::context& ctx)
+    {
+        for_each_scale(ctx, [&](size_t entity_count, size_t archetype_count)
+        {
+            //the incremental conversion starts at the threshold and leaves the migration to the steps
+            fixture fx;
+            fx.registry.set_incremental_storage_conversion(true);
+            fx.spawn_spread(entity_count, archetype_count, [&](size_t arch) { return fx.make_recipe(arch, 4); });
+            size_t migrated = 0;
+            auto counters_begin = bench::read_counters();
+            auto begin = bench::clock::now();
+            while (fx.registry.has_pending_storage_conversion())
+                migrated += fx.registry.step_storage_conversion(std::numeric_limits<size_t>::max());
+            double ns = bench::elapsed_ns(begin);
+            auto counters = bench::read_counters() - counters_begin;
+            if (migrated == 0) return; //archetypes below the threshold
+            ctx.report({"registry.sparse_to_chunk", migrated, archetype_count, ns / double(migrated), fx.bytes_per_entity(),
+                        counters});
+        });
+    });
+
+    bench::suite migration_suite("registry.migration", [](bench::context& ctx)
+    {
+        for_each_scale(ctx, [&](size_t entity_count, size_t archetype_count)
+        {
+            //add the last data component to every entity
+            fixture fx;
+            auto& archetypes = fx.registry.m_archetype_registry;
+            vector<std::pair<archetype_storage*, archetype_storage*>> moves;
+            vector<std::pair<size_t, size_t>> ranges;
+            fx.spawn_spread(entity_count, archetype_count, [&](size_t arch)
+            {
+                auto rec = fx.make_recipe(arch, data_component_count - 1);
+                archetype_index src = archetypes.get_archetype(append_component(rec.types));
+                archetype_index dest = archetypes.get_archetype(src, append_component{fx.data.back().type});
+                moves.emplace_back(&fx.registry.m_archetypes_storage.at(src.hash()),
+                                   &fx.registry.m_archetypes_storage.at(dest.hash()));
+                ranges.emplace_back(fx.entities.size(), 0);
+                return rec;
+            });
+            for (size_t i = 0; i < ranges.size(); i++)
+                ranges[i].second = i + 1 < ranges.size() ? ranges[i + 1].first : fx.entities.size();
+
+            generic::constructor adding = fx.data.back().constructor;
+            auto counters_begin = bench::read_counters();
+            auto begin = bench::clock::now();
+            for (size_t i = 0; i < moves.size(); i++)
+            {
+                auto [src, dest] = moves[i];
+                auto [first, last] = ranges[i];
+                src->entity_change_archetype(sequence_cref(fx.entities.data() + first, fx.entities.data() + last),
+                                             dest, sorted_sequence_cref(sequence_cref(&adding, &adding + 1)));
+            }
+            double ns = bench::elapsed_ns(begin);
+            auto counters = bench::read_counters() - counters_begin;
+            ctx.report({"registry.migration", entity_count, archetype_count, ns / double(entity_count), fx.bytes_per_entity(),
+                        counters});
+        });
+    });
+}
@@ -0,0 +1,275 @@
+#include "pch.h"
+#include "bench.h"
+
+#include "ecs/data_registry.h"
+#include "ecs/type/component_group.h"
+
+using namespace hyecs;
+
+//archetype and query matching of archetype_registry at thousands of archetypes and queries
+//every scale is its own case so the loop mode can profile a single scenario
+//the entities column counts the measured operations, archetypes or queries
+namespace bench_registry_scaling
+{
+    constexpr size_t group_count = 10;
+    constexpr size_t group_component_count = 50;
+    constexpr size_t component_count = group_count * group_component_count;
+
+    template<size_t N>
+    struct scaling_data
+    {
+        uint32_t value;
+    };
+
+    template<size_t N>
+    struct scaling_tag
+    {
+    };
+
+    //every tenth component of a group is a tag
+    constexpr bool is_tag_component(size_t i) { return i % 10 == 9; }
+
+    template<size_t N>
+    using scaling_component = std::conditional_t<is_tag_component(N), scaling_tag<N>, scaling_data<N>>;
+
+    template<size_t... I>
+    std::array<const generic::type_info*, sizeof...(I)> make_type_infos(std::index_sequence<I...>)
+    {
+        return {&generic::type_info::of<scaling_component<I>>()...};
+    }
+
+    const std::array<const generic::type_info*, component_count>& type_infos()
+    {
+        static const auto infos = make_type_infos(std::make_index_sequence<component_count>{});
+        return infos;
+    }
+
+    //the synthetic groups live in their own context so the other benchmarks keep the global one small
+    //built once, a component takes a new bit key on every registration into a context
+    const ecs_rtti_context& scaling_context()
+    {
+        static const ecs_rtti_context context = []
+        {
+            ecs_rtti_context ctx;
+            for (size_t g = 0; g < group_count; g++)
+            {
+                std::string name = std::format("Scaling {}", g);
+                ctx.add_group(name);
+                for (size_t i = 0; i < group_component_count; i++)
+                {
+                    size_t index = g * group_component_count + i;
+                    ctx.add_component(component_group_id(name), generic::type_index(*type_infos()[index]), is_tag_component(index));
+                }
+            }
+            return ctx;
+        }();
+        return context;
+    }
+
+    //in group component subsets, keyed by the bits of the components inside the group
+    struct component_subset
+    {
+        size_t group;
+        uint64_t mask;
+
+        uint64_t key() const { return mask | uint64_t(group) << group_component_count; }
+    };
+
+    struct fixture
+    {
+        data_registry registry;
+        vector<vector<component_type_index>> groups; //components of each group
+        unordered_set<uint64_t> archetype_keys;
+        bench::xorshift rng;
+
+        fixture() : registry(scaling_context())
+        {
+            groups.resize(group_count);
+            for (size_t i = 0; i < component_count; i++)
+                groups[i / group_component_count].push_back(registry.get_component_index(type_infos()[i]->hash));
+        }
+
+        //count distinct components of a random group, tags have the same chance as the others
+        component_subset random_subset(size_t min_count, size_t max_count)
+        {
+            component_subset subset{rng() % group_count, 0};
+            size_t count = min_count + rng() % (max_count - min_count + 1);
+            while (size_t(std::popcount(subset.mask)) < count)
+                subset.mask |= uint64_t(1) << (rng() % group_component_count);
+            return subset;
+        }
+
+        vector<component_type_index> sorted_types(size_t group, uint64_t mask) const
+        {
+            vector<component_type_index> types;
+            for (size_t i = 0; i < group_component_count; i++)
+                if (mask & (uint64_t(1) << i)) types.push_back(groups[group][i]);
+            std::ranges::sort(types);
+            return types;
+        }
+
+        static bool has_data(uint64_t mask)
+        {
+            for (size_t i = 0; i < group_component_count; i++)
+                if ((mask & (uint64_t(1) << i)) && !is_tag_component(i)) return true;
+            return false;
+        }
+
+        //types of a new archetype, at least one data component so the tag archetypes have a base
+        vector<component_type_index> next_archetype()
+        {
+            while (true)
+            {
+                auto subset = random_subset(2, 8);
+                if (!has_data(subset.mask) || !archetype_keys.insert(subset.key()).second) continue;
+                return sorted_types(subset.group, subset.mask);
+            }
+        }
+
+        archetype_index add_archetype(const vector<component_type_index>& types)
+        {
+            return registry.m_archetype_registry.get_archetype(append_component(types));
+        }
+
+        //all and none of a new query, the none is a data component outside the all
+        //a tag only none is not supported by the archetype query nodes
+        std::pair<vector<component_type_index>, vector<component_type_index>> next_query()
+        {
+            while (true)
+            {
+                auto all = random_subset(1, 3);
+                component_subset none{all.group, 0};
+                if (has_data(all.mask) && rng() % 4 == 0)
+                {
+                    size_t bit;
+                    do bit = rng() % group_component_count;
+                    while ((all.mask & (uint64_t(1) << bit)) || is_tag_component(bit));
+                    none.mask = uint64_t(1) << bit;
+                }
+                auto all_types = sorted_types(all.group, all.mask);
+                auto none_types = sorted_types(none.group, none.mask);
+                if (registry.m_queries.contains(query_condition(sequence_cref(all_types), {}, sequence_cref(none_types)).hash()))
+                    continue;
+                return {std::move(all_types), std::move(none_types)};
+            }
+        }
+
+        void add_query(const vector<component_type_index>& all, const vector<component_type_index>& none)
+        {
+            registry.get_query({sequence_cref(all), {}, sequence_cref(none)});
+        }
+
+        void add_archetypes(size_t count)
+        {
+            for (size_t i = 0; i < count; i++) add_archetype(next_archetype());
+        }
+
+        void add_queries(size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                auto [all, none] = next_query();
+                add_query(all, none);
+            }
+        }
+
+        size_t archetype_count() const { return archetype_keys.size(); }
+    };
+
+    //reports the mean and the 99th percentile of the single operation latencies
+    void report_latencies(bench::context& ctx, const std::string& name, vector<double>& latencies,
+                          size_t archetype_count, double bytes_per_item)
+    {
+        double total = std::accumulate(latencies.begin(), latencies.end(), 0.0);
+        std::ranges::sort(latencies);
+        double p99 = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+        ctx.report({name, latencies.size(), archetype_count, total / double(latencies.size()), bytes_per_item});
+        ctx.report({name + ".p99", latencies.size(), archetype_count, p99, bytes_per_item});
+    }
+
+    constexpr size_t archetype_scales[] = {100, 1'000, 10'000};
+    constexpr size_t query_scales[] = {10, 100, 1'000};
+    constexpr size_t background_query_count = 100;
+    constexpr size_t background_archetype_count = 10'000;
+
+    //registering the 500 synthetic component types into a new registry
+    bench::suite types_suite("registry.scaling.types", [](bench::context& ctx)
+    {
+        scaling_context();
+        size_t bytes = 0;
+        perf::counter_values counters;
+        double ns = bench::measure([&]
+        {
+            size_t before = bench::allocated_bytes();
+            data_registry registry(scaling_context());
+            bytes = bench::allocated_bytes() - before;
+        }, counters);
+        ctx.report({"registry.scaling.types", component_count, 0, ns / double(component_count),
+                    double(bytes) / double(component_count), counters});
+    });
+
+    //archetype creation with the background queries registered, the memory is the registry total per archetype
+    const bool archetype_suites = []
+    {
+        for (size_t archetype_count: archetype_scales)
+        {
+            auto name = std::format("registry.scaling.archetypes.{}", archetype_count);
+            bench::cases().push_back({name, [name, archetype_count](bench::context& ctx)
+            {
+                fixture fx;
+                fx.add_queries(background_query_count);
+                vector<double> latencies;
+                latencies.reserve(archetype_count);
+                size_t bytes_before = bench::allocated_bytes();
+                for (size_t i = 0; i < archetype_count; i++)
+                {
+                    auto types = fx.next_archetype();
+                    auto begin = bench::clock::now();
+                    fx.add_archetype(types);
+                    latencies.push_back(bench::elapsed_ns(begin));
+                }
+                double bytes = double(bench::allocated_bytes() - bytes_before) / double(archetype_count);
+                report_latencies(ctx, name, latencies, fx.archetype_count(), bytes);
+            }});
+        }
+        return true;
+    }();
+
+    //query registration against the background archetypes, the case a mod or a script adds a system at runtime
+    const bool query_suites = []
+    {
+        for (size_t query_count: query_scales)
+        {
+            auto name = std::format("registry.scaling.queries.{}", query_count);
+            bench::cases().push_back({name, [name, query_count](bench::context& ctx)
+            {
+                fixture fx;
+                fx.add_archetypes(background_archetype_count);
+                vector<double> latencies;
+                latencies.reserve(query_count);
+                size_t bytes_before = bench::allocated_bytes();
+                for (size_t i = 0; i < query_count; i++)
+                {
+                    auto [all, none] = fx.next_query();
+                    auto begin = bench::clock::now();
+                    fx.add_query(all, none);
+                    latencies.push_back(bench::elapsed_ns(begin));
+                }
+                double bytes = double(bench::allocated_bytes() - bytes_before) / double(query_count);
+                report_latencies(ctx, name, latencies, fx.archetype_count(), bytes);
+            }});
+        }
+        return true;
+    }();
+
+    //registry memory at the largest scale, from the memory report
+    bench::suite memory_suite("registry.scaling.memory", [](bench::context& ctx)
+    {
+        fixture fx;
+        fx.add_queries(query_scales[std::size(query_scales) - 1]);
+        fx.add_archetypes(archetype_scales[std::size(archetype_scales) - 1]);
+        auto report = fx.registry.memory_report();
+        ctx.report({"registry.scaling.memory", 0, fx.archetype_count(), 0,
+                    double(report.total_bytes()) / double(fx.archetype_count())});
+    });
+}
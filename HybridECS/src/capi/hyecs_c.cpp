@@ -0,0 +1,269 @@
+#include "pch.h"
+#include "capi/hyecs_c.h"
+
+#include "ecs/data_registry.h"
+
+using namespace hyecs;
+
+static_assert(sizeof(hyecs_entity) == sizeof(entity) && alignof(hyecs_entity) == alignof(entity));
+
+namespace
+{
+    //type info of a component described by a host, kept at a stable address for the type indices
+    struct runtime_component
+    {
+        std::string name;
+        generic::type_info info;
+        component_type_index index;
+
+        runtime_component(const hyecs_component_desc& desc, std::string&& type_name)
+            : name(std::move(type_name)),
+              info(desc.size,
+                   desc.size ? desc.alignment : 0,
+                   desc.copy,
+                   desc.move,
+                   desc.destroy,
+                   flags_of(desc),
+                   type_hash::of_name(name),
+                   name.c_str())
+        {
+        }
+
+        static generic::type_flags flags_of(const hyecs_component_desc& desc)
+        {
+            using generic::type_flags;
+            type_flags flags = type_flags::movable | type_flags::copyable;
+            if (!desc.destroy) flags = flags | type_flags::trivially_destructible;
+            if (!desc.move) flags = flags | type_flags::trivially_move_constructible;
+            if (!desc.copy) flags = flags | type_flags::trivially_copy_constructible;
+            return flags;
+        }
+    };
+
+    const entity* to_entities(const hyecs_entity* entities) { return reinterpret_cast<const entity*>(entities); }
+
+    //no exception crosses the C boundary
+    template<typename Callable>
+    hyecs_result guarded(Callable&& func) noexcept
+    {
+        try
+        {
+            return func();
+        }
+        catch (...)
+        {
+            return HYECS_INTERNAL_ERROR;
+        }
+    }
+}
+
+struct hyecs_world
+{
+    data_registry registry;
+    vector<std::unique_ptr<runtime_component>> components; //indexed by hyecs_component
+    //the sorted all set of each query handed out, the access lists are checked against it
+    unordered_map<const query*, vector<component_type_index>> query_components;
+
+    bool valid(hyecs_component component) const { return component < components.size(); }
+
+    bool valid(const hyecs_component* list, uint32_t count) const
+    {
+        if (count && !list) return false;
+        for (uint32_t i = 0; i < count; i++)
+            if (!valid(list[i])) return false;
+        return true;
+    }
+
+    component_type_index index_of(hyecs_component component) const { return components[component]->index; }
+
+    //the indices of the components in the sorted order of the registry, false on a repeated component
+    bool sorted_indices(const hyecs_component* list, uint32_t count, memory::frame_vector<component_type_index>& indices) const
+    {
+        indices.clear();
+        for (uint32_t i = 0; i < count; i++) indices.push_back(index_of(list[i]));
+        std::ranges::sort(indices);
+        return std::ranges::adjacent_find(indices) == indices.end();
+    }
+};
+
+extern "C" {
+
+hyecs_world* hyecs_world_create(void)
+{
+    try
+    {
+        return new hyecs_world();
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void hyecs_world_destroy(hyecs_world* world)
+{
+    delete world;
+}
+
+hyecs_result hyecs_component_register(hyecs_world* world, const hyecs_component_desc* desc, hyecs_component* out_component)
+{
+    if (!world || !desc || !desc->name || !out_component) return HYECS_INVALID_ARGUMENT;
+    if (desc->size && (desc->alignment == 0 || (desc->alignment & (desc->alignment - 1)) != 0 || desc->size % desc->alignment != 0))
+        return HYECS_INVALID_ARGUMENT;
+    return guarded([&]
+    {
+        auto& registry = world->registry;
+        if (registry.m_component_type_infos.contains(type_hash::of_name(desc->name)))
+            return HYECS_DUPLICATE_COMPONENT;
+
+        std::string group_name = desc->group ? desc->group : "default";
+        component_group_id group_id(group_name);
+        component_group_info& group = registry.m_component_group_infos.contains(group_id)
+                                          ? registry.m_component_group_infos.at(group_id)
+                                          : registry.register_component_group(group_id, group_name);
+
+        auto& component = world->components.emplace_back(std::make_unique<runtime_component>(*desc, desc->name));
+        component->index = registry.register_component_type(generic::type_index(component->info), group, desc->is_tag != 0);
+        *out_component = hyecs_component(world->components.size() - 1);
+        return HYECS_OK;
+    });
+}
+
+hyecs_result hyecs_spawn(hyecs_world* world,
+                         const hyecs_component* components,
+                         uint32_t component_count,
+                         const void* const* initial_values,
+                         hyecs_entity* out_entities,
+                         uint32_t entity_count)
+{
+    if (!world || !world->valid(components, component_count) || component_count == 0) return HYECS_INVALID_ARGUMENT;
+    if (entity_count && !out_entities) return HYECS_INVALID_ARGUMENT;
+    return guarded([&]
+    {
+        memory::frame_scope frame;
+        //the constructors follow the sorted components
+        memory::frame_vector<std::pair<component_type_index, uint32_t>> order;
+        order.reserve(component_count);
+        for (uint32_t i = 0; i < component_count; i++) order.emplace_back(world->index_of(components[i]), i);
+        std::ranges::sort(order, {}, &std::pair<component_type_index, uint32_t>::first);
+        memory::frame_vector<component_type_index> sorted_components;
+        memory::frame_vector<generic::constructor> constructors;
+        sorted_components.reserve(component_count);
+        constructors.reserve(component_count);
+        for (auto [index, i]: order)
+        {
+            if (!sorted_components.empty() && sorted_components.back() == index) return HYECS_INVALID_ARGUMENT;
+            sorted_components.push_back(index);
+            const generic::type_info& info = world->components[components[i]]->info;
+            const void* value = initial_values ? initial_values[i] : nullptr;
+            if (info.size == 0)
+                constructors.emplace_back(generic::type_index(info), auto_delegate::function<void*(void*)>{});
+            else if (value)
+                constructors.emplace_back(generic::type_index(info), [type = generic::type_index(info), value](void* ptr)
+                {
+                    return type.copy_constructor(ptr, value);
+                });
+            else
+                constructors.emplace_back(generic::type_index(info), [size = info.size](void* ptr)
+                {
+                    return std::memset(ptr, 0, size);
+                });
+        }
+        if (entity_count == 0) return HYECS_OK;
+        entity* spawned = reinterpret_cast<entity*>(out_entities);
+        world->registry.emplace(sorted_sequence_cref<component_type_index>(sorted_components.begin(), sorted_components.end()),
+                                sorted_sequence_cref<generic::constructor>(constructors.begin(), constructors.end()),
+                                sequence_ref<entity>(spawned, spawned + entity_count));
+        return HYECS_OK;
+    });
+}
+
+hyecs_result hyecs_destroy(hyecs_world* world,
+                           const hyecs_component* components,
+                           uint32_t component_count,
+                           const hyecs_entity* entities,
+                           uint32_t entity_count)
+{
+    if (!world || !world->valid(components, component_count) || component_count == 0) return HYECS_INVALID_ARGUMENT;
+    if (entity_count && !entities) return HYECS_INVALID_ARGUMENT;
+    return guarded([&]
+    {
+        memory::frame_scope frame;
+        memory::frame_vector<component_type_index> sorted_components;
+        if (!world->sorted_indices(components, component_count, sorted_components)) return HYECS_INVALID_ARGUMENT;
+        if (entity_count == 0) return HYECS_OK;
+        world->registry.destroy(sorted_sequence_cref<component_type_index>(sorted_components.begin(), sorted_components.end()),
+                                sequence_cref<entity>(to_entities(entities), to_entities(entities) + entity_count));
+        return HYECS_OK;
+    });
+}
+
+hyecs_result hyecs_query_get(hyecs_world* world,
+                             const hyecs_component* all,
+                             uint32_t all_count,
+                             const hyecs_component* none,
+                             uint32_t none_count,
+                             hyecs_query** out_query)
+{
+    if (!world || !out_query || all_count == 0) return HYECS_INVALID_ARGUMENT;
+    if (!world->valid(all, all_count) || !world->valid(none, none_count)) return HYECS_INVALID_ARGUMENT;
+    return guarded([&]
+    {
+        memory::frame_scope frame;
+        memory::frame_vector<component_type_index> cond_all;
+        memory::frame_vector<component_type_index> cond_none;
+        if (!world->sorted_indices(all, all_count, cond_all) || !world->sorted_indices(none, none_count, cond_none))
+            return HYECS_INVALID_ARGUMENT;
+        const auto group = cond_all.front().group().id();
+        auto in_group = [&](component_type_index component) { return component.group().id() == group; };
+        if (!std::ranges::all_of(cond_all, in_group) || !std::ranges::all_of(cond_none, in_group))
+            return HYECS_CROSS_GROUP_QUERY;
+
+        vector<vector<component_type_index>> cond_anys;
+        query& q = world->registry.get_query(query_condition(sequence_cref<component_type_index>(cond_all), cond_anys,
+                                                             sequence_cref<component_type_index>(cond_none)));
+        world->query_components.try_emplace(&q, cond_all.begin(), cond_all.end());
+        *out_query = reinterpret_cast<hyecs_query*>(&q);
+        return HYECS_OK;
+    });
+}
+
+hyecs_result hyecs_query_for_each_batch(hyecs_world* world,
+                                        hyecs_query* query_handle,
+                                        const hyecs_component* access,
+                                        uint32_t access_count,
+                                        hyecs_batch_fn func,
+                                        void* user_data)
+{
+    if (!world || !query_handle || !func || !world->valid(access, access_count)) return HYECS_INVALID_ARGUMENT;
+    for (uint32_t i = 0; i < access_count; i++)
+        if (world->components[access[i]]->info.size == 0) return HYECS_INVALID_ARGUMENT;
+    return guarded([&]
+    {
+        //a handle of another world or an access outside the query would be read past the columns
+        query& q = *reinterpret_cast<query*>(query_handle);
+        auto query_iter = world->query_components.find(&q);
+        if (query_iter == world->query_components.end()) return HYECS_INVALID_ARGUMENT;
+        auto& query_components = query_iter->second;
+
+        memory::frame_scope frame;
+        memory::frame_vector<component_type_index> access_list;
+        access_list.reserve(access_count);
+        for (uint32_t i = 0; i < access_count; i++)
+        {
+            component_type_index component = world->index_of(access[i]);
+            if (!std::ranges::binary_search(query_components, component)) return HYECS_INVALID_ARGUMENT;
+            access_list.push_back(component);
+        }
+
+        auto& access_info = q.get_access_info(sequence_cref<component_type_index>(access_list));
+        q.dynamic_for_each_batch(access_info, [&](sequence_cref<entity> entities, sequence_cref<void*> columns,
+                                                  sequence_cref<uint32_t> strides, uint32_t count)
+        {
+            func(user_data, reinterpret_cast<const hyecs_entity*>(entities.begin()), columns.begin(), strides.begin(), count);
+        });
+        return HYECS_OK;
+    });
+}
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+//C interface of the data registry for scripting runtimes and FFI hosts
+//every call works on arrays of entities or on whole runs of rows, so a host crosses the boundary once per batch
+//
+//  hyecs_world* world = hyecs_world_create();
+//  hyecs_component_desc desc = {"position", "physics", sizeof(float) * 3, alignof(float)};
+//  hyecs_component position;
+//  hyecs_component_register(world, &desc, &position);
+//  hyecs_spawn(world, &position, 1, NULL, entities, 1000);
+//  hyecs_query* q;
+//  hyecs_query_get(world, &position, 1, NULL, 0, &q);
+//  hyecs_query_for_each_batch(world, q, &position, 1, integrate, user_data);
+//
+//the column pointers handed to the batch callback are only valid during the callback
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(HYECS_C_SHARED) && defined(_WIN32)
+#define HYECS_C_API __declspec(dllexport)
+#elif defined(HYECS_C_SHARED)
+#define HYECS_C_API __attribute__((visibility("default")))
+#else
+#define HYECS_C_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct hyecs_world hyecs_world;
+typedef struct hyecs_query hyecs_query;
+
+//index of a component registered in a world, only valid in that world
+typedef uint32_t hyecs_component;
+
+typedef struct hyecs_entity
+{
+    uint32_t id;
+    uint32_t version;
+} hyecs_entity;
+
+typedef enum hyecs_result
+{
+    HYECS_OK = 0,
+    HYECS_INVALID_ARGUMENT,
+    HYECS_DUPLICATE_COMPONENT,
+    //the components of a query must be of one group
+    HYECS_CROSS_GROUP_QUERY,
+    HYECS_INTERNAL_ERROR
+} hyecs_result;
+
+typedef struct hyecs_component_desc
+{
+    //unique in the world, the type is identified by the hash of the name
+    const char* name;
+    //components of a group are stored together in archetypes, NULL for the default group
+    const char* group;
+    //0 for a component without data
+    uint32_t size;
+    uint32_t alignment;
+    //tag components are stored apart from the archetype tables, e.g. rarely added markers
+    int is_tag;
+    //lifetime callbacks, NULL for data that is copied with memcpy and needs no destruction
+    void* (*copy)(void* dest, const void* src);
+    void* (*move)(void* dest, void* src);
+    void (*destroy)(void* addr);
+} hyecs_component_desc;
+
+//called once per run of rows, the component i of the row r is at (char*)columns[i] + r * strides[i]
+//with i in the order of the access list
+typedef void (*hyecs_batch_fn)(void* user_data,
+                               const hyecs_entity* entities,
+                               void* const* columns,
+                               const uint32_t* strides,
+                               uint32_t count);
+
+HYECS_C_API hyecs_world* hyecs_world_create(void);
+
+//destroys the components of all entities
+HYECS_C_API void hyecs_world_destroy(hyecs_world* world);
+
+HYECS_C_API hyecs_result hyecs_component_register(hyecs_world* world,
+                                                  const hyecs_component_desc* desc,
+                                                  hyecs_component* out_component);
+
+//creates entity_count entities with the components, written to out_entities
+//initial_values[i] is copied into the component i of every entity, NULL entries and a NULL array zero the data
+HYECS_C_API hyecs_result hyecs_spawn(hyecs_world* world,
+                                     const hyecs_component* components,
+                                     uint32_t component_count,
+                                     const void* const* initial_values,
+                                     hyecs_entity* out_entities,
+                                     uint32_t entity_count);
+
+//destroys entities spawned with exactly these components
+HYECS_C_API hyecs_result hyecs_destroy(hyecs_world* world,
+                                       const hyecs_component* components,
+                                       uint32_t component_count,
+                                       const hyecs_entity* entities,
+                                       uint32_t entity_count);
+
+//the entities with all of the all components and none of the none components
+//queries are cached and owned by the world, the same condition gives the same query
+HYECS_C_API hyecs_result hyecs_query_get(hyecs_world* world,
+                                         const hyecs_component* all,
+                                         uint32_t all_count,
+                                         const hyecs_component* none,
+                                         uint32_t none_count,
+                                         hyecs_query** out_query);
+
+//iterates the query in runs of rows, the access components must have data and be in the all components of the query,
+//HYECS_INVALID_ARGUMENT otherwise
+//the entities must not be spawned or destroyed during the iteration
+HYECS_C_API hyecs_result hyecs_query_for_each_batch(hyecs_world* world,
+                                                    hyecs_query* query,
+                                                    const hyecs_component* access,
+                                                    uint32_t access_count,
+                                                    hyecs_batch_fn func,
+                                                    void* user_data);
+
+#ifdef __cplusplus
+}
+#endif
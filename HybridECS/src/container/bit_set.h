@@ -1,5 +1,12 @@
 #pragma once
 #include "../lib/std_lib.h"
+#include "memory_resource.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
 
 namespace hyecs
 {
@@ -13,83 +20,249 @@ namespace hyecs
 		{}
 	};
 
-	template<typename Alloc = std::allocator<uint32_t>>
+	namespace details
+	{
+		//256 bits, the unit of the inline storage and of the sparse storage
+		struct bit_block
+		{
+			static constexpr uint32_t word_count = 8;
+			uint32_t words[word_count];
+
+#if defined(__AVX2__)
+			__m256i load() const { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words)); }
+
+			bool empty() const { auto a = load(); return _mm256_testz_si256(a, a); }
+			//(~this & other) == 0
+			bool contains(const bit_block& other) const { return _mm256_testc_si256(load(), other.load()); }
+			bool intersects(const bit_block& other) const { return !_mm256_testz_si256(load(), other.load()); }
+#elif defined(__SSE4_1__)
+			__m128i load(uint32_t half) const { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(words) + half); }
+
+			bool empty() const
+			{
+				auto a = _mm_or_si128(load(0), load(1));
+				return _mm_testz_si128(a, a);
+			}
+			bool contains(const bit_block& other) const
+			{
+				return _mm_testc_si128(load(0), other.load(0)) & _mm_testc_si128(load(1), other.load(1));
+			}
+			bool intersects(const bit_block& other) const
+			{
+				return !(_mm_testz_si128(load(0), other.load(0)) & _mm_testz_si128(load(1), other.load(1)));
+			}
+#else
+			bool empty() const
+			{
+				uint32_t any = 0;
+				for (uint32_t i = 0; i < word_count; i++) any |= words[i];
+				return any == 0;
+			}
+			bool contains(const bit_block& other) const
+			{
+				uint32_t missing = 0;
+				for (uint32_t i = 0; i < word_count; i++) missing |= other.words[i] & ~words[i];
+				return missing == 0;
+			}
+			bool intersects(const bit_block& other) const
+			{
+				uint32_t common = 0;
+				for (uint32_t i = 0; i < word_count; i++) common |= words[i] & other.words[i];
+				return common != 0;
+			}
+#endif
+		};
+	}
+
+	//a set of bit blocks sorted by block index, one block is kept inline
+	//the masks of an archetype fall in one or a few blocks as the components of a group are registered together,
+	//so the common case never allocates and the cost does not grow with the highest component id
+	template<typename Alloc = memory::resource_allocator<uint32_t>>
 	class basic_bit_set
 	{
-		uint32_t* data;
-		uint32_t size;
+		using block = details::bit_block;
+		static constexpr uint32_t block_words = block::word_count;
+		static constexpr uint32_t inline_capacity = 1;
+
+		uint32_t m_block_count;
+		uint32_t m_capacity;//blocks, above inline_capacity the blocks are on the heap
+		union
+		{
+			struct
+			{
+				block value;
+				uint32_t index;
+			} m_inline;
+
+			struct
+			{
+				block* blocks;
+				uint32_t* indices;
+			} m_heap;
+		};
 		[[no_unique_address]] Alloc alloc;
 
+		bool is_inline() const { return m_capacity == inline_capacity; }
+
+		block* blocks() { return is_inline() ? &m_inline.value : m_heap.blocks; }
+		const block* blocks() const { return is_inline() ? &m_inline.value : m_heap.blocks; }
+		uint32_t* indices() { return is_inline() ? &m_inline.index : m_heap.indices; }
+		const uint32_t* indices() const { return is_inline() ? &m_inline.index : m_heap.indices; }
+
+		//heap layout: the blocks then the indices, in words
+		static size_t heap_words(uint32_t capacity) { return size_t(capacity) * (block_words + 1); }
+
+		void deallocate()
+		{
+			if (!is_inline())
+				alloc.deallocate(reinterpret_cast<uint32_t*>(m_heap.blocks), heap_words(m_capacity));
+		}
+
+		void reset()
+		{
+			m_block_count = 0;
+			m_capacity = inline_capacity;
+		}
+
+		void reserve(uint32_t capacity)
+		{
+			if (capacity <= m_capacity) return;
+			uint32_t* data = alloc.allocate(heap_words(capacity));
+			auto new_blocks = reinterpret_cast<block*>(data);
+			auto new_indices = data + size_t(capacity) * block_words;
+			memcpy(new_blocks, blocks(), m_block_count * sizeof(block));
+			memcpy(new_indices, indices(), m_block_count * sizeof(uint32_t));
+			deallocate();
+			m_heap.blocks = new_blocks;
+			m_heap.indices = new_indices;
+			m_capacity = capacity;
+		}
+
+		void copy_from(const basic_bit_set& other)
+		{
+			reset();
+			reserve(other.m_block_count);
+			memcpy(blocks(), other.blocks(), other.m_block_count * sizeof(block));
+			memcpy(indices(), other.indices(), other.m_block_count * sizeof(uint32_t));
+			m_block_count = other.m_block_count;
+		}
+
+		void move_from(basic_bit_set& other)
+		{
+			m_block_count = other.m_block_count;
+			m_capacity = other.m_capacity;
+			if (other.is_inline())
+				m_inline = other.m_inline;
+			else
+				m_heap = other.m_heap;
+			other.reset();
+		}
+
+		uint32_t lower_bound(uint32_t index) const
+		{
+			auto begin = indices();
+			return std::lower_bound(begin, begin + m_block_count, index) - begin;
+		}
+
+		const block* find_block(uint32_t index) const
+		{
+			uint32_t pos = lower_bound(index);
+			if (pos == m_block_count || indices()[pos] != index) return nullptr;
+			return blocks() + pos;
+		}
+
+		block& block_for_insert(uint32_t index)
+		{
+			uint32_t pos = lower_bound(index);
+			if (pos != m_block_count && indices()[pos] == index) return blocks()[pos];
+			if (m_block_count == m_capacity) reserve(m_capacity * 4);
+			memmove(blocks() + pos + 1, blocks() + pos, (m_block_count - pos) * sizeof(block));
+			memmove(indices() + pos + 1, indices() + pos, (m_block_count - pos) * sizeof(uint32_t));
+			blocks()[pos] = block{};
+			indices()[pos] = index;
+			m_block_count++;
+			return blocks()[pos];
+		}
+
 	public:
 		basic_bit_set(Alloc alloc = Alloc())
-			: data(nullptr), size(0), alloc(alloc)
+			: m_block_count(0), m_capacity(inline_capacity), m_heap{}, alloc(alloc)
 		{
 		}
 
 		basic_bit_set(const basic_bit_set& other)
-			: size(other.size), alloc(other.alloc)
+			: m_block_count(0), m_capacity(inline_capacity), m_heap{}, alloc(other.alloc)
 		{
-			data = alloc.allocate(size);
-			memcpy(data, other.data, size * sizeof(uint32_t));
+			copy_from(other);
 		}
 
 		basic_bit_set(basic_bit_set&& other) noexcept
-			: size(other.size), alloc(std::move(other.alloc))
+			: alloc(std::move(other.alloc))
 		{
-			data = other.data;
-			other.data = nullptr;
-			other.size = 0;
+			move_from(other);
 		}
 
 		basic_bit_set& operator = (const basic_bit_set& other)
 		{
 			if (this == &other)
 				return *this;
-			alloc.deallocate(data, size);
-			size = other.size;
+			deallocate();
 			alloc = other.alloc;
-			data = alloc.allocate(size);
-			memcpy(data, other.data, size * sizeof(uint32_t));
+			copy_from(other);
+			return *this;
+		}
+
+		basic_bit_set& operator = (basic_bit_set&& other) noexcept
+		{
+			if (this == &other)
+				return *this;
+			deallocate();
+			alloc = std::move(other.alloc);
+			move_from(other);
 			return *this;
 		}
 
 		~basic_bit_set()
 		{
-			alloc.deallocate(data, size);
+			deallocate();
 		}
 
 		bool contains(bit_key key) const
 		{
-			if (key.section >= size)
-				return false;
-			return (data[key.section] & key.mask) != 0;
+			auto b = find_block(key.section / block_words);
+			return b && (b->words[key.section % block_words] & key.mask) != 0;
 		}
 
 		bool contains(const basic_bit_set& other) const
 		{
-			if (other.size > size)
-			{
-				for (uint32_t i = size; i < other.size; i++)
-				{
-					if (other.data[i] != 0)
-						return false;
-				}
-			}
-			for (uint32_t i = 0; i < std::min(size, other.size); i++)
+			//merge over the sorted block indices
+			auto self_indices = indices();
+			auto self_blocks = blocks();
+			uint32_t j = 0;
+			for (uint32_t i = 0; i < other.m_block_count; i++)
 			{
-				if ((data[i] & other.data[i]) != other.data[i])
-					return false;
+				const block& b = other.blocks()[i];
+				if (b.empty()) continue;
+				uint32_t index = other.indices()[i];
+				while (j < m_block_count && self_indices[j] < index) j++;
+				if (j == m_block_count || self_indices[j] != index) return false;
+				if (!self_blocks[j].contains(b)) return false;
 			}
 			return true;
 		}
 
-		//true for empty set
+		//false for empty set
 		bool contains_any(const basic_bit_set& other) const
 		{
-			for (uint32_t i = 0; i < std::min(size, other.size); i++)
+			auto self_indices = indices();
+			auto self_blocks = blocks();
+			uint32_t j = 0;
+			for (uint32_t i = 0; i < other.m_block_count; i++)
 			{
-				if ((data[i] & other.data[i]) != 0)
-					return true;
+				uint32_t index = other.indices()[i];
+				while (j < m_block_count && self_indices[j] < index) j++;
+				if (j == m_block_count) return false;
+				if (self_indices[j] == index && self_blocks[j].intersects(other.blocks()[i])) return true;
 			}
 			return false;
 		}
@@ -101,39 +274,27 @@ namespace hyecs
 
 		bool operator == (const basic_bit_set& other) const
 		{
-			auto [min_size,max_size] = std::minmax(size, other.size);
-
-			if (size != other.size)
-			{
-				//make sure the extra data is 0
-				auto& longer = size > other.size ? *this : other;
-				for (uint32_t i = min_size; i < max_size; i++)
-					if (longer.data[i] != 0)
-						return false;
-			}
-			for (uint32_t i = 0; i < min_size; i++)
-				if (data[i] != other.data[i])
-					return false;
-			return true;
+			//empty blocks may be left by erase on either side
+			return contains(other) && other.contains(*this);
 		}
 
 		void insert(bit_key key)
 		{
-			if (key.section >= size)
-			{
-				uint32_t* new_data = alloc.allocate(key.section + 1);
-				memset(new_data, 0, (key.section + 1) * sizeof(uint32_t));
-				memcpy(new_data, data, size * sizeof(uint32_t));
-				alloc.deallocate(data, size);
-				data = new_data;
-				size = key.section + 1;
-			}
-			data[key.section] |= key.mask;
+			block_for_insert(key.section / block_words).words[key.section % block_words] |= key.mask;
 		}
 
 		void erase(bit_key key)
 		{
-			data[key.section] &= ~key.mask;
+			uint32_t index = key.section / block_words;
+			uint32_t pos = lower_bound(index);
+			if (pos != m_block_count && indices()[pos] == index)
+				blocks()[pos].words[key.section % block_words] &= ~key.mask;
+		}
+
+		//bytes taken outside of the object
+		size_t heap_bytes() const
+		{
+			return is_inline() ? 0 : heap_words(m_capacity) * sizeof(uint32_t);
 		}
 
 	};
@@ -141,4 +302,4 @@ namespace hyecs
 	using bit_set = basic_bit_set<>;
 
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "../lib/std_lib.h"
+#include "stl_container.h"
+#include "core/meta/meta_utils.h"
+#include "core/runtime_type/generic_type.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace hyecs
+{
+    struct chunk_arena_config
+    {
+        size_t slab_size = 2 * 1024 * 1024;
+        //MAP_HUGETLB on linux, fall back to transparent huge page advice when not available
+        bool huge_pages = false;
+        //slabs and oversized chunks come from this resource instead of the system when set
+        std::pmr::memory_resource* upstream = nullptr;
+    };
+
+    //fixed size chunk pool, the chunks are carved out of large slabs and recycled through per-size free lists
+    //sizes are rounded up to a power of two in [min_chunk_size, max_chunk_size],
+    //a chunk is aligned to min(its size, page_size)
+    //this is not for multi-thread
+    class chunk_arena : non_movable
+    {
+    public:
+        static constexpr size_t min_chunk_size = 64;
+        static constexpr size_t max_chunk_size = 64 * 1024;
+        static constexpr size_t page_size = 4 * 1024;
+
+        using config = chunk_arena_config;
+
+    private:
+        static constexpr size_t size_class_count = std::bit_width(max_chunk_size) - std::bit_width(min_chunk_size) + 1;
+
+        struct free_node
+        {
+            free_node* next;
+        };
+
+        struct slab
+        {
+            std::byte* data;
+            size_t size;
+            bool mapped;
+        };
+
+        config m_config;
+        vector<slab> m_slabs;
+        std::array<free_node*, size_class_count> m_free_lists{};
+        std::byte* m_cursor = nullptr;
+        std::byte* m_slab_end = nullptr;
+        size_t m_allocated_bytes = 0;
+
+        static size_t size_class(size_t size)
+        {
+            assert(size <= max_chunk_size);
+            size_t class_size = std::bit_ceil(std::max(size, min_chunk_size));
+            return std::bit_width(class_size) - std::bit_width(min_chunk_size);
+        }
+
+        static size_t class_size(size_t size_class) { return min_chunk_size << size_class; }
+
+        void map_slab(slab& s)
+        {
+#if defined(__linux__)
+            void* ptr = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+            if (m_config.huge_pages)
+                ptr = mmap(nullptr, s.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+            if (ptr == MAP_FAILED)
+            {
+                ptr = mmap(nullptr, s.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#if defined(MADV_HUGEPAGE)
+                if (ptr != MAP_FAILED && m_config.huge_pages)
+                    madvise(ptr, s.size, MADV_HUGEPAGE);
+#endif
+            }
+            if (ptr != MAP_FAILED)
+            {
+                s.data = static_cast<std::byte*>(ptr);
+                s.mapped = true;
+            }
+#endif
+        }
+
+        void new_slab()
+        {
+            slab s{nullptr, m_config.slab_size, false};
+            if (!m_config.upstream)
+                map_slab(s);
+            if (!s.data)
+                s.data = acquire(s.size);
+            m_slabs.push_back(s);
+            m_cursor = s.data;
+            m_slab_end = s.data + s.size;
+        }
+
+        void release_slab(const slab& s)
+        {
+#if defined(__linux__)
+            if (s.mapped)
+            {
+                munmap(s.data, s.size);
+                return;
+            }
+#endif
+            release(s.data, s.size);
+        }
+
+        std::byte* acquire(size_t size)
+        {
+            if (m_config.upstream)
+                return static_cast<std::byte*>(m_config.upstream->allocate(size, page_size));
+            return static_cast<std::byte*>(::operator new(size, std::align_val_t(page_size)));
+        }
+
+        void release(std::byte* ptr, size_t size)
+        {
+            if (m_config.upstream)
+                return m_config.upstream->deallocate(ptr, size, page_size);
+            ::operator delete(ptr, size, std::align_val_t(page_size));
+        }
+
+        std::byte* carve(size_t size)
+        {
+            const size_t alignment = std::min(size, page_size);
+            auto align_up = [&](std::byte* ptr)
+            {
+                return reinterpret_cast<std::byte*>((reinterpret_cast<uintptr_t>(ptr) + alignment - 1) & ~(alignment - 1));
+            };
+            std::byte* ptr = m_cursor ? align_up(m_cursor) : nullptr;
+            if (!ptr || ptr + size > m_slab_end)
+            {
+                //the tail of the current slab is dropped
+                new_slab();
+                ptr = align_up(m_cursor);
+            }
+            m_cursor = ptr + size;
+            return ptr;
+        }
+
+    public:
+        chunk_arena(config cfg = {})
+            : m_config(cfg)
+        {
+            assert(std::has_single_bit(m_config.slab_size));
+            assert(m_config.slab_size >= max_chunk_size);
+        }
+
+        ~chunk_arena()
+        {
+            for (auto& s: m_slabs)
+                release_slab(s);
+        }
+
+        std::byte* allocate(size_t size)
+        {
+            if (size > max_chunk_size)
+            {
+                m_allocated_bytes += size;
+                return acquire(size);
+            }
+            size_t index = size_class(size);
+            m_allocated_bytes += class_size(index);
+            if (free_node* node = m_free_lists[index])
+            {
+                m_free_lists[index] = node->next;
+                return reinterpret_cast<std::byte*>(node);
+            }
+            return carve(class_size(index));
+        }
+
+        void deallocate(std::byte* ptr, size_t size)
+        {
+            if (size > max_chunk_size)
+            {
+                m_allocated_bytes -= size;
+                release(ptr, size);
+                return;
+            }
+            size_t index = size_class(size);
+            m_allocated_bytes -= class_size(index);
+            free_node* node = reinterpret_cast<free_node*>(ptr);
+            node->next = m_free_lists[index];
+            m_free_lists[index] = node;
+        }
+
+        //bytes handed out and not returned, rounded to the size classes, chunks past max_chunk_size at their size
+        size_t allocated_bytes() const { return m_allocated_bytes; }
+
+        //bytes taken from the system
+        size_t reserved_bytes() const { return m_slabs.size() * m_config.slab_size; }
+
+        size_t slab_count() const { return m_slabs.size(); }
+    };
+
+    //allocates chunks from a chunk_arena, or from generic::allocator when no arena is given
+    class chunk_allocator
+    {
+        chunk_arena* m_arena;
+        generic::allocator m_allocator;
+
+    public:
+        chunk_allocator(chunk_arena* arena = nullptr) : m_arena(arena) {}
+
+        chunk_allocator(size_t alignment, chunk_arena* arena = nullptr) : m_arena(arena), m_allocator(alignment) {}
+
+        void set_alignment(uint32_t alignment)
+        {
+            m_allocator.set_alignment(alignment);
+        }
+
+        chunk_arena* arena() const { return m_arena; }
+
+        std::byte* allocate(size_t bytes)
+        {
+            if (m_arena) return m_arena->allocate(bytes);
+            return m_allocator.allocate(bytes);
+        }
+
+        void deallocate(std::byte* ptr, size_t bytes)
+        {
+            if (m_arena) return m_arena->deallocate(ptr, bytes);
+            m_allocator.deallocate(ptr, bytes);
+        }
+    };
+}
@@ -6,12 +6,21 @@
 #include "sequence_ref.h"
 #include "raw_segmented_vector.h"
 #include "small_vector.h"
+#include "frame_arena.h"
+#include "streaming_store.h"
 
 namespace hyecs
 {
 
 	using gch::small_vector;
 
+	//per call scratch of the component addresses or indices of an access, on the stack for the usual access widths
+	//and in the thread frame arena for the wider ones
+	inline constexpr unsigned access_inline_capacity = 16;
+
+	template<typename T>
+	using access_buffer = small_vector<T, access_inline_capacity, memory::frame_allocator<T>>;
+
 	//template <
 	//	typename T,
 	//	unsigned InlineCapacity = gch::default_buffer_size<std::allocator<T>>::value,
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+
+#include "stl_container.h"
+
+//per thread bump allocator for the temporaries of one call or one frame
+//the blocks are kept across frames, so after the first frame the temporaries neither allocate nor leave the cache
+//
+//  memory::frame_scope frame;                  //rewinds the thread arena at the end of the scope
+//  memory::frame_vector<entity> hits;          //allocates from the thread arena
+//  memory::thread_frame_arena().reset();       //at the frame boundary, frees everything of the frame
+//
+//the memory of the arena is not returned on deallocate unless it is the latest allocation, a temporary that
+//outlives the frame_scope or the reset it was allocated in is a dangling pointer
+namespace hyecs::memory
+{
+    class frame_arena : public std::pmr::memory_resource
+    {
+    public:
+        static constexpr size_t default_block_size = 64 * 1024;
+
+        struct marker
+        {
+            void* block;
+            std::byte* cursor;
+        };
+
+    private:
+        struct alignas(std::max_align_t) block_header
+        {
+            block_header* next;
+            size_t size;
+
+            std::byte* data() { return reinterpret_cast<std::byte*>(this + 1); }
+            std::byte* end() { return data() + size; }
+        };
+
+        block_header* m_first = nullptr;
+        block_header* m_current = nullptr; //null before the first allocation of a frame
+        std::byte* m_cursor = nullptr;
+        size_t m_block_size;
+        size_t m_reserved_bytes = 0;
+
+        static std::byte* align_up(std::byte* ptr, size_t alignment)
+        {
+            return reinterpret_cast<std::byte*>((reinterpret_cast<uintptr_t>(ptr) + alignment - 1) & ~(alignment - 1));
+        }
+
+        std::byte* allocate_slow(size_t bytes, size_t alignment)
+        {
+            const size_t needed = bytes + alignment;
+            //blocks after the current one are left from earlier frames, too small ones are skipped for this frame
+            block_header* block = m_current ? m_current->next : m_first;
+            while (block && block->size < needed) block = block->next;
+            if (!block)
+            {
+                size_t size = needed > m_block_size ? needed : m_block_size;
+                block = static_cast<block_header*>(::operator new(sizeof(block_header) + size));
+                block->size = size;
+                m_reserved_bytes += size;
+                block_header*& link = m_current ? m_current->next : m_first;
+                block->next = link;
+                link = block;
+            }
+            m_current = block;
+            return align_up(block->data(), alignment);
+        }
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override { return allocate(bytes, alignment); }
+
+        void do_deallocate(void* ptr, size_t bytes, size_t) override { deallocate(ptr, bytes); }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    public:
+        explicit frame_arena(size_t block_size = default_block_size) : m_block_size(block_size) {}
+
+        frame_arena(const frame_arena&) = delete;
+        frame_arena& operator=(const frame_arena&) = delete;
+
+        ~frame_arena() override { release(); }
+
+        void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t))
+        {
+            std::byte* ptr = m_current ? align_up(m_cursor, alignment) : nullptr;
+            if (!ptr || ptr + bytes > m_current->end()) ptr = allocate_slow(bytes, alignment);
+            m_cursor = ptr + bytes;
+            return ptr;
+        }
+
+        //only the latest allocation is given back, e.g. a buffer freed right after it grew
+        void deallocate(void* ptr, size_t bytes)
+        {
+            if (static_cast<std::byte*>(ptr) + bytes == m_cursor) m_cursor = static_cast<std::byte*>(ptr);
+        }
+
+        marker mark() const { return {m_current, m_cursor}; }
+
+        //frees everything allocated after the marker
+        void rewind(marker m)
+        {
+            m_current = static_cast<block_header*>(m.block);
+            m_cursor = m.cursor;
+        }
+
+        //frees everything, the blocks are kept for the next frame
+        void reset() { rewind({nullptr, nullptr}); }
+
+        //returns the blocks to the system
+        void release()
+        {
+            while (m_first)
+            {
+                block_header* next = m_first->next;
+                ::operator delete(m_first);
+                m_first = next;
+            }
+            m_reserved_bytes = 0;
+            reset();
+        }
+
+        size_t reserved_bytes() const { return m_reserved_bytes; }
+    };
+
+    inline frame_arena& thread_frame_arena()
+    {
+        thread_local frame_arena arena;
+        return arena;
+    }
+
+    //rewinds an arena to where it was at the construction
+    class frame_scope
+    {
+        frame_arena& m_arena;
+        frame_arena::marker m_marker;
+
+    public:
+        explicit frame_scope(frame_arena& arena = thread_frame_arena()) : m_arena(arena), m_marker(arena.mark()) {}
+
+        frame_scope(const frame_scope&) = delete;
+        frame_scope& operator=(const frame_scope&) = delete;
+
+        ~frame_scope() { m_arena.rewind(m_marker); }
+    };
+
+    template<typename T>
+    class frame_allocator
+    {
+        template<typename U>
+        friend class frame_allocator;
+
+        frame_arena* m_arena;
+
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::false_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+        using is_always_equal = std::false_type;
+
+        frame_allocator() noexcept : m_arena(&thread_frame_arena()) {}
+
+        explicit frame_allocator(frame_arena& arena) noexcept : m_arena(&arena) {}
+
+        template<typename U>
+        frame_allocator(const frame_allocator<U>& other) noexcept : m_arena(other.m_arena) {}
+
+        T* allocate(size_t n)
+        {
+            if (n > SIZE_MAX / sizeof(T)) throw std::bad_array_new_length();
+            return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* ptr, size_t n) noexcept { m_arena->deallocate(ptr, n * sizeof(T)); }
+
+        template<typename U>
+        bool operator==(const frame_allocator<U>& other) const noexcept { return m_arena == other.m_arena; }
+    };
+
+    template<typename T>
+    using frame_vector = vector<T, frame_allocator<T>>;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+
+//the memory resource the hyecs containers allocate from
+//a container takes the resource of its thread when it is constructed and keeps it for its lifetime,
+//so a registry binds its resource while it creates containers and the later growth follows on its own
+namespace hyecs::memory
+{
+    namespace details
+    {
+        inline std::pmr::memory_resource*& bound_resource()
+        {
+            thread_local std::pmr::memory_resource* resource = nullptr;
+            return resource;
+        }
+    }
+
+    //new/delete unless a resource_scope is open on this thread
+    inline std::pmr::memory_resource* current_resource()
+    {
+        std::pmr::memory_resource* resource = details::bound_resource();
+        return resource ? resource : std::pmr::new_delete_resource();
+    }
+
+    //binds a resource to the calling thread until the scope ends or restore is called, scopes nest
+    class resource_scope
+    {
+        std::pmr::memory_resource* m_previous;
+        bool m_bound;
+
+    public:
+        explicit resource_scope(std::pmr::memory_resource* resource)
+            : m_previous(details::bound_resource()), m_bound(true)
+        {
+            details::bound_resource() = resource;
+        }
+
+        resource_scope(const resource_scope&) = delete;
+        resource_scope& operator=(const resource_scope&) = delete;
+
+        ~resource_scope() { restore(); }
+
+        void restore()
+        {
+            if (!m_bound) return;
+            details::bound_resource() = m_previous;
+            m_bound = false;
+        }
+    };
+
+    //allocator of the hyecs container aliases
+    //unlike std::pmr::polymorphic_allocator the resource follows the container on move and swap,
+    //so moving a container between registries never frees into the wrong resource
+    template<typename T>
+    class resource_allocator
+    {
+        template<typename U>
+        friend class resource_allocator;
+
+        std::pmr::memory_resource* m_resource;
+
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::false_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+        using is_always_equal = std::false_type;
+
+        resource_allocator() noexcept : m_resource(current_resource()) {}
+
+        explicit resource_allocator(std::pmr::memory_resource* resource) noexcept : m_resource(resource) {}
+
+        template<typename U>
+        resource_allocator(const resource_allocator<U>& other) noexcept : m_resource(other.m_resource) {}
+
+        T* allocate(size_t n)
+        {
+            if (n > SIZE_MAX / sizeof(T)) throw std::bad_array_new_length();
+            return static_cast<T*>(m_resource->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* ptr, size_t n) noexcept
+        {
+            m_resource->deallocate(ptr, n * sizeof(T), alignof(T));
+        }
+
+        std::pmr::memory_resource* resource() const noexcept { return m_resource; }
+
+        template<typename U>
+        bool operator==(const resource_allocator<U>& other) const noexcept
+        {
+            return m_resource == other.m_resource || m_resource->is_equal(*other.m_resource);
+        }
+    };
+}
@@ -2,6 +2,7 @@
 
 #include "sequence_ref.h"
 #include "core/runtime_type/generic_type.h"
+#include "chunk_arena.h"
 
 namespace hyecs
 {
@@ -32,7 +33,7 @@ namespace hyecs
         vector<chunk*> m_chunks;
         stack<std::pair<chunk*, uint32_t>> m_free_chunks;
         uint32_t m_type_size;
-        generic::allocator m_allocator;
+        chunk_allocator m_allocator;
         uint32_t chunk_element_capacity;
         uint32_t element_count;
 
@@ -42,8 +43,8 @@ namespace hyecs
 
 
     public:
-        raw_segmented_vector(size_t type_size, size_t alignment) noexcept
-                : m_type_size(type_size), m_allocator(alignment), element_count(0)
+        raw_segmented_vector(size_t type_size, size_t alignment, chunk_arena* arena = nullptr) noexcept
+                : m_type_size(type_size), m_allocator(alignment, arena), element_count(0)
         {
             chunk_element_capacity = default_chunk_byte_capacity / type_size;
             m_chunk_offset_bits = std::bit_width(chunk_element_capacity - 1);
@@ -115,6 +116,16 @@ namespace hyecs
             return m_type_size;
         }
 
+        size_t chunk_count() const noexcept
+        {
+            return m_chunks.size();
+        }
+
+        size_t memory_usage() const noexcept
+        {
+            return m_chunks.size() * sizeof(chunk) + m_chunks.capacity() * sizeof(chunk*);
+        }
+
         void* at(const size_t& index) noexcept
         {
             auto [chunk_index, chunk_offset] = chunk_index_offset(index);
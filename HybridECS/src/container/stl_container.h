@@ -1,6 +1,7 @@
 #pragma once
 #include "../lib/std_lib.h"
 #include "ankerl/unordered_dense.h"
+#include "memory_resource.h"
 
 namespace hyecs
 {
@@ -26,19 +27,20 @@ namespace hyecs
 #endif
 
 #define HYECS_USING_STD_VECTOR
-	template<typename T, typename Alloc = std::allocator<T>>
+	//the containers allocate from memory::current_resource() of their construction, see memory_resource.h
+	template<typename T, typename Alloc = memory::resource_allocator<T>>
 	using vector = std::vector<T, Alloc>;
 
-	template<typename T, typename Alloc = std::allocator<T>>
+	template<typename T, typename Alloc = memory::resource_allocator<T>>
 	using list = std::list<T, Alloc>;
 
-	template<typename T, typename Alloc = std::allocator<T>>
+	template<typename T, typename Alloc = memory::resource_allocator<T>>
 	using deque = std::deque<T, Alloc>;
 
 	template <
 		class T,
 		class Compare = std::less<T>,
-		class Alloc = std::allocator<T>
+		class Alloc = memory::resource_allocator<T>
 	>
 #if _HAS_CXX20
 	using set = std::set<T, Compare, Alloc>;
@@ -49,7 +51,7 @@ namespace hyecs
 	template <
 		class T,
 		class Compare = std::less<T>,
-		class Alloc = std::allocator<T>
+		class Alloc = memory::resource_allocator<T>
 	>
 	using multiset = std::multiset<T, Compare, Alloc>;
 
@@ -57,7 +59,7 @@ namespace hyecs
 		class T,
 		class Hash = std::hash<T>,
 		class Equal = std::equal_to<T>,
-		class Alloc = std::allocator<T>
+		class Alloc = memory::resource_allocator<T>
 	>
 	using unordered_set = ankerl::unordered_dense::set<T, Hash, Equal, Alloc>;
 
@@ -65,7 +67,7 @@ namespace hyecs
 		class T,
 		class Hash = std::hash<T>,
 		class Equal = std::equal_to<T>,
-		class Alloc = std::allocator<T>
+		class Alloc = memory::resource_allocator<T>
 	>
 	using unordered_multiset = std::unordered_multiset<T, Hash, Equal, Alloc>;
 
@@ -73,7 +75,7 @@ namespace hyecs
 		typename Key,
 		typename Value,
 		typename Compare = std::less<Key>,
-		typename Alloc = std::allocator<std::pair<const Key, Value>>
+		typename Alloc = memory::resource_allocator<std::pair<const Key, Value>>
 	>
 	using map = std::map<Key, Value, Compare, Alloc>;
 
@@ -81,7 +83,7 @@ namespace hyecs
 		typename Key,
 		typename Value,
 		typename Compare = std::less<Key>,
-		typename Alloc = std::allocator<std::pair<const Key, Value>>
+		typename Alloc = memory::resource_allocator<std::pair<const Key, Value>>
 	>
 	using multimap = std::multimap<Key, Value, Compare, Alloc>;
 
@@ -90,7 +92,7 @@ namespace hyecs
 		typename Value,
 		typename Hash = std::hash<Key>,
 		typename Equal = std::equal_to<Key>,
-		typename Alloc = std::allocator<std::pair<Key, Value>>
+		typename Alloc = memory::resource_allocator<std::pair<Key, Value>>
 	>
 	using unordered_map = ankerl::unordered_dense::map<Key, Value, Hash, Equal, Alloc>;
 
@@ -99,7 +101,7 @@ namespace hyecs
 		typename Value,
 		typename Hash = std::hash<Key>,
 		typename Equal = std::equal_to<Key>,
-		typename Alloc = std::allocator<std::pair<const Key, Value>>
+		typename Alloc = memory::resource_allocator<std::pair<const Key, Value>>
 	>
 	using unordered_multimap = std::unordered_multimap<Key, Value, Hash, Equal, Alloc>;
 
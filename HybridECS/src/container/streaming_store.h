@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HYECS_STREAMING_STORE 1
+#include <emmintrin.h>
+#endif
+
+//non-temporal stores for output that is not read back soon, e.g. render instance data written from the components
+//the stores bypass the cache, so filling a large column does not evict the working set of the next systems
+//
+//  memory::stream_store(column[i], value);     //for each row
+//  memory::stream_fence();                     //once after the last store
+//
+//the stores are weakly ordered, the fence must follow them before another thread reads the data
+namespace hyecs::memory
+{
+    //a column below this size is left to the cache, it is likely read again while still cached
+    inline constexpr size_t streaming_store_threshold = 1 << 20;
+
+    template<typename T>
+    concept streamable = std::is_trivially_copyable_v<T> &&
+                         sizeof(T) % sizeof(int32_t) == 0 &&
+                         alignof(T) >= alignof(int32_t);
+
+    //if a column of T over row_count rows is worth writing around the cache
+    template<typename T>
+    constexpr bool prefer_streaming(size_t row_count)
+    {
+        if constexpr (streamable<T>)
+            return row_count * sizeof(T) >= streaming_store_threshold;
+        else
+            return false;
+    }
+
+    template<streamable T>
+    void stream_store(T& dest, const T& value)
+    {
+#ifdef HYECS_STREAMING_STORE
+        if constexpr (alignof(T) >= 16 && sizeof(T) % 16 == 0)
+        {
+            auto dst = reinterpret_cast<__m128i*>(&dest);
+            auto src = reinterpret_cast<const __m128i*>(&value);
+            for (size_t i = 0; i < sizeof(T) / 16; i++)
+                _mm_stream_si128(dst + i, _mm_loadu_si128(src + i));
+        }
+        else
+        {
+            int words[sizeof(T) / sizeof(int)];
+            std::memcpy(words, &value, sizeof(T));
+            auto dst = reinterpret_cast<int*>(&dest);
+            for (size_t i = 0; i < sizeof(T) / sizeof(int); i++)
+                _mm_stream_si32(dst + i, words[i]);
+        }
+#else
+        dest = value;
+#endif
+    }
+
+    //orders the streaming stores before the stores that follow
+    inline void stream_fence()
+    {
+#ifdef HYECS_STREAMING_STORE
+        _mm_sfence();
+#endif
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+//heap allocation accounting of the global operator new
+//the hook lives in core/alloc_counter_hook.h, included by exactly one translation unit of the executable
+//without the hook the counters stay at zero and hooked() is false
+namespace hyecs::alloc
+{
+    struct counters
+    {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+    };
+
+    namespace details
+    {
+        //constant initialized, safe to touch from inside operator new
+        inline counters& thread_counters()
+        {
+            thread_local counters c;
+            return c;
+        }
+
+        inline std::atomic<size_t> g_live_bytes{0};
+        inline std::atomic<uint64_t> g_allocation_count{0};
+        inline std::atomic<bool> g_hooked{false};
+
+        inline void on_allocate(size_t size)
+        {
+            auto& c = thread_counters();
+            c.allocations++;
+            c.bytes += size;
+            g_live_bytes.fetch_add(size, std::memory_order_relaxed);
+            g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        inline void on_deallocate(size_t size)
+        {
+            g_live_bytes.fetch_sub(size, std::memory_order_relaxed);
+        }
+    }
+
+    inline bool hooked() { return details::g_hooked.load(std::memory_order_relaxed); }
+
+    //bytes allocated and not freed yet, all threads
+    inline size_t live_bytes() { return details::g_live_bytes.load(std::memory_order_relaxed); }
+
+    //allocations since the start, all threads
+    inline uint64_t allocation_count() { return details::g_allocation_count.load(std::memory_order_relaxed); }
+
+    //allocations of the calling thread since it started
+    inline counters thread_totals() { return details::thread_counters(); }
+
+    //allocations of the calling thread inside the scope, e.g. a frame, a system or a query iteration
+    //
+    //  alloc::scope frame;
+    //  run_systems();
+    //  assert(frame.allocations() == 0);
+    class scope
+    {
+        counters m_begin;
+
+    public:
+        scope() : m_begin(thread_totals()) {}
+
+        counters get() const
+        {
+            counters now = thread_totals();
+            return {now.allocations - m_begin.allocations, now.bytes - m_begin.bytes};
+        }
+
+        uint64_t allocations() const { return get().allocations; }
+        uint64_t bytes() const { return get().bytes; }
+
+        double allocations_per(size_t iterations) const { return double(allocations()) / double(iterations); }
+
+        void reset() { m_begin = thread_totals(); }
+    };
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdlib>
+#include <new>
+
+#include "alloc_counter.h"
+
+//replaces the global operator new and delete with the counting ones of alloc_counter.h
+//include it in one translation unit of the executable, a second inclusion is a multiple definition
+namespace hyecs::alloc::details
+{
+    //every allocation carries a header with its size, so the sized and unsized deletes agree
+    struct allocation_header
+    {
+        size_t size;
+        size_t offset; //from the malloc result to the returned pointer
+    };
+
+    inline void* tracked_allocate(size_t size, size_t alignment)
+    {
+        alignment = alignment > alignof(std::max_align_t) ? alignment : alignof(std::max_align_t);
+        auto* raw = static_cast<std::byte*>(std::malloc(size + sizeof(allocation_header) + alignment));
+        if (!raw) throw std::bad_alloc();
+        auto address = reinterpret_cast<uintptr_t>(raw + sizeof(allocation_header));
+        address = (address + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        auto* ptr = reinterpret_cast<std::byte*>(address);
+        new(ptr - sizeof(allocation_header)) allocation_header{size, size_t(ptr - raw)};
+        on_allocate(size);
+        return ptr;
+    }
+
+    inline void tracked_deallocate(void* ptr) noexcept
+    {
+        if (!ptr) return;
+        auto* bytes = static_cast<std::byte*>(ptr);
+        auto* header = reinterpret_cast<allocation_header*>(bytes - sizeof(allocation_header));
+        on_deallocate(header->size);
+        std::free(bytes - header->offset);
+    }
+
+    inline const bool g_hook_installed = []
+    {
+        g_hooked.store(true, std::memory_order_relaxed);
+        return true;
+    }();
+}
+
+void* operator new(std::size_t size) { return hyecs::alloc::details::tracked_allocate(size, alignof(std::max_align_t)); }
+
+void* operator new[](std::size_t size) { return hyecs::alloc::details::tracked_allocate(size, alignof(std::max_align_t)); }
+
+void* operator new(std::size_t size, std::align_val_t alignment) { return hyecs::alloc::details::tracked_allocate(size, size_t(alignment)); }
+
+void* operator new[](std::size_t size, std::align_val_t alignment) { return hyecs::alloc::details::tracked_allocate(size, size_t(alignment)); }
+
+void operator delete(void* ptr) noexcept { hyecs::alloc::details::tracked_deallocate(ptr); }
+
+void operator delete[](void* ptr) noexcept { hyecs::alloc::details::tracked_deallocate(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { hyecs::alloc::details::tracked_deallocate(ptr); }
+
+void operator delete[](void* ptr, std::size_t) noexcept { hyecs::alloc::details::tracked_deallocate(ptr); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept { hyecs::alloc::details::tracked_deallocate(ptr); }
+
+void operator delete[](void* ptr, std::align_val_t) noexcept { hyecs::alloc::details::tracked_deallocate(ptr); }
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { hyecs::alloc::details::tracked_deallocate(ptr); }
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { hyecs::alloc::details::tracked_deallocate(ptr); }
@@ -7,6 +7,7 @@
 #include "runtime_type/generic_type.h"
 #include "utils.h"
 #include "marco.h"
+#include "trace.h"
 
 namespace hyecs
 {
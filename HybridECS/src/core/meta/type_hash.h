@@ -14,6 +14,8 @@ namespace hyecs
 	public:
 		template<typename T>
 		static constexpr type_hash of(){ return type_name<T>.hash64();}
+		//the hash of a type known by name only, e.g. a type registered at runtime
+		static constexpr type_hash of_name(std::string_view name){ return string_hash(name.data(), name.size());}
 
         constexpr type_hash() : hash(0) {}
 		constexpr type_hash(const type_hash& other) noexcept : hash(other.hash) {}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//hardware performance counters of the calling thread, linux perf_event_open
+//the counters are optional everywhere: without the syscall, without the permission (perf_event_paranoid,
+//containers, most virtual machines) or without a pmu event the group is unavailable or the value is missing
+namespace hyecs::perf
+{
+    enum class counter : uint8_t
+    {
+        cycles,
+        instructions,
+        l1d_misses,
+        llc_misses,
+        dtlb_misses,
+        branch_misses,
+    };
+
+    inline constexpr size_t counter_count = 6;
+
+    inline constexpr const char* counter_names[counter_count] = {
+        "cycles", "instructions", "l1d_misses", "llc_misses", "dtlb_misses", "branch_misses"
+    };
+
+    struct counter_values
+    {
+        std::array<uint64_t, counter_count> values{};
+        uint8_t valid_mask = 0; //bit per counter that was read
+
+        bool has(counter c) const { return valid_mask & (1 << size_t(c)); }
+        bool empty() const { return valid_mask == 0; }
+        uint64_t operator[](counter c) const { return values[size_t(c)]; }
+
+        //difference of two readings of the same group
+        counter_values operator-(const counter_values& begin) const
+        {
+            counter_values result;
+            result.valid_mask = valid_mask & begin.valid_mask;
+            for (size_t i = 0; i < counter_count; i++)
+                result.values[i] = values[i] >= begin.values[i] ? values[i] - begin.values[i] : 0;
+            return result;
+        }
+    };
+
+    //the counters are opened as one group so a read is a single syscall and the values cover the same interval
+    //counters the pmu does not support are left out of the group
+    class counter_group
+    {
+        int m_leader = -1;
+        int m_fds[counter_count];
+        uint8_t m_valid_mask = 0;
+        uint8_t m_read_order[counter_count]; //counter of the i-th value of a group read
+        size_t m_opened = 0;
+        std::string m_error;
+
+#if defined(__linux__)
+        static perf_event_attr make_attr(counter c)
+        {
+            auto cache_miss = [](uint64_t cache)
+            {
+                return cache | (uint64_t(PERF_COUNT_HW_CACHE_OP_READ) << 8) | (uint64_t(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+            };
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            switch (c)
+            {
+                case counter::cycles:
+                    attr.type = PERF_TYPE_HARDWARE;
+                    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                    break;
+                case counter::instructions:
+                    attr.type = PERF_TYPE_HARDWARE;
+                    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                    break;
+                case counter::l1d_misses:
+                    attr.type = PERF_TYPE_HW_CACHE;
+                    attr.config = cache_miss(PERF_COUNT_HW_CACHE_L1D);
+                    break;
+                case counter::llc_misses:
+                    attr.type = PERF_TYPE_HW_CACHE;
+                    attr.config = cache_miss(PERF_COUNT_HW_CACHE_LL);
+                    break;
+                case counter::dtlb_misses:
+                    attr.type = PERF_TYPE_HW_CACHE;
+                    attr.config = cache_miss(PERF_COUNT_HW_CACHE_DTLB);
+                    break;
+                case counter::branch_misses:
+                    attr.type = PERF_TYPE_HARDWARE;
+                    attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                    break;
+            }
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            return attr;
+        }
+#endif
+
+    public:
+        counter_group()
+        {
+#if defined(__linux__)
+            for (size_t i = 0; i < counter_count; i++)
+            {
+                perf_event_attr attr = make_attr(counter(i));
+                attr.disabled = m_leader == -1;
+                //pid 0 and cpu -1: the calling thread on any cpu
+                int fd = int(syscall(SYS_perf_event_open, &attr, 0, -1, m_leader, 0));
+                if (fd == -1)
+                {
+                    if (m_error.empty()) m_error = std::string(counter_names[i]) + ": " + strerror(errno);
+                    continue;
+                }
+                if (m_leader == -1) m_leader = fd;
+                m_fds[m_opened] = fd;
+                m_read_order[m_opened] = uint8_t(i);
+                m_opened++;
+                m_valid_mask |= 1 << i;
+            }
+            if (m_leader != -1)
+            {
+                ioctl(m_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                ioctl(m_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+#else
+            m_error = "perf_event_open is linux only";
+#endif
+        }
+
+        counter_group(const counter_group&) = delete;
+        counter_group& operator=(const counter_group&) = delete;
+
+        ~counter_group()
+        {
+#if defined(__linux__)
+            for (size_t i = 0; i < m_opened; i++) close(m_fds[i]);
+#endif
+        }
+
+        bool available() const { return m_valid_mask != 0; }
+
+        //why the first counter failed to open, empty if all did
+        const std::string& error() const { return m_error; }
+
+        //running totals, scaled when the kernel multiplexed the group
+        counter_values read() const
+        {
+            counter_values result;
+#if defined(__linux__)
+            if (m_leader == -1) return result;
+            uint64_t buffer[3 + counter_count];
+            ssize_t size = ::read(m_leader, buffer, sizeof(buffer));
+            if (size < ssize_t(3 * sizeof(uint64_t)) || buffer[0] != m_opened) return result;
+            uint64_t enabled = buffer[1];
+            uint64_t running = buffer[2];
+            if (running == 0) return result; //the group was never scheduled
+            for (size_t i = 0; i < m_opened; i++)
+            {
+                uint64_t value = buffer[3 + i];
+                if (running < enabled) value = uint64_t(double(value) * double(enabled) / double(running));
+                result.values[m_read_order[i]] = value;
+            }
+            result.valid_mask = m_valid_mask;
+#endif
+            return result;
+        }
+    };
+
+    //one group per thread, opened on first use
+    inline counter_group& thread_counters()
+    {
+        thread_local counter_group group;
+        return group;
+    }
+}
@@ -2,6 +2,7 @@
 
 #include "core/delegate/function.h"
 #include "core/meta/type_hash.h"
+#include "container/memory_resource.h"
 #include "../marco.h"
 
 
@@ -459,9 +460,11 @@ namespace hyecs::generic
     };
 
 
+    //aligned byte allocator over the memory resource current at its construction
     class allocator
     {
         uint32_t alignment_p2;
+        std::pmr::memory_resource* m_resource = memory::current_resource();
     public:
         using value_type = std::byte;
         using const_pointer = const value_type*;
@@ -481,54 +484,18 @@ namespace hyecs::generic
             assert(1 << alignment_p2 == alignment);
         }
 
-    private:
-        template<auto align>
-        struct alignas(align) align_type {};
+        std::pmr::memory_resource* resource() const { return m_resource; }
 
-        auto switch_allocator(auto&& func)
-        {
-#define ALIGN_FOR(p2) case p2: return func(std::allocator<align_type<(1<<p2)>>{}); break;
-            switch (alignment_p2)
-            {
-                ALIGN_FOR(0);
-                ALIGN_FOR(1);
-                ALIGN_FOR(2);
-                ALIGN_FOR(3);
-                ALIGN_FOR(4);
-                ALIGN_FOR(5);
-                ALIGN_FOR(6);
-                ALIGN_FOR(7);
-                ALIGN_FOR(8);
-                ALIGN_FOR(9);
-                ALIGN_FOR(10);
-                ALIGN_FOR(11);
-                ALIGN_FOR(12);
-                ALIGN_FOR(13);
-                default:
-                    return func(std::allocator<align_type<4>>{});
-            }
-#undef ALIGN_FOR
-        }
-    public:
         value_type* allocate(std::size_t bytes)
         {
-            auto n = bytes >> alignment_p2;
-            assert(bytes == n << alignment_p2);
-            return switch_allocator([&](auto&& alloc)
-                                    {
-                                        return reinterpret_cast<value_type*>(alloc.allocate(n));
-                                    });
+            assert(bytes == (bytes >> alignment_p2) << alignment_p2);
+            return static_cast<value_type*>(m_resource->allocate(bytes, size_t(1) << alignment_p2));
         }
 
         void deallocate(value_type* ptr, std::size_t bytes)
         {
-            auto n = bytes >> alignment_p2;
-            assert(bytes == n << alignment_p2);
-            return switch_allocator([&](auto&& alloc)
-                                    {
-                                        using ptr_t = std::decay_t<decltype(alloc)>::value_type*;
-                                        alloc.deallocate((ptr_t) ptr, n);
-                                    });
+            assert(bytes == (bytes >> alignment_p2) << alignment_p2);
+            m_resource->deallocate(ptr, bytes, size_t(1) << alignment_p2);
         }
 
     };
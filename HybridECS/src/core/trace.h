@@ -0,0 +1,254 @@
+#pragma once
+
+//scoped trace points of the hot paths, written out as a chrome trace (chrome://tracing, ui.perfetto.dev)
+//compiled in with HYECS_TRACE, otherwise the macros expand to nothing and the arguments are not evaluated
+//
+//  HYECS_TRACE_SCOPE("name");                  //name must be a string literal
+//  HYECS_TRACE_SCOPE_COUNT("name", count);     //count is shown as the entities argument
+//  hyecs::trace::write_chrome_trace("frame.json");
+//
+//trace::enable_counters adds the hardware counters of core/perf_counters.h to the events, the counters cost two
+//syscalls per scope so they are for the coarse scopes of a profiling run
+
+#if defined(HYECS_TRACE)
+
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "perf_counters.h"
+
+namespace hyecs::trace
+{
+    struct event
+    {
+        static constexpr uint64_t no_count = ~uint64_t(0);
+
+        const char* name;
+        uint64_t begin_ns;
+        uint64_t end_ns;
+        uint64_t count;
+        perf::counter_values counters;
+    };
+
+    inline uint64_t now_ns()
+    {
+        static const auto epoch = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    //ring of the latest events of one thread, single producer single consumer
+    //the owning thread pushes, the flushing thread reads what was written since the last flush
+    //when the ring wraps the oldest events are lost, a flush per frame keeps them
+    class thread_buffer
+    {
+    public:
+        static constexpr size_t capacity = 1 << 16;
+
+    private:
+        std::unique_ptr<event[]> m_events;
+        std::atomic<uint64_t> m_written;
+        uint64_t m_flushed; //only touched by the flushing thread
+        uint32_t m_thread_index;
+        thread_buffer* m_next;
+
+        friend class collector;
+
+    public:
+        thread_buffer(uint32_t thread_index)
+            : m_events(std::make_unique<event[]>(capacity)), m_written(0), m_flushed(0),
+              m_thread_index(thread_index), m_next(nullptr)
+        {
+        }
+
+        void push(const event& e)
+        {
+            uint64_t index = m_written.load(std::memory_order_relaxed);
+            m_events[index & (capacity - 1)] = e;
+            m_written.store(index + 1, std::memory_order_release);
+        }
+
+        uint32_t thread_index() const { return m_thread_index; }
+
+        //appends the events written since the last call
+        void take(std::vector<event>& out)
+        {
+            uint64_t end = m_written.load(std::memory_order_acquire);
+            uint64_t begin = std::max(m_flushed, end > capacity ? end - capacity : 0);
+            size_t first = out.size();
+            for (uint64_t i = begin; i < end; i++)
+                out.push_back(m_events[i & (capacity - 1)]);
+            //drop the events the owner overwrote while they were copied
+            //a push in flight on index after is overwriting the slot of event after - capacity too
+            uint64_t after = m_written.load(std::memory_order_acquire);
+            if (after + 1 > capacity && after + 1 - capacity > begin)
+            {
+                size_t torn = std::min(after + 1 - capacity, end) - begin;
+                out.erase(out.begin() + first, out.begin() + first + torn);
+            }
+            m_flushed = end;
+        }
+    };
+
+    //owns the buffers of all threads that ever traced, a buffer outlives its thread until the process ends
+    class collector
+    {
+        std::atomic<thread_buffer*> m_head{nullptr};
+        std::atomic<uint32_t> m_thread_count{0};
+        std::atomic<bool> m_counters_enabled{false};
+
+        thread_buffer* register_thread()
+        {
+            auto buffer = new thread_buffer(m_thread_count.fetch_add(1, std::memory_order_relaxed));
+            thread_buffer* head = m_head.load(std::memory_order_relaxed);
+            do buffer->m_next = head;
+            while (!m_head.compare_exchange_weak(head, buffer, std::memory_order_release, std::memory_order_relaxed));
+            return buffer;
+        }
+
+    public:
+        ~collector()
+        {
+            thread_buffer* buffer = m_head.load(std::memory_order_acquire);
+            while (buffer)
+            {
+                thread_buffer* next = buffer->m_next;
+                delete buffer;
+                buffer = next;
+            }
+        }
+
+        static collector& instance()
+        {
+            static collector c;
+            return c;
+        }
+
+        thread_buffer& local_buffer()
+        {
+            thread_local thread_buffer* buffer = register_thread();
+            return *buffer;
+        }
+
+        bool counters_enabled() const { return m_counters_enabled.load(std::memory_order_relaxed); }
+        void set_counters_enabled(bool enabled) { m_counters_enabled.store(enabled, std::memory_order_relaxed); }
+
+        template<typename Func>
+        void for_each_buffer(Func&& func)
+        {
+            for (thread_buffer* buffer = m_head.load(std::memory_order_acquire); buffer; buffer = buffer->m_next)
+                func(*buffer);
+        }
+    };
+
+    class scope
+    {
+        const char* m_name;
+        uint64_t m_count;
+        uint64_t m_begin;
+        perf::counter_values m_begin_counters;
+
+    public:
+        scope(const char* name, uint64_t count = event::no_count)
+            : m_name(name), m_count(count)
+        {
+            if (collector::instance().counters_enabled()) m_begin_counters = perf::thread_counters().read();
+            m_begin = now_ns();
+        }
+
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+        ~scope()
+        {
+            uint64_t end = now_ns();
+            perf::counter_values counters;
+            if (!m_begin_counters.empty()) counters = perf::thread_counters().read() - m_begin_counters;
+            collector::instance().local_buffer().push({m_name, m_begin, end, m_count, counters});
+        }
+    };
+
+    //counts the hardware counters of the scopes opened afterwards, false if no counter is available on this thread
+    inline bool enable_counters(bool enabled = true)
+    {
+        bool available = perf::thread_counters().available();
+        collector::instance().set_counters_enabled(enabled && available);
+        return available;
+    }
+
+    //discards the events recorded so far
+    inline void clear()
+    {
+        std::vector<event> events;
+        collector::instance().for_each_buffer([&](thread_buffer& buffer)
+        {
+            events.clear();
+            buffer.take(events);
+        });
+    }
+
+    //writes the events recorded since the last flush as a chrome trace json
+    //call it while the traced threads are idle, e.g. between frames, so no event is lost to the ring
+    inline void write_chrome_trace(std::ostream& os)
+    {
+        std::string out = "{\"traceEvents\":[";
+        auto iter = std::back_inserter(out);
+        bool first = true;
+        std::vector<event> events;
+        collector::instance().for_each_buffer([&](thread_buffer& buffer)
+        {
+            events.clear();
+            buffer.take(events);
+            for (const auto& e: events)
+            {
+                if (!first) out += ',';
+                first = false;
+                std::format_to(iter, "{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":0,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}",
+                               e.name, buffer.thread_index(), double(e.begin_ns) / 1000.0,
+                               double(e.end_ns - e.begin_ns) / 1000.0);
+                if (e.count != event::no_count || !e.counters.empty())
+                {
+                    out += ",\"args\":{";
+                    bool first_arg = true;
+                    auto arg = [&](const char* name, uint64_t value)
+                    {
+                        std::format_to(iter, "{}\"{}\":{}", first_arg ? "" : ",", name, value);
+                        first_arg = false;
+                    };
+                    if (e.count != event::no_count) arg("entities", e.count);
+                    for (size_t i = 0; i < perf::counter_count; i++)
+                        if (e.counters.has(perf::counter(i))) arg(perf::counter_names[i], e.counters.values[i]);
+                    out += '}';
+                }
+                out += '}';
+            }
+        });
+        out += "]}";
+        os << out;
+    }
+
+    inline bool write_chrome_trace(const std::string& path)
+    {
+        std::ofstream file(path);
+        if (!file) return false;
+        write_chrome_trace(file);
+        return bool(file);
+    }
+}
+
+#define HYECS_TRACE_CONCAT_DIRECT(a, b) a##b
+#define HYECS_TRACE_CONCAT(a, b) HYECS_TRACE_CONCAT_DIRECT(a, b)
+#define HYECS_TRACE_SCOPE(name) ::hyecs::trace::scope HYECS_TRACE_CONCAT(_hyecs_trace_scope_, __COUNTER__)(name)
+#define HYECS_TRACE_SCOPE_COUNT(name, count) \
+    ::hyecs::trace::scope HYECS_TRACE_CONCAT(_hyecs_trace_scope_, __COUNTER__)(name, uint64_t(count))
+
+#else
+
+#define HYECS_TRACE_SCOPE(name)
+#define HYECS_TRACE_SCOPE_COUNT(name, count)
+
+#endif
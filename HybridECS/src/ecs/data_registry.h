@@ -3,9 +3,13 @@
 #include "ecs/registry/archetype_registry.h"
 #include "storage/archetype_storage.h"
 #include "storage/tag_archetype_storage.h"
+#include "storage/relation_storage.h"
 #include "ecs/query/query.h"
 #include "ecs/query/cross_query.h"
+#include "ecs/query/fused_systems.h"
 #include "ecs/query/query_parser.h"
+#include "ecs/query/system_access.h"
+#include "ecs/query/relation_query.h"
 #include "debug_util.h"
 
 namespace hyecs
@@ -14,12 +18,40 @@ namespace hyecs
     {
     };
 
-#define DEBUG_PRINT
+    //the memory resource of a registry, a base so the resource is bound before the registry members are constructed
+    //the containers of the registry take the resource when they are created and keep it, so the entry points that
+    //create storages or queries open memory_scope() and the growth of existing containers follows on its own
+    class registry_memory
+    {
+        std::pmr::memory_resource* m_memory_resource;
+
+    protected:
+        memory::resource_scope m_construction_scope; //restored at the end of the registry constructor
+
+        registry_memory(std::pmr::memory_resource* resource)
+            : m_memory_resource(resource ? resource : memory::current_resource()),
+              m_construction_scope(m_memory_resource)
+        {
+        }
+
+        //an explicit resource takes the chunk slabs too, so releasing it frees the whole registry
+        static chunk_arena::config arena_config_for(chunk_arena::config config, std::pmr::memory_resource* resource)
+        {
+            if (resource && !config.upstream) config.upstream = resource;
+            return config;
+        }
+
+    public:
+        std::pmr::memory_resource* memory_resource() const { return m_memory_resource; }
 
+        memory::resource_scope memory_scope() const { return memory::resource_scope(m_memory_resource); }
+    };
 
-    class data_registry
+    class data_registry : public registry_memory
     {
     public:
+        // chunk memory shared by all storages, destroyed last
+        chunk_arena m_chunk_arena;
         // type infos - longest life-time
         vaildref_map<uint64_t, component_type_info> m_component_type_infos;
         vaildref_map<component_group_id, component_group_info> m_component_group_infos;
@@ -28,8 +60,10 @@ namespace hyecs
         // storages
         storage_key_registry m_storage_key_registry;
         vaildref_map<uint64_t, component_storage> m_component_storages;
+        vector<component_storage*> m_component_storage_table; // indexed by component id, null for empty components
         vaildref_map<uint64_t, archetype_storage> m_archetypes_storage;
         vaildref_map<uint64_t, tag_archetype_storage> m_tag_archetypes_storage;
+        vaildref_map<uint64_t, relation_storage> m_relation_storages; // by relation type, created on first use
         // query
         //        vaildref_map<uint64_t,
         vaildref_map<uint64_t, query> m_queries;
@@ -37,6 +71,15 @@ namespace hyecs
         vaildref_map<uint64_t, table_tag_query> m_table_queries;
         // entity
         dense_set<entity> m_entities;
+        // chunk sizing, applied to archetypes created afterwards
+        chunk_size_policy m_chunk_size_policy;
+        unordered_map<component_group_id, chunk_size_policy> m_group_chunk_size_policies;
+        // layout policy, applied to archetypes created afterwards
+        storage_policy m_storage_policy;
+        unordered_map<component_group_id, storage_policy> m_group_storage_policies;
+        // storages with a conversion in progress, advanced by step_storage_conversion
+        vector<archetype_storage*> m_converting_storages;
+        bool m_incremental_storage_conversion = false;
 
         class entity_allocator
         {
@@ -84,7 +127,7 @@ namespace hyecs
             }
         }
 
-        void deallocate_entity(sequence_ref<entity> entities)
+        void deallocate_entity(sequence_cref<entity> entities)
         {
             for (uint32_t i = 0; i < entities.size(); i++)
             {
@@ -96,31 +139,36 @@ namespace hyecs
 
         void add_untag_archetype(archetype_index arch)
         {
-#if defined(DEBUG_PRINT)
-            scope_output_color c(scope_output_color::cyan);
-#endif
+            HYECS_TRACE_SCOPE("data_registry::add_untag_archetype");
             assert(!m_archetypes_storage.contains(arch.hash()));
             vector<component_storage*> storages;
             storages.reserve(arch.component_count());
             for (auto& component: arch)
             {
                 if (!component.is_empty())
-                    storages.push_back(&m_component_storages.at(component.hash()));
+                    storages.push_back(&get_component_storage(component));
             }
+            size_t row_size = sizeof(entity);
+            for (auto storage: storages)
+                row_size += storage->component_type().size();
+            size_t chunk_size = get_chunk_size_policy(arch.group().id()).chunk_size(row_size);
             //todo process for single component arch
-            m_archetypes_storage.emplace_value(arch.hash(), arch,
-                                               sorted_sequence_cref(storages),
-                                               m_storage_key_registry.get_group_key_accessor());
-#if defined(DEBUG_PRINT)
-            printf("add untag archetype %s\n", to_string(arch).c_str());
-#endif
+            archetype_storage& storage = m_archetypes_storage.emplace_value(arch.hash(), arch,
+                                                                            sorted_sequence_cref(storages),
+                                                                            m_storage_key_registry.get_group_key_accessor(),
+                                                                            chunk_size,
+                                                                            &m_chunk_arena);
+            storage.set_incremental_conversion(m_incremental_storage_conversion);
+            storage.set_storage_policy(get_storage_policy(arch.group().id()));
+            storage.add_callback_on_conversion_begin([this, storage_ptr = &storage]()
+            {
+                m_converting_storages.push_back(storage_ptr);
+            });
         }
 
         void add_tag_archetype(archetype_index arch, archetype_index base_arch)
         {
-#if defined(DEBUG_PRINT)
-            scope_output_color c(scope_output_color::cyan);
-#endif
+            HYECS_TRACE_SCOPE("data_registry::add_tag_archetype");
             assert(!m_tag_archetypes_storage.contains(arch.hash()));
             assert(m_archetypes_storage.contains(base_arch.hash()));
             archetype_storage* base_storage = &m_archetypes_storage.at(base_arch.hash());
@@ -128,19 +176,14 @@ namespace hyecs
             for (auto& component: arch)
             {
                 if (component.is_tag() && !component.is_empty())
-                    tag_storages.push_back(&m_component_storages.at(component.hash()));
+                    tag_storages.push_back(&get_component_storage(component));
             }
             m_tag_archetypes_storage.emplace_value(arch.hash(), arch, base_storage, sorted_sequence_cref(tag_storages));
-#if defined(DEBUG_PRINT)
-            printf("add tag archetype %s\n", to_string(arch).c_str());
-#endif
         }
 
         void add_table_query(const archetype_registry::archetype_query_addition_info& info)
         {
-#if defined(DEBUG_PRINT)
-            scope_output_color c(scope_output_color::green);
-#endif
+            HYECS_TRACE_SCOPE("data_registry::add_table_query");
             auto& [
                 query_index,
                 base_archetype_index,
@@ -158,7 +201,7 @@ namespace hyecs
             {
                 assert(component.is_tag());
                 if (!component.is_empty())
-                    tag_storages.push_back(&m_component_storages.at(component.hash()));
+                    tag_storages.push_back(&get_component_storage(component));
             }
             table_tag_query& table_query = m_table_queries.emplace_value(
                 query_index, base_storage, tag_storages, is_full_set, is_direct_set ASSERTION_CODE(, tag_condition));
@@ -171,59 +214,183 @@ namespace hyecs
             {
                 table_query.notify_partial_convert();
             };
-#if defined(DEBUG_PRINT)
-            printf("add table query [%s] + %s", to_string(base_archetype_index).c_str(), to_string(tag_condition).c_str());
-            if (is_full_set)
-                if (is_direct_set) printf(" direct set");
-                else printf(" full set");
-            else printf(" partial set");
-
-            printf("\n");
-#endif
         }
 
         void add_query(const archetype_registry::query_addition_info& info)
         {
-#if defined(DEBUG_PRINT)
-            scope_output_color c(scope_output_color::yellow);
-#endif
+            HYECS_TRACE_SCOPE("data_registry::add_query");
             assert(!m_queries.contains(info.index));
             query& q = m_queries.emplace_value(info.index, info.condition);
             info.archetype_query_addition_callback = [this, &q](query_index table_query_index)
             {
                 table_tag_query* table_query = &m_table_queries.at(table_query_index);
                 q.notify_table_query_add(table_query);
-#if defined(DEBUG_PRINT)
-                printf("query::%s add table query [%s] %s\n",
-                    to_string(q.condition_debug()).c_str(),
-                    to_string(table_query->base_archetype()).c_str(),
-                    to_string(table_query->tag_condition()).c_str());
-#endif
             };
-#if defined(DEBUG_PRINT)
-            printf("add query %s\n", to_string(info.condition).c_str());
-#endif
         }
 
         component_group_info& register_component_group(component_group_id id, std::string name)
         {
+            auto memory_bound = memory_scope();
             return m_component_group_infos.emplace(id, component_group_info{id, name, {}});
         }
 
         component_type_index register_component_type(generic::type_index type, component_group_info& group, bool is_tag)
         {
+            auto memory_bound = memory_scope();
             component_type_index component_index = m_component_type_infos.emplace(type.hash(), component_type_info(type, group, is_tag));
 
             group.component_types.push_back(component_index);
             m_archetype_registry.register_component(component_index);
             if (!type.is_empty())
-                m_component_storages.emplace_value(type.hash(), component_index);
+            {
+                component_storage& storage = m_component_storages.emplace_value(type.hash(), component_index, &m_chunk_arena);
+                if (component_index.id() >= m_component_storage_table.size())
+                    m_component_storage_table.resize(component_index.id() + 1, nullptr);
+                m_component_storage_table[component_index.id()] = &storage;
+            }
             return component_index;
         }
 
+        void set_chunk_size_policy(const chunk_size_policy& policy)
+        {
+            m_chunk_size_policy = policy;
+        }
+
+        void set_chunk_size_policy(component_group_id group, const chunk_size_policy& policy)
+        {
+            auto memory_bound = memory_scope();
+            m_group_chunk_size_policies[group] = policy;
+        }
+
+        const chunk_size_policy& get_chunk_size_policy(component_group_id group) const
+        {
+            if (auto iter = m_group_chunk_size_policies.find(group); iter != m_group_chunk_size_policies.end())
+                return iter->second;
+            return m_chunk_size_policy;
+        }
+
+        //sparse/chunk layout selection, see storage_policy::threshold and storage_policy::adaptive
+        void set_storage_policy(const storage_policy& policy)
+        {
+            m_storage_policy = policy;
+            for (auto [_, storage]: m_archetypes_storage)
+                if (!m_group_storage_policies.contains(storage.archetype().group().id()))
+                    storage.set_storage_policy(policy);
+        }
+
+        void set_storage_policy(component_group_id group, const storage_policy& policy)
+        {
+            auto memory_bound = memory_scope();
+            m_group_storage_policies[group] = policy;
+            for (auto [_, storage]: m_archetypes_storage)
+                if (storage.archetype().group().id() == group)
+                    storage.set_storage_policy(policy);
+        }
+
+        const storage_policy& get_storage_policy(component_group_id group) const
+        {
+            if (auto iter = m_group_storage_policies.find(group); iter != m_group_storage_policies.end())
+                return iter->second;
+            return m_storage_policy;
+        }
+
+        //when enabled, crossing the sparse to chunk threshold starts a conversion
+        //that is spread over step_storage_conversion calls instead of moving all entities at once
+        void set_incremental_storage_conversion(bool incremental)
+        {
+            m_incremental_storage_conversion = incremental;
+            for (auto [_, storage]: m_archetypes_storage)
+                storage.set_incremental_conversion(incremental);
+        }
+
+        //migrate at most entity_budget entities of the converting storages, call once per frame
+        //returns the number of migrated entities
+        size_t step_storage_conversion(size_t entity_budget)
+        {
+            auto memory_bound = memory_scope();
+            size_t migrated = 0;
+            while (!m_converting_storages.empty() && migrated < entity_budget)
+            {
+                archetype_storage* storage = m_converting_storages.back();
+                migrated += storage->step_conversion(entity_budget - migrated);
+                if (!storage->is_converting())
+                    m_converting_storages.pop_back();
+            }
+            return migrated;
+        }
+
+        //compact the fragmented tables until the time budget is used, call once per frame
+        //returns the number of rows moved between chunks
+        size_t compact_storages(std::chrono::nanoseconds budget, size_t batch_rows = 1024)
+        {
+            auto memory_bound = memory_scope();
+            const auto deadline = std::chrono::steady_clock::now() + budget;
+            size_t moved = 0;
+            for (auto [_, storage]: m_archetypes_storage)
+            {
+                while (!storage.is_compact() && !storage.is_converting())
+                {
+                    moved += storage.compact(batch_rows);
+                    if (std::chrono::steady_clock::now() >= deadline) return moved;
+                }
+            }
+            return moved;
+        }
+
+        bool has_pending_storage_conversion() const
+        {
+            return !m_converting_storages.empty();
+        }
+
+        //walks every storage and query, meant for periodic tracking rather than per frame
+        registry_memory_report memory_report()
+        {
+            registry_memory_report report;
+            report.entity_count = m_entities.size();
+            report.entity_set_bytes = m_entities.memory_usage();
+            report.storage_key_count = m_storage_key_registry.key_count();
+            report.storage_key_bytes = m_storage_key_registry.memory_usage();
+            report.arena_allocated_bytes = m_chunk_arena.allocated_bytes();
+            report.arena_reserved_bytes = m_chunk_arena.reserved_bytes();
+            report.arena_slab_count = m_chunk_arena.slab_count();
+
+            for (auto [_, storage]: m_archetypes_storage)
+            {
+                auto& info = report.archetypes.emplace_back(storage.memory_info());
+                info.name = to_string(storage.archetype());
+            }
+            for (auto [_, storage]: m_tag_archetypes_storage)
+            {
+                auto& info = report.tag_archetypes.emplace_back(storage.memory_info());
+                info.name = to_string(storage.archetype());
+            }
+            for (auto [_, storage]: m_component_storages)
+            {
+                auto& info = report.component_storages.emplace_back(storage.memory_info());
+                info.name = to_string(storage.component_type());
+            }
+            auto add_queries = [&](auto& queries)
+            {
+                for (auto [id, q]: queries)
+                    report.queries.emplace_back(q.memory_info()).id = id;
+            };
+            add_queries(m_queries);
+            add_queries(m_table_queries);
+            add_queries(m_cross_queries);
+            return report;
+        }
+
+        component_storage& get_component_storage(component_type_index component)
+        {
+            assert(component.id() < m_component_storage_table.size());
+            assert(m_component_storage_table[component.id()] != nullptr);
+            return *m_component_storage_table[component.id()];
+        }
+
     public:
         void register_type(const ecs_rtti_context& context)
         {
+            auto memory_bound = memory_scope();
             for (auto& [_, group]: context.groups())
             {
                 component_group_info& group_info = register_component_group(group.id, group.name);
@@ -235,7 +402,12 @@ namespace hyecs
             }
         }
 
-        data_registry()
+        //the containers and the chunks of the registry allocate from resource, the current resource of the thread when null
+        //a std::pmr::monotonic_buffer_resource per registry gives worlds with separate arenas, released at once
+        //after the registry is destroyed, the resource must outlive the registry
+        data_registry(chunk_arena::config arena_config = {}, std::pmr::memory_resource* resource = nullptr)
+            : registry_memory(resource),
+              m_chunk_arena(arena_config_for(arena_config, resource))
         {
             m_archetype_registry.bind_untag_archetype_addition_callback(
                 [this](archetype_index arch)
@@ -263,9 +435,12 @@ namespace hyecs
                     return add_query(info);
                 }
             );
+            m_construction_scope.restore();
         }
 
-        data_registry(const ecs_rtti_context& context) : data_registry()
+        data_registry(const ecs_rtti_context& context, chunk_arena::config arena_config = {},
+                      std::pmr::memory_resource* resource = nullptr)
+            : data_registry(arena_config, resource)
         {
             register_type(context);
         }
@@ -277,6 +452,7 @@ namespace hyecs
             sorted_sequence_cref<generic::constructor> constructors,
             sequence_ref<entity> entities)
         {
+            auto memory_bound = memory_scope();
             assert(components.size() == constructors.size());
             auto group_begin = components.begin();
             auto group_end = components.begin();
@@ -309,6 +485,7 @@ namespace hyecs
                               sequence_cref<entity> entities,
                               sorted_sequence_cref<generic::constructor> constructors)
         {
+            auto memory_bound = memory_scope();
             //fixme: needed this? this cause single component query not working
             // if (arch.component_count() == 1)
             // {
@@ -351,6 +528,88 @@ namespace hyecs
             }
         }
 
+        //destroys entities that were emplaced with the same components, the counterpart of emplace
+        //the entities are removed from each group archetype and their ids are freed
+        void destroy(sorted_sequence_cref<component_type_index> components, sequence_cref<entity> entities)
+        {
+            auto memory_bound = memory_scope();
+            auto group_begin = components.begin();
+            auto group_end = components.begin();
+
+            while (group_begin != components.end())
+            {
+                group_end = [&]()
+                {
+                    auto it = group_begin;
+                    auto g = group_begin->group();
+                    while (it != components.end() && it->group() == g)
+                        ++it;
+                    return it;
+                }();
+
+                archetype_index arch = m_archetype_registry.get_archetype(append_component(group_begin, group_end));
+                if (arch.is_tag())
+                    m_tag_archetypes_storage.at(arch.hash()).destroy_entities(entities);
+                else
+                    m_archetypes_storage.at(arch.hash()).destroy_entities(entities);
+
+                group_begin = group_end;
+            }
+
+            //the relations do not outlive their entities
+            for (auto [_, relations]: m_relation_storages)
+                relations.remove_entities(entities);
+
+            deallocate_entity(entities);
+        }
+
+        //the pairs of a relation type, the relation type is a component registered in its group
+        relation_storage& get_relation_storage(component_type_index relation_type)
+        {
+            auto memory_bound = memory_scope();
+            if (m_relation_storages.contains(relation_type.hash()))
+                return m_relation_storages.at(relation_type.hash());
+            return m_relation_storages.emplace_value(relation_type.hash(), relation_type);
+        }
+
+        //the relation edits are applied at the next query of the relation
+        void add_relation(component_type_index relation_type, entity source, entity target)
+        {
+            assert(m_entities.contains(source) && m_entities.contains(target));
+            get_relation_storage(relation_type).add(source, target);
+        }
+
+        void remove_relation(component_type_index relation_type, entity source, entity target)
+        {
+            get_relation_storage(relation_type).remove(source, target);
+        }
+
+        template<typename Relation>
+        void add_relation(entity source, entity target)
+        {
+            add_relation(get_component_index(type_hash::of<Relation>()), source, target);
+        }
+
+        template<typename Relation>
+        void remove_relation(entity source, entity target)
+        {
+            remove_relation(get_component_index(type_hash::of<Relation>()), source, target);
+        }
+
+        template<typename Relation>
+        sequence_cref<entity> relation_targets(entity source)
+        {
+            auto memory_bound = memory_scope();
+            return get_relation_storage(get_component_index(type_hash::of<Relation>())).targets_of(source);
+        }
+
+        template<typename Relation>
+        sequence_cref<entity> relation_sources(entity target)
+        {
+            auto memory_bound = memory_scope();
+            return get_relation_storage(get_component_index(type_hash::of<Relation>())).sources_of(target);
+        }
+
         template<typename... T>
         void emplace_(
             sequence_ref<entity> entities,
@@ -393,22 +652,25 @@ namespace hyecs
 
         auto& get_query(const query_condition& condition)
         {
+            auto memory_bound = memory_scope();
             const query_index index = m_archetype_registry.get_query(condition);
             return m_queries.at(index);
         }
 
         auto& get_cross_query(const query_condition& condition)
         {
-            vector<component_type_index> cond_all(condition.all().begin(), condition.all().end());
-            vector<component_type_index> cond_none(condition.none().begin(), condition.none().end());
+            auto memory_bound = memory_scope();
+            memory::frame_scope frame;
+            memory::frame_vector<component_type_index> cond_all(condition.all().begin(), condition.all().end());
+            memory::frame_vector<component_type_index> cond_none(condition.none().begin(), condition.none().end());
             //assert if cond_all and cond_none is sorted
             assert(std::ranges::is_sorted(cond_all));
             assert(std::ranges::is_sorted(cond_none));
             std::ranges::sort(cond_all);
             std::ranges::sort(cond_none);
-            vector<component_group_id> groups;
-            vector<uint32_t> all_group_range = {0};
-            vector<uint32_t> none_group_range = {0};
+            memory::frame_vector<component_group_id> groups;
+            memory::frame_vector<uint32_t> all_group_range = {0};
+            memory::frame_vector<uint32_t> none_group_range = {0};
             //the all cond defines the groups
             //that is each group must have a all condition
             assert(cond_all.size() != 0);
@@ -481,7 +743,7 @@ namespace hyecs
             };
 
             auto q_hash = condition.hash();
-            vector<query*> in_group_queries;
+            memory::frame_vector<query*> in_group_queries;
             in_group_queries.reserve(groups.size());
 
             for (auto [g_idx,group_id]: groups | std::ranges::views::enumerate)
@@ -598,17 +860,19 @@ namespace hyecs
                 auto st_key = iter->second;
                 //todo build the fast table
                 auto* table = m_storage_key_registry.find_table(st_key.get_table_index());
-                small_vector<uint32_t> indices(untagged_components.size(), uint32_t(-1));
+                table->record_random_access();
+                access_buffer<uint32_t> indices(untagged_components.size(), uint32_t(-1));
                 //todo check overload function call
                 table->get_component_indices(untagged_components, indices);
                 table->components_addresses(st_key, indices, addresses.sub_sequence(0, tagged_begin));
             }
             else
             {
+                m_storage_key_registry.record_sparse_random_access(e);
                 for (uint32_t i = 0; i < untagged_components.size(); ++i)
                 {
                     auto component_index = untagged_components[i];
-                    void* addr = m_component_storages.at(component_index.hash()).at(e);
+                    void* addr = get_component_storage(component_index).at(e);
                     addresses[i] = addr;
                 }
             }
@@ -616,11 +880,89 @@ namespace hyecs
             for (uint32_t i = 0; i < tagged_components.size(); ++i)
             {
                 auto component_index = tagged_components[i];
-                void* addr = m_component_storages.at(component_index.hash()).at(e);
+                void* addr = get_component_storage(component_index).at(e);
                 addresses[tagged_begin + i] = addr;
             }
         }
 
+        //the addresses of the components of many entities, components.size() addresses per entity in the order
+        //of components, null for the components an entity does not have
+        //the entities are visited by storage key, so the entities of a table share the component lookup and
+        //are read in the order of the rows
+        void batch_component_random_access(sequence_cref<entity> entities,
+                                           sequence_cref<component_type_index> components,
+                                           sequence_ref<void*> addresses)
+        {
+            assert(addresses.size() == entities.size() * components.size());
+            const size_t stride = components.size();
+            memory::frame_scope frame;
+            memory::frame_vector<uint32_t> untagged;
+            memory::frame_vector<component_type_index> untagged_components;
+            for (uint32_t i = 0; i < components.size(); i++)
+            {
+                if (components[i].is_tag()) continue;
+                untagged.push_back(i);
+                untagged_components.push_back(components[i]);
+            }
+
+            //(table key, entity index), the entities without a storage key last
+            memory::frame_vector<std::pair<uint64_t, uint32_t>> order;
+            memory::frame_vector<storage_key> keys(entities.size());
+            order.reserve(entities.size());
+            for (uint32_t i = 0; i < entities.size(); i++)
+            {
+                uint64_t table_key = std::numeric_limits<uint64_t>::max();
+                if (auto iter = m_storage_key_registry.find(entities[i]); iter != m_storage_key_registry.end())
+                {
+                    keys[i] = iter->second;
+                    table_key = uint64_t(keys[i].get_table_index().table_index()) << 32 |
+                                uint32_t(keys[i].get_table_offset());
+                }
+                order.emplace_back(table_key, i);
+            }
+            std::ranges::sort(order);
+
+            memory::frame_vector<uint32_t> indices(untagged.size());
+            memory::frame_vector<void*> table_addresses(untagged.size());
+            table* current_table = nullptr;
+            for (auto [table_key, entity_i]: order)
+            {
+                auto* row = addresses.begin() + size_t(entity_i) * stride;
+                entity e = entities[entity_i];
+                if (table_key != std::numeric_limits<uint64_t>::max())
+                {
+                    auto st_key = keys[entity_i];
+                    auto* table = m_storage_key_registry.find_table(st_key.get_table_index());
+                    if (table != current_table)
+                    {
+                        current_table = table;
+                        std::ranges::fill(indices, absent_component_index);
+                        table->get_component_indices(sequence_cref<component_type_index>(untagged_components),
+                                                     sequence_ref<uint32_t>(indices));
+                    }
+                    table->record_random_access();
+                    table->components_addresses(st_key, indices, table_addresses);
+                    for (uint32_t i = 0; i < untagged.size(); i++)
+                        row[untagged[i]] = table_addresses[i];
+                }
+                else
+                {
+                    m_storage_key_registry.record_sparse_random_access(e);
+                    for (uint32_t i = 0; i < untagged.size(); i++)
+                    {
+                        auto& storage = get_component_storage(untagged_components[i]);
+                        row[untagged[i]] = storage.contains(e) ? storage.at(e) : nullptr;
+                    }
+                }
+                for (uint32_t i = 0; i < stride; i++)
+                {
+                    if (!components[i].is_tag()) continue;
+                    auto& storage = get_component_storage(components[i]);
+                    row[i] = storage.contains(e) ? storage.at(e) : nullptr;
+                }
+            }
+        }
+
     private:
 #pragma region cross_query code
 
@@ -631,12 +973,12 @@ namespace hyecs
 
 #pragma region cross_query code
 
-    inline void cross_query::dynamic_for_each(
-        const access_info& acc_info,
-        function<void(entity, sequence_ref<void*>)> func)
+    template<typename Callable>
+    void cross_query::dynamic_for_each(const access_info& acc_info, Callable&& func)
     {
-        small_vector<void*> addresses_cache(acc_info.access_list.size());
-        small_vector<void*> addresses(acc_info.access_list.size());
+        access_buffer<void*> addresses_cache(acc_info.access_list.size());
+        access_buffer<void*> access_order_cache(acc_info.access_list.size());
+        sequence_ref<void*> addresses(access_order_cache);
         auto& sorted_components = acc_info.sorted_components;
         auto& group_division = acc_info.group_division;
 
@@ -657,6 +999,7 @@ namespace hyecs
                 {
                     auto st_key = iter->second;
                     auto* table = m_data_registry->m_storage_key_registry.find_table(st_key.get_table_index());
+                    table->record_random_access();
                     //base part
 
                     auto all_indices = table->get_all_component_indices();
@@ -682,10 +1025,11 @@ namespace hyecs
                 }
                 else
                 {
+                    m_data_registry->m_storage_key_registry.record_sparse_random_access(e);
                     for (; comp_begin != tag_begin; ++comp_begin, ++comp_begin_idx)
                     {
                         assert(!comp_begin->is_tag());
-                        addresses_cache[comp_begin_idx] = m_data_registry->m_component_storages.at(comp_begin->hash()).at(e);
+                        addresses_cache[comp_begin_idx] = m_data_registry->get_component_storage(*comp_begin).at(e);
                     }
                 }
 
@@ -693,7 +1037,7 @@ namespace hyecs
                 for (; tag_begin != comp_end; ++tag_begin, ++tag_begin_idx)
                 {
                     assert(tag_begin->is_tag());
-                    addresses_cache[tag_begin_idx] = m_data_registry->m_component_storages.at(tag_begin->hash()).at(e);
+                    addresses_cache[tag_begin_idx] = m_data_registry->get_component_storage(*tag_begin).at(e);
                 }
             }
 
@@ -710,6 +1054,76 @@ namespace hyecs
 #pragma endregion
 
 
+    //a system made from a callable by executer_builder::register_executer
+    //the query and the access of the callable are resolved at registration, a call runs the typed for_each
+    //over the query without hash lookups, sorting or map lookups
+    //the components of the relation targets are resolved at the start of a call, a batch per relation
+    template<typename Callable>
+    class executer
+    {
+        template<typename T>
+        struct is_relation_scope_param
+        {
+            static constexpr bool value =
+                    std::is_base_of_v<query_parameter::relation_param, T> ||
+                    std::is_base_of_v<query_parameter::begin_rel_scope_param, T> ||
+                    std::is_base_of_v<query_parameter::relation_ref_param, T> ||
+                    std::is_same_v<T, query_parameter::end_rel_scope>;
+        };
+
+        using params = typename function_traits<Callable>::args;
+        using row_params = typename params::template filter_without<is_embedded_relation_param>;
+        static constexpr bool has_relation = row_params::size != params::size;
+
+        Callable m_callable;
+        data_registry* m_registry;
+        query* m_query;
+        const query::access_info* m_access_info;
+        system_access m_access;
+        vector<relation_binding> m_relations; //in parameter order
+
+        void resolve_relation(relation_binding& relation)
+        {
+            relation.storage->update();
+            auto targets = relation.storage->targets();
+            relation.target_addresses.resize(targets.size() * relation.access_list.size());
+            m_registry->batch_component_random_access(targets,
+                                                      sequence_cref<component_type_index>(relation.access_list),
+                                                      sequence_ref<void*>(relation.target_addresses));
+            relation.match();
+        }
+
+    public:
+        executer(Callable callable, data_registry& registry, query& q, const query::access_info& access_info,
+                 system_access access, vector<relation_binding> relations = {})
+            : m_callable(std::move(callable)), m_registry(&registry), m_query(&q), m_access_info(&access_info),
+              m_access(std::move(access)), m_relations(std::move(relations))
+        {
+        }
+
+        query& get_query() const { return *m_query; }
+
+        const system_access& access() const { return m_access; }
+
+        void operator()()
+        {
+            static_assert(params::template filter_with<is_relation_scope_param>::size == 0,
+                          "named relation scopes are not supported by executer");
+            if constexpr (!has_relation)
+            {
+                m_query->for_each(m_callable, *m_access_info);
+            }
+            else
+            {
+                auto memory_bound = m_registry->memory_scope();
+                for (auto& relation: m_relations)
+                    resolve_relation(relation);
+                relation_row_invoker<Callable, row_params> invoker(m_callable, m_relations.data());
+                m_query->for_each(invoker, *m_access_info);
+            }
+        }
+    };
+
     class executer_builder
     {
         template<typename T>
@@ -720,79 +1134,152 @@ namespace hyecs
 
         data_registry& m_registry;
 
+        template<typename Hashes>
+        vector<component_type_index> sorted_component_indices(const Hashes& hashes)
+        {
+            vector<component_type_index> indices;
+            indices.reserve(hashes.size());
+            for (auto hash: hashes)
+                indices.push_back(m_registry.get_component_index(hash));
+            std::ranges::sort(indices);
+            //all_of may repeat an accessed component
+            indices.erase(std::ranges::unique(indices).begin(), indices.end());
+            return indices;
+        }
+
+        void add_access(system_access& access, const query_descriptor::entity_access_info& scope)
+        {
+            auto add = [&](const query_descriptor::access_info& info)
+            {
+                auto component = m_registry.get_component_index(info.hash);
+                if (info.read_write != query_descriptor::access_info::wo) access.reads.push_back(component);
+                if (info.read_write != query_descriptor::access_info::ro) access.writes.push_back(component);
+            };
+            for (auto& info: scope.access_components) add(info);
+            for (auto& info: scope.optional_access_components) add(info);
+            for (auto& variant: scope.variant_access_components)
+                for (auto& info: variant.access_components) add(info);
+        }
+
+        system_access resolve_access(const query_descriptor& descriptor)
+        {
+            system_access access;
+            const auto& scope = descriptor.multi_access_info[0];
+            add_access(access, scope);
+            for (auto& reference: scope.relation_references)
+            {
+                //the system reads the pairs of the relation and the components of the targets
+                access.reads.push_back(m_registry.get_component_index(reference.tag_hash));
+                add_access(access, descriptor.multi_access_info[reference.scope_index]);
+            }
+            for (auto* list: {&access.reads, &access.writes})
+            {
+                std::ranges::sort(*list);
+                list->erase(std::ranges::unique(*list).begin(), list->end());
+            }
+            return access;
+        }
+
+        //the relation parameters of the root scope, relation<Tag(...)> and multi_relation<Tag(...)>
+        vector<relation_binding> resolve_relations(const query_descriptor& descriptor)
+        {
+            const auto& scope = descriptor.multi_access_info[0];
+            vector<relation_binding> relations;
+            relations.reserve(scope.relation_references.size());
+            for (auto& reference: scope.relation_references)
+            {
+                assert(reference.category == query_descriptor::relation_category::single_embedded ||
+                       reference.category == query_descriptor::relation_category::multi_embedded);
+                const auto& target = descriptor.multi_access_info[reference.scope_index];
+                //the targets are matched by their components only
+                assert(target.optional_access_components.empty() && target.variant_access_components.empty());
+                assert(target.relation_references.empty());
+                auto& relation = relations.emplace_back();
+                relation.storage = &m_registry.get_relation_storage(m_registry.get_component_index(reference.tag_hash));
+                relation.access_list.reserve(target.access_components.size());
+                for (auto& info: target.access_components)
+                    relation.access_list.push_back(m_registry.get_component_index(info.hash));
+                //a target is resolved with the storage key of its group
+                ASSERTION_CODE(
+                    for (auto comp: relation.access_list)
+                        assert(comp.group().id() == relation.access_list.front().group().id());
+                );
+            }
+            //the references are added as the parameters are parsed, so the bindings follow the order of the
+            //parameters, as the row invoker takes them
+            return relations;
+        }
+
     public:
         executer_builder(data_registry& registry) : m_registry(registry)
         {
         }
 
+        //the parameters of the callable are static components, write<T>, optional<T>, variant<T...>, all_of, any_of,
+        //none_of, entity and storage_key, an optional component is null on the rows whose archetype does not have it,
+        //a variant holds the first of its components the archetype has, both are resolved once per archetype
+        //so their components can not be tags
+        //relation<Tag(T...)> gives a target of the relation Tag of the row with the components T..., the rows with
+        //none are skipped, multi_relation<Tag(T...)> gives all of them
         template<typename Callable>
         auto register_executer(Callable&& callable)
         {
-            using params = typename function_traits<std::decay_t<Callable> >::args;
+            using callable_type = std::decay_t<Callable>;
+            using params = typename function_traits<callable_type>::args;
 
             auto descriptor = query_descriptor(params{});
+            //the root scope defines the query, the relation scopes are not resolved here
+            const auto& scope = descriptor.multi_access_info[0];
+
+            vector<component_type_index> cond_all = sorted_component_indices(scope.cond_all);
+            vector<component_type_index> cond_none = sorted_component_indices(scope.cond_none);
+            vector<vector<component_type_index>> cond_anys;
+            cond_anys.reserve(scope.cond_anys.size());
+            for (auto& any: scope.cond_anys)
+                cond_anys.push_back(sorted_component_indices(any));
+
+            //the query of an executer is an in-group query
+            assert(!cond_all.empty());
+            ASSERTION_CODE(
+                auto group = cond_all.front().group().id();
+                for (auto comp: cond_all) assert(comp.group().id() == group);
+                for (auto comp: cond_none) assert(comp.group().id() == group);
+                for (auto& any: cond_anys)
+                    for (auto comp: any) assert(comp.group().id() == group);
+            );
+
+            //the access list follows the order of the accessed parameters, as the invoker indexes them,
+            //a variant takes an entry per alternative
+            memory::frame_scope frame;
+            memory::frame_vector<std::pair<uint32_t, type_hash>> accessed;
+            accessed.reserve(scope.access_components.size() + scope.optional_access_components.size());
+            for (auto& info: scope.access_components)
+                accessed.emplace_back(info.param_index, info.hash);
+            for (auto& info: scope.optional_access_components)
+                accessed.emplace_back(info.param_index, info.hash);
+            for (auto& variant: scope.variant_access_components)
+                for (auto& info: variant.access_components)
+                    accessed.emplace_back(variant.param_index, info.hash);
+            std::ranges::stable_sort(accessed, {}, &std::pair<uint32_t, type_hash>::first);
+            memory::frame_vector<component_type_index> access_list;
+            access_list.reserve(accessed.size());
+            for (auto [_, hash]: accessed)
+                access_list.push_back(m_registry.get_component_index(hash));
+            //the tags of a table query vary per entity, optional and variant components are resolved per storage
+            ASSERTION_CODE(
+                for (auto& info: scope.optional_access_components)
+                    assert(!m_registry.get_component_index(info.hash).is_tag());
+                for (auto& variant: scope.variant_access_components)
+                    for (auto& info: variant.access_components)
+                        assert(!m_registry.get_component_index(info.hash).is_tag());
+            );
 
-            //todo scoped description formation
-            //			small_vector<component_type_index> cond_all;
-            //			small_vector<component_type_index> cond_none;
-            //			small_vector<small_vector<component_type_index>> cond_anys;
-            //			cond_all.reserve(descriptor.cond_all.size());
-            //			cond_none.reserve(descriptor.cond_none.size());
-            //			cond_anys.reserve(descriptor.cond_anys.size());
-            //
-            //			std::ranges::sort(descriptor.cond_all);
-            //			std::ranges::sort(descriptor.cond_none);
-            //
-            //			for (auto hash : descriptor.cond_all)
-            //				cond_all.push_back(m_registry.get_component_index(hash));
-            //			for (auto hash : descriptor.cond_none)
-            //				cond_none.push_back(m_registry.get_component_index(hash));
-            //			for (auto& vec : descriptor.cond_anys)
-            //			{
-            //				auto& cond_any = cond_anys.emplace_back();
-            //				cond_any.reserve(vec.size());
-            //				for (auto hash : vec)
-            //					cond_any.push_back(m_registry.get_component_index(hash));
-            //			}
-            //
-            //			//todo enhance the assertion
-            //			ASSERTION_CODE(
-            //
-            //				auto is_unique = [](auto& sorted_range)->bool {
-            //				if (sorted_range.size() <= 1) return true;
-            //				for (int i = 1; i < sorted_range.size(); ++i)
-            //					if (sorted_range[i] == sorted_range[i - 1])
-            //						return false;
-            //				return true;
-            //				};
-            //
-            //				assert(is_unique(descriptor.cond_all));
-            //				assert(is_unique(descriptor.cond_none));
-            //				for (auto& vec : descriptor.cond_anys)
-            //					assert(is_unique(vec));
-            //
-            //				);
-            //
-            //
-            //
-            //
-            //
-            //			query_condition cond(cond_all, cond_anys, cond_none);
-            //
-            //
-            //			const auto& q = m_registry.get_query(cond);
-            //
-            //			q.condition_debug();
-
-
-            //vector<component_type_index> access_components = std::ranges::views::transform(descriptor.access_components,
-            //	[&](access_info info) { return m_registry.get_component_index(info.hash); });
-
-            //vector<component_type_index> variant_access_components = std::ranges::views::transform(descriptor.variant_access_components,
-            //	[&](auto&& vec) { return std::ranges::views::transform(vec,
-            //		[&](access_info info) { return m_registry.get_component_index(info.hash); }); });
-            //vector<component_type_index> optional_access_components = std::ranges::views::transform(descriptor.optional_access_components,
-            //	[&](access_info info) { return m_registry.get_component_index(info.hash); });
+            query& q = m_registry.get_query(query_condition(sequence_cref<component_type_index>(cond_all),
+                                                            cond_anys,
+                                                            sequence_cref<component_type_index>(cond_none)));
+            const auto& access_info = q.get_access_info(sequence_cref<component_type_index>(access_list));
+            return executer<callable_type>(std::forward<Callable>(callable), m_registry, q, access_info,
+                                           resolve_access(descriptor), resolve_relations(descriptor));
         }
     };
 }
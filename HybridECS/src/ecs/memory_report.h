@@ -0,0 +1,199 @@
+#pragma once
+
+#include "core/hyecs_core.h"
+#include "ecs/storage/storage_policy.h"
+
+namespace hyecs
+{
+    //byte counts are estimated from the container capacities, allocator overhead is not included
+
+    //node overhead of the tree based map
+    inline constexpr size_t tree_node_overhead = 4 * sizeof(void*);
+
+    struct component_storage_memory_info
+    {
+        std::string name;
+        size_t type_size = 0;
+        //dense components
+        size_t dense_size = 0;
+        size_t dense_capacity = 0;
+        size_t dense_chunk_count = 0;
+        size_t dense_bytes = 0;
+        //entity_sparse_table of the entity to component index
+        size_t sparse_page_count = 0;
+        size_t sparse_slot_count = 0;
+        size_t sparse_occupied_count = 0;
+        size_t sparse_bytes = 0;
+
+        float sparse_occupancy() const
+        {
+            return sparse_slot_count ? float(sparse_occupied_count) / float(sparse_slot_count) : 0.0f;
+        }
+
+        size_t total_bytes() const { return dense_bytes + sparse_bytes; }
+    };
+
+    struct archetype_memory_info
+    {
+        std::string name;
+        storage_layout layout = storage_layout::sparse;
+        bool converting = false;
+        size_t entity_count = 0;
+        //table side, empty for sparse archetypes whose components live in the component storages
+        size_t row_count = 0;
+        size_t chunk_count = 0;
+        size_t chunk_capacity = 0; //rows per chunk
+        size_t chunk_size = 0; //bytes per chunk
+        size_t hole_count = 0;
+        size_t used_bytes = 0; //live rows
+        size_t reserved_bytes = 0; //allocated chunks
+        //chunk list, hole mask and the entity set of the sparse side
+        size_t index_bytes = 0;
+
+        float fill_ratio() const
+        {
+            size_t capacity = chunk_count * chunk_capacity;
+            return capacity ? float(row_count) / float(capacity) : 0.0f;
+        }
+
+        size_t total_bytes() const { return reserved_bytes + index_bytes; }
+    };
+
+    struct tag_archetype_memory_info
+    {
+        std::string name;
+        size_t entity_count = 0;
+        size_t index_bytes = 0;
+    };
+
+    struct query_memory_info
+    {
+        enum class query_kind : uint8_t
+        {
+            query,
+            table_tag_query,
+            cross_query,
+        };
+
+        uint64_t id = 0;
+        query_kind kind = query_kind::query;
+        size_t entity_count = 0; //cached entities, a query without an entity cache reports 0
+        size_t access_info_count = 0;
+        size_t cache_bytes = 0;
+    };
+
+    struct registry_memory_report
+    {
+        size_t entity_count = 0;
+        size_t entity_set_bytes = 0;
+        size_t storage_key_count = 0;
+        size_t storage_key_bytes = 0;
+        //chunk arena, the table chunks and the component pages are carved out of it
+        size_t arena_allocated_bytes = 0;
+        size_t arena_reserved_bytes = 0;
+        size_t arena_slab_count = 0;
+
+        vector<archetype_memory_info> archetypes;
+        vector<tag_archetype_memory_info> tag_archetypes;
+        vector<component_storage_memory_info> component_storages;
+        vector<query_memory_info> queries;
+
+        size_t archetype_bytes() const
+        {
+            size_t bytes = 0;
+            for (auto& info: archetypes) bytes += info.total_bytes();
+            for (auto& info: tag_archetypes) bytes += info.index_bytes;
+            return bytes;
+        }
+
+        size_t component_storage_bytes() const
+        {
+            size_t bytes = 0;
+            for (auto& info: component_storages) bytes += info.total_bytes();
+            return bytes;
+        }
+
+        size_t query_bytes() const
+        {
+            size_t bytes = 0;
+            for (auto& info: queries) bytes += info.cache_bytes;
+            return bytes;
+        }
+
+        size_t total_bytes() const
+        {
+            return entity_set_bytes + storage_key_bytes + archetype_bytes() + component_storage_bytes() + query_bytes();
+        }
+
+        std::string to_json() const
+        {
+            std::string out;
+            auto iter = std::back_inserter(out);
+            auto array = [&](const char* name, const auto& infos, auto&& write)
+            {
+                std::format_to(iter, ",\"{}\":[", name);
+                for (size_t i = 0; i < infos.size(); i++)
+                {
+                    if (i) out += ',';
+                    write(infos[i]);
+                }
+                out += ']';
+            };
+
+            std::format_to(iter, "{{\"total_bytes\":{},\"entity_count\":{},\"entity_set_bytes\":{}", total_bytes(), entity_count, entity_set_bytes);
+            std::format_to(iter, ",\"storage_key_count\":{},\"storage_key_bytes\":{}", storage_key_count, storage_key_bytes);
+            std::format_to(iter, ",\"arena\":{{\"allocated_bytes\":{},\"reserved_bytes\":{},\"slab_count\":{}}}",
+                    arena_allocated_bytes, arena_reserved_bytes, arena_slab_count);
+            array("archetypes", archetypes, [&](const archetype_memory_info& info)
+            {
+                std::format_to(iter, "{{\"name\":\"{}\",\"layout\":\"{}\",\"converting\":{},\"entity_count\":{}",
+                        json_escape(info.name), info.layout == storage_layout::chunk ? "chunk" : "sparse",
+                        info.converting, info.entity_count);
+                std::format_to(iter, ",\"row_count\":{},\"chunk_count\":{},\"chunk_capacity\":{},\"chunk_size\":{},\"fill_ratio\":{:.4f}",
+                        info.row_count, info.chunk_count, info.chunk_capacity, info.chunk_size, info.fill_ratio());
+                std::format_to(iter, ",\"hole_count\":{},\"used_bytes\":{},\"reserved_bytes\":{},\"index_bytes\":{}}}",
+                        info.hole_count, info.used_bytes, info.reserved_bytes, info.index_bytes);
+            });
+            array("tag_archetypes", tag_archetypes, [&](const tag_archetype_memory_info& info)
+            {
+                std::format_to(iter, "{{\"name\":\"{}\",\"entity_count\":{},\"index_bytes\":{}}}",
+                        json_escape(info.name), info.entity_count, info.index_bytes);
+            });
+            array("component_storages", component_storages, [&](const component_storage_memory_info& info)
+            {
+                std::format_to(iter, "{{\"name\":\"{}\",\"type_size\":{},\"dense_size\":{},\"dense_capacity\":{}",
+                        json_escape(info.name), info.type_size, info.dense_size, info.dense_capacity);
+                std::format_to(iter, ",\"dense_chunk_count\":{},\"dense_bytes\":{}", info.dense_chunk_count, info.dense_bytes);
+                std::format_to(iter, ",\"sparse_page_count\":{},\"sparse_occupancy\":{:.4f},\"sparse_bytes\":{}}}",
+                        info.sparse_page_count, info.sparse_occupancy(), info.sparse_bytes);
+            });
+            array("queries", queries, [&](const query_memory_info& info)
+            {
+                static constexpr const char* kind_names[] = {"query", "table_tag_query", "cross_query"};
+                std::format_to(iter, "{{\"id\":{},\"kind\":\"{}\",\"entity_count\":{},\"access_info_count\":{},\"cache_bytes\":{}}}",
+                        info.id, kind_names[size_t(info.kind)], info.entity_count, info.access_info_count, info.cache_bytes);
+            });
+            out += '}';
+            return out;
+        }
+
+        void write_json(std::ostream& os) const
+        {
+            os << to_json();
+        }
+
+    private:
+        static std::string json_escape(std::string_view str)
+        {
+            std::string out;
+            out.reserve(str.size());
+            for (char c: str)
+            {
+                if (c == '"' || c == '\\') out += '\\';
+                if (uint8_t(c) < 0x20) continue;
+                out += c;
+            }
+            return out;
+        }
+    };
+}
@@ -132,13 +132,13 @@ namespace hyecs
         };
 
     private:
-        using access_hash = uint64_t; //arch hash of access component list
+        using access_hash = uint64_t; //ordered hash of access component list
         map<access_hash, access_info> m_access_infos;
 
     public:
         const access_info& get_access_info(sequence_cref<component_type_index> access_list)
         {
-            access_hash hash = archetype::addition_hash(0, append_component(access_list));
+            access_hash hash = access_list_hash(access_list);
             if (auto iter = m_access_infos.find(hash); iter != m_access_infos.end())
                 return iter->second;
             auto [iter, _] = m_access_infos.insert(
@@ -149,10 +149,28 @@ namespace hyecs
             return info;
         }
 
+        query_memory_info memory_info() const
+        {
+            query_memory_info info;
+            info.kind = query_memory_info::query_kind::cross_query;
+            info.entity_count = m_entities.size();
+            info.access_info_count = m_access_infos.size();
+            info.cache_bytes = m_potential_entities.memory_usage() + m_entities.memory_usage() +
+                               m_in_group_queries.capacity() * sizeof(query*);
+            for (auto& [_, access]: m_access_infos)
+            {
+                auto& cache = access.table_indices_cache;
+                info.cache_bytes += sizeof(std::pair<const access_hash, access_info>) + tree_node_overhead +
+                                    cache.table_index.capacity() * sizeof(uint32_t) +
+                                    cache.component_indices.capacity() * sizeof(sequence_ref<uint32_t>) +
+                                    cache.component_indices_storage.capacity() * sizeof(uint32_t);
+            }
+            return info;
+        }
+
 
-        void dynamic_for_each(
-            const access_info& acc_info,
-            function<void(entity, sequence_ref<void*>)> func);
+        template<typename Callable>
+        void dynamic_for_each(const access_info& acc_info, Callable&& func);
 
 
         //        class iteration_distributor
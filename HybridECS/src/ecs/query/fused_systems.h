@@ -0,0 +1,166 @@
+#pragma once
+#include "query.h"
+
+namespace hyecs
+{
+    //runs a chain of systems in one traversal of a driver query, e.g. integrate velocity, clamp, then write transforms
+    //the query of each system must be a subquery of the driver, its archetype storages are among those of the driver
+    //
+    //  fused_systems chain(moving);
+    //  chain.add(moving, moving_access, integrate).add(clamped, clamped_access, clamp);
+    //  chain.run();
+    //
+    //a run of rows is handed to every system whose query matches its storage, in the order the systems were added,
+    //before the traversal moves on, so the chain loads each chunk once instead of once per system
+    //a system may only touch the rows it is handed, the next systems see its writes on those rows
+    //the rows a query reaches through tag table queries are not fused, they live in the table of the untagged archetype
+    //and run through the tag query at the place of the system in the chain, splitting the traversal of that table
+    class fused_systems
+    {
+    public:
+        //takes the arguments of query::dynamic_for_each_batch, the columns are in the order of the access list
+        using batch_function = function<void(sequence_cref<entity>, sequence_cref<void*>, sequence_cref<uint32_t>, uint32_t)>;
+
+    private:
+        struct system
+        {
+            query* q;
+            vector<component_type_index> access_list;
+            batch_function func;
+        };
+
+        //a system on the rows of a storage, fused with its neighbours or through a tag query
+        struct step
+        {
+            uint32_t system;
+            table_tag_query* tag_query; //null for a fused step
+            const table_tag_query::access_info* tag_access;
+        };
+
+        query& m_driver;
+        vector<system> m_systems;
+        //the steps of each storage in chain order, rebuilt when a query of the chain reaches new archetypes
+        unordered_map<archetype_storage*, vector<step>> m_storage_steps;
+        //the storages of the driver, then the ones only reached through tag queries
+        vector<archetype_storage*> m_storage_order;
+        size_t m_reached_count = 0;
+
+        //the queries only grow, the count tells when the steps are outdated
+        size_t reached_count() const
+        {
+            size_t count = m_driver.archetype_storages().size();
+            for (const auto& sys: m_systems)
+                count += sys.q->archetype_storages().size() + sys.q->tag_table_queries().size();
+            return count;
+        }
+
+        void build_steps()
+        {
+            m_storage_steps.clear();
+            m_storage_order.assign(m_driver.archetype_storages().begin(), m_driver.archetype_storages().end());
+            for (auto storage: m_storage_order)
+                m_storage_steps.try_emplace(storage);
+            for (uint32_t i = 0; i < m_systems.size(); i++)
+            {
+                auto& sys = m_systems[i];
+                for (auto storage: sys.q->archetype_storages())
+                    m_storage_steps.at(storage).push_back({i, nullptr, nullptr});
+                for (auto table_query: sys.q->tag_table_queries())
+                {
+                    auto [iter, inserted] = m_storage_steps.try_emplace(table_query->get_archetype_storage());
+                    if (inserted) m_storage_order.push_back(table_query->get_archetype_storage());
+                    iter->second.push_back({i, table_query, &table_query->get_access_info(sys.access_list)});
+                }
+            }
+            m_reached_count = reached_count();
+        }
+
+        void run_fused(archetype_storage* storage, sequence_cref<step> steps)
+        {
+            memory::frame_scope frame;
+            //the union of the access lists of the systems, fetched once per run
+            memory::frame_vector<component_type_index> fused_access;
+            //the access list of each system as positions in the union, the systems are in order
+            memory::frame_vector<uint32_t> system_columns;
+            memory::frame_vector<std::pair<const system*, uint32_t>> matched;
+            for (auto& st: steps)
+            {
+                const system& sys = m_systems[st.system];
+                matched.emplace_back(&sys, uint32_t(system_columns.size()));
+                for (auto component: sys.access_list)
+                {
+                    auto iter = std::ranges::find(fused_access, component);
+                    system_columns.push_back(uint32_t(iter - fused_access.begin()));
+                    if (iter == fused_access.end()) fused_access.push_back(component);
+                }
+            }
+
+            memory::frame_vector<uint32_t> component_indices(fused_access.size());
+            storage->get_component_indices(sequence_cref<component_type_index>(fused_access), component_indices);
+
+            access_buffer<void*> columns;
+            access_buffer<uint32_t> strides;
+            storage->dynamic_for_each_batch(component_indices, [&](sequence_cref<entity> entities, sequence_cref<void*> fused_columns,
+                                                                   sequence_cref<uint32_t> fused_strides, uint32_t count)
+            {
+                for (auto [sys, offset]: matched)
+                {
+                    const size_t column_count = sys->access_list.size();
+                    columns.resize(column_count);
+                    strides.resize(column_count);
+                    for (size_t i = 0; i < column_count; i++)
+                    {
+                        const uint32_t column = system_columns[offset + i];
+                        columns[i] = fused_columns[column];
+                        strides[i] = fused_strides[column];
+                    }
+                    sys->func(entities, sequence_cref<void*>(columns), sequence_cref<uint32_t>(strides), count);
+                }
+            });
+        }
+
+        void run_storage(archetype_storage* storage, const vector<step>& steps)
+        {
+            size_t begin = 0;
+            while (begin < steps.size())
+            {
+                if (auto& st = steps[begin]; st.tag_query)
+                {
+                    st.tag_query->dynamic_for_each_batch(*st.tag_access, m_systems[st.system].func);
+                    begin++;
+                    continue;
+                }
+                size_t end = begin;
+                while (end < steps.size() && !steps[end].tag_query) end++;
+                run_fused(storage, sequence_cref<step>(steps.data() + begin, steps.data() + end));
+                begin = end;
+            }
+        }
+
+    public:
+        explicit fused_systems(query& driver) : m_driver(driver)
+        {
+        }
+
+        fused_systems& add(query& q, sequence_cref<component_type_index> access_list, batch_function func)
+        {
+            ASSERTION_CODE(
+                for (auto storage: q.archetype_storages())
+                    assert(std::ranges::find(m_driver.archetype_storages(), storage) != m_driver.archetype_storages().end());
+            );
+            m_systems.push_back({&q, {access_list.begin(), access_list.end()}, std::move(func)});
+            build_steps();
+            return *this;
+        }
+
+        size_t system_count() const { return m_systems.size(); }
+
+        void run()
+        {
+            HYECS_TRACE_SCOPE_COUNT("fused_systems::run", m_systems.size());
+            if (reached_count() != m_reached_count) build_steps();
+            for (auto storage: m_storage_order)
+                run_storage(storage, m_storage_steps.at(storage));
+        }
+    };
+}
@@ -5,6 +5,17 @@
 
 namespace hyecs
 {
+    //the key of the cached access infos, unlike the archetype hash it depends on the order of the list
+    //as the access info keeps the order of the list it was built with
+    inline uint64_t access_list_hash(sequence_cref<component_type_index> access_list)
+    {
+        using traits = internal::fnv1a_traits<uint64_t>;
+        uint64_t hash = traits::offset;
+        for (auto& type: access_list)
+            hash = (hash ^ (uint64_t) type.hash()) * traits::prime;
+        return hash;
+    }
+
     //the tag arch that shares a same table
     //no need condition info for tag query, condition is processed by archetype_registry
     class table_tag_query
@@ -14,7 +25,16 @@ namespace hyecs
         {
             full_set_access,
             mixed_access,
-            sparse_access
+            sparse_access,
+            converting_access //entities split between table and sparse, resolved per entity
+        };
+
+        //trace scope names per access type, so the counters of the access paths can be compared
+        static constexpr const char* trace_names[] = {
+            "table_tag_query::for_each full_set",
+            "table_tag_query::for_each mixed",
+            "table_tag_query::for_each sparse",
+            "table_tag_query::for_each converting",
         };
 
     private:
@@ -115,6 +135,12 @@ namespace hyecs
             return m_archetype_storage;
         }
 
+        //the storage of the untagged archetype, its table holds the rows of the tag archetypes
+        archetype_storage* get_archetype_storage() const
+        {
+            return m_archetype_storage;
+        }
+
     private:
         bool is_chunk_storage() const
         {
@@ -124,7 +150,7 @@ namespace hyecs
     private:
         void notify_storage_chunk_convert()
         {
-            assert(m_query_type == sparse_access);
+            assert(m_query_type == sparse_access || m_query_type == converting_access);
             m_query_type = mixed_access;
             m_table = m_archetype_storage->get_table();
             assert(m_table);
@@ -140,7 +166,7 @@ namespace hyecs
         void notify_storage_sparse_convert()
         {
             //todo
-            assert(m_query_type == mixed_access);
+            assert(m_query_type == mixed_access || m_query_type == converting_access);
             m_query_type = sparse_access;
             m_table = nullptr;
             //todo if this needed?
@@ -156,6 +182,13 @@ namespace hyecs
             m_on_entity_add(e, key);
         }
 
+        void notify_entities_move(sequence_cref<entity> entities, sequence_cref<storage_key> keys)
+        {
+            for (size_t i = 0; i < entities.size(); i++)
+                if (m_entities.contains(entities[i]))
+                    m_entities.at(entities[i]) = keys[i];
+        }
+
         void notify_entity_remove(entity e)
         {
             m_entities.erase(e);
@@ -177,8 +210,24 @@ namespace hyecs
             m_on_entity_remove += on_entity_remove;
         }
 
+        void notify_storage_conversion_begin()
+        {
+            m_query_type = converting_access;
+            m_table = m_archetype_storage->get_table();
+        }
+
         void notify_partial_convert()
         {
+            m_archetype_storage->add_callback_on_conversion_begin(
+                    [&]()
+                    {
+                        notify_storage_conversion_begin();
+                    });
+            m_archetype_storage->add_callback_on_entities_move(
+                    [&](sequence_cref<entity> entities, sequence_cref<storage_key> keys)
+                    {
+                        notify_entities_move(entities, keys);
+                    });
             m_archetype_storage->add_callback_on_sparse_to_chunk(
                     [&]()
                     {
@@ -191,7 +240,20 @@ namespace hyecs
                     });
             m_table = m_archetype_storage->get_table();
             //todo init m_entities
-            if (m_table)
+            if (m_archetype_storage->is_converting())
+            {
+                m_query_type = converting_access;
+                auto& key_registry = m_archetype_storage->get_key_registry();
+                for (const auto tag_storage: m_tag_storages)
+                {
+                    auto& storage_entity = tag_storage->entities();
+                    for (auto [e, _]: storage_entity)
+                    {
+                        m_entities.insert({e, key_registry.contains(e) ? key_registry.at(e) : storage_key{}});
+                    }
+                }
+            }
+            else if (m_table)
             {
                 m_query_type = mixed_access;
                 auto key_registry = m_archetype_storage->get_key_registry();
@@ -249,6 +311,7 @@ namespace hyecs
             }
 
             vector<uint32_t> table_access_indices; //use in table
+            vector<uint32_t> archetype_access_indices; //per access, in the archetype storage, absent for the tags
             vector<uint32_t> tag_i_to_storage_i;
             vector<uint32_t> table_i_to_access_i;
             vector<uint32_t> tag_i_to_access_i;
@@ -256,15 +319,35 @@ namespace hyecs
         };
 
     private:
-        using access_hash = uint64_t; //arch hash of access component list
+        using access_hash = uint64_t; //ordered hash of access component list
         map<access_hash, access_info> m_access_infos;
 
     public:
         size_t entity_count() const { return m_entities.size(); }
 
+        query_memory_info memory_info() const
+        {
+            query_memory_info info;
+            info.kind = query_memory_info::query_kind::table_tag_query;
+            info.entity_count = m_entities.size();
+            info.access_info_count = m_access_infos.size();
+            info.cache_bytes = m_entities.memory_usage() +
+                               m_tag_storages.capacity() * sizeof(tag_archetype_storage*) +
+                               m_component_storages.capacity() * sizeof(component_storage*) +
+                               m_access_components.capacity() * sizeof(component_type_index);
+            for (auto& [_, access]: m_access_infos)
+            {
+                info.cache_bytes += sizeof(std::pair<const access_hash, access_info>) + tree_node_overhead;
+                for (auto* indices: {&access.table_access_indices, &access.archetype_access_indices, &access.tag_i_to_storage_i,
+                                     &access.table_i_to_access_i, &access.tag_i_to_access_i, &access.access_i_to_storage_i})
+                    info.cache_bytes += indices->capacity() * sizeof(uint32_t);
+            }
+            return info;
+        }
+
         const access_info& get_access_info(sequence_ref<component_type_index> access_list)
         {
-            access_hash hash = archetype::addition_hash(0, append_component(access_list));
+            access_hash hash = access_list_hash(access_list);
             if (auto iter = m_access_infos.find(hash); iter != m_access_infos.end())
                 return iter->second;
 
@@ -274,21 +357,25 @@ namespace hyecs
                     });
             auto& info = iter->second;
 
-            vector<component_type_index> table_access_list;
+            memory::frame_scope frame;
+            memory::frame_vector<component_type_index> table_access_list;
             size_t tag_count = 0;
             table_access_list.reserve(access_list.size());
             for (const auto& comp: access_list)
                 if (comp.is_tag()) tag_count++;
                 else table_access_list.push_back(comp);
 
-            info.table_access_indices.resize(table_access_list.size());
-            info.access_i_to_storage_i.resize(access_list.size());
+            //the optional components the query does not have stay absent
+            info.table_access_indices.resize(table_access_list.size(), absent_component_index);
+            info.access_i_to_storage_i.resize(access_list.size(), absent_component_index);
+            info.archetype_access_indices.resize(access_list.size(), absent_component_index);
             info.tag_i_to_storage_i.reserve(tag_count);
             info.tag_i_to_access_i.reserve(tag_count);
             info.table_i_to_access_i.reserve(table_access_list.size());
 
             m_archetype_storage->get_component_indices(table_access_list, info.table_access_indices);
             get_component_indices(access_list, info.access_i_to_storage_i);
+            m_archetype_storage->get_component_indices(access_list, info.archetype_access_indices);
             for (uint32_t i = 0; i < access_list.size(); i++)
             {
                 if (access_list[i].is_tag())
@@ -304,25 +391,22 @@ namespace hyecs
             return info;
         }
 
-        void dynamic_for_each(
-                const access_info& info,
-                function<void(entity, sequence_ref<void*>)> func)
+        template<typename Callable>
+        void dynamic_for_each(const access_info& info, Callable&& func)
         {
+            HYECS_TRACE_SCOPE_COUNT(trace_names[m_query_type], m_entities.size());
+            //full set access is counted by the archetype storage
+            if (m_query_type != full_set_access) m_archetype_storage->record_sequential_access(m_entities.size());
             switch (m_query_type)
             {
                 case full_set_access:
-                    m_archetype_storage->dynamic_for_each(
-                            info.table_access_indices,
-                            [&](entity e, sequence_ref<void*> components)
-                            {
-                                func(e, components);
-                            });
+                    m_archetype_storage->dynamic_for_each(info.table_access_indices, func);
                     break;
                 case mixed_access:
                 {
                     const auto full_component_count = info.access_i_to_storage_i.size();
                     const auto table_component_count = info.table_access_indices.size();
-                    vector<void*> cache(table_component_count + full_component_count); //todo this allocation can be optimized
+                    access_buffer<void*> cache(table_component_count + full_component_count);
                     sequence_ref<void*> table_components(cache.data(), cache.data() + table_component_count);
                     sequence_ref<void*> addresses(cache.data() + table_component_count, cache.data() + cache.size());
 
@@ -341,10 +425,34 @@ namespace hyecs
                     }
                 }
                     break;
+                case converting_access:
+                {
+                    const auto full_component_count = info.access_i_to_storage_i.size();
+                    const auto table_component_count = info.table_access_indices.size();
+                    access_buffer<void*> cache(table_component_count + full_component_count);
+                    sequence_ref<void*> table_components(cache.data(), cache.data() + table_component_count);
+                    sequence_ref<void*> addresses(cache.data() + table_component_count, cache.data() + cache.size());
+
+                    for (const auto& [entity, _]: m_entities)
+                    {
+                        m_archetype_storage->components_addresses(entity, info.table_access_indices, table_components);
+                        for (size_t i = 0; i < info.table_access_indices.size(); i++)
+                        {
+                            addresses[info.table_i_to_access_i[i]] = table_components[i];
+                        }
+                        for (size_t i = 0; i < info.tag_i_to_storage_i.size(); i++)
+                        {
+                            addresses[info.tag_i_to_access_i[i]] = m_component_storages[info.tag_i_to_storage_i[i]]->at(entity);
+                        }
+                        func(entity, addresses);
+                    }
+                }
+                    break;
                 case sparse_access:
                 {
                     auto& access_i_to_storage_i = info.access_i_to_storage_i;
-                    vector<void*> addresses(access_i_to_storage_i.size()); //todo this allocation can be optimized
+                    access_buffer<void*> address_cache(access_i_to_storage_i.size());
+                    sequence_ref<void*> addresses(address_cache);
                     for (const auto& [entity, _]: m_entities)
                     {
                         for (size_t i = 0; i < access_i_to_storage_i.size(); i++)
@@ -358,72 +466,113 @@ namespace hyecs
             }
         }
 
+        //func takes (sequence_cref<entity>, sequence_cref<void*> columns, sequence_cref<uint32_t> strides, uint32_t count),
+        //the rows of the tag accesses are gathered into the runs where all the accessed components are contiguous
+        template<typename Callable>
+        void dynamic_for_each_batch(const access_info& info, Callable&& func)
+        {
+            if (m_query_type == full_set_access)
+            {
+                HYECS_TRACE_SCOPE_COUNT(trace_names[m_query_type], m_entities.size());
+                m_archetype_storage->dynamic_for_each_batch(info.table_access_indices, func);
+                return;
+            }
+            access_buffer<uint32_t> strides(info.access_i_to_storage_i.size());
+            for (size_t i = 0; i < info.access_i_to_storage_i.size(); i++)
+                strides[i] = m_component_storages[info.access_i_to_storage_i[i]]->component_type().size();
+            column_run_builder runs(strides);
+            dynamic_for_each(info, [&](entity e, sequence_ref<void*> addresses)
+            {
+                runs.push(e, addresses, func);
+            });
+            runs.flush(func);
+        }
+
         template<typename T>
         struct is_param_tag
         {
-            static constexpr bool value = component_traits<std::decay_t<T>>::is_tag;
+            static constexpr bool value = component_traits<typename access_param_traits<T>::component>::is_tag;
         };
 
+        //the optional and variant components are resolved once for the query, see system_callable_invoker::specialize
         template<typename Callable>
         void for_each(Callable&& func, const access_info& info)
         {
-            using params = typename function_traits<Callable>::args;
-            using component_param = typename params::template filter_with<is_static_component>;
-            using non_component_param = typename params::template filter_without<is_static_component>;
-
+            HYECS_TRACE_SCOPE_COUNT(trace_names[m_query_type], m_entities.size());
+            if (m_query_type != full_set_access) m_archetype_storage->record_sequential_access(m_entities.size());
             switch (m_query_type)
             {
                 case full_set_access:
-                    m_archetype_storage->for_each(std::forward<Callable>(func), info.table_access_indices);
+                    m_archetype_storage->for_each(std::forward<Callable>(func), info.archetype_access_indices);
                     break;
                 case mixed_access:
                 {
-                    using table_component_param = typename component_param::template filter_without<is_param_tag>;
-                    using tag_component_param = typename component_param::template filter_with<is_param_tag>;
-                    const auto full_component_count = info.access_i_to_storage_i.size();
-                    const auto table_component_count = info.table_access_indices.size();
-                    std::array<void*, table_component_param::size> table_components;
                     system_callable_invoker invoker(std::forward<Callable>(func));
-
-                    for (const auto& kv: m_entities)
+                    //the keyed rows are scattered over the table, no streaming stores
+                    invoker.specialize(info.access_i_to_storage_i, 0, [&](auto resolution)
                     {
-                        //cpp 17 not support structured binding in lambda capture
-                        const auto& entity = kv.first;
-                        const auto& st_key = kv.second;
-                        m_table->components_addresses(st_key, info.table_access_indices, table_components);
-                        invoker.invoke(
-                                [&] { return entity; },
-                                [&] { return st_key; },
-                                [&](auto type, size_t index)
-                                {
-                                    using param_type = typename decltype(type)::type;
-                                    if constexpr (is_param_tag<param_type>::value)
+                        for (const auto& kv: m_entities)
+                        {
+                            //cpp 17 not support structured binding in lambda capture
+                            const auto& entity = kv.first;
+                            const auto& st_key = kv.second;
+                            invoker.template invoke<decltype(resolution)::value>(
+                                    [&] { return entity; },
+                                    [&] { return st_key; },
+                                    [&](auto type, size_t index) -> void*
                                     {
-                                        constexpr size_t tag_i = tag_component_param::template index_of<param_type>;
-                                        return m_component_storages[info.tag_i_to_storage_i[tag_i]]->at(entity);
-                                    }
-                                    else
+                                        if constexpr (is_param_tag<typename decltype(type)::type>::value)
+                                            return m_component_storages[info.access_i_to_storage_i[index]]->at(entity);
+                                        else
+                                            return m_table->component_address(st_key, info.archetype_access_indices[index]);
+                                    });
+                        }
+                    });
+                }
+                    break;
+                case converting_access:
+                {
+                    system_callable_invoker invoker(std::forward<Callable>(func));
+                    access_buffer<void*> table_components(info.archetype_access_indices.size());
+                    invoker.specialize(info.access_i_to_storage_i, 0, [&](auto resolution)
+                    {
+                        for (const auto& kv: m_entities)
+                        {
+                            const auto& entity = kv.first;
+                            //the key may be stale while entities are migrating
+                            m_archetype_storage->components_addresses(entity, info.archetype_access_indices,
+                                                                      sequence_ref<void*>(table_components));
+                            invoker.template invoke<decltype(resolution)::value>(
+                                    [&] { return entity; },
+                                    [&] { return storage_key{}; },
+                                    [&](auto type, size_t index) -> void*
                                     {
-                                        return table_components[table_component_param::template index_of<param_type>];
-                                    }
-                                });
-                    }
+                                        if constexpr (is_param_tag<typename decltype(type)::type>::value)
+                                            return m_component_storages[info.access_i_to_storage_i[index]]->at(entity);
+                                        else
+                                            return table_components[index];
+                                    });
+                        }
+                    });
                 }
                     break;
                 case sparse_access:
                 {
                     auto& component_indices = info.access_i_to_storage_i;
                     system_callable_invoker invoker(std::forward<Callable>(func));
-                    for (const auto& kv: m_entities)
+                    invoker.specialize(component_indices, 0, [&](auto resolution)
                     {
-                        //cpp 17 not support structured binding in lambda capture
-                        const auto& entity = kv.first;
-                        invoker.invoke(
-                                [&] { return entity; },
-                                [&] { return storage_key{}; },
-                                [&](auto type, size_t index) { return m_component_storages[component_indices[index]]->at(entity); }
-                        );
-                    }
+                        for (const auto& kv: m_entities)
+                        {
+                            //cpp 17 not support structured binding in lambda capture
+                            const auto& entity = kv.first;
+                            invoker.template invoke<decltype(resolution)::value>(
+                                    [&] { return entity; },
+                                    [&] { return storage_key{}; },
+                                    [&](auto type, size_t index) { return m_component_storages[component_indices[index]]->at(entity); }
+                            );
+                        }
+                    });
                 }
                     break;
             }
@@ -439,6 +588,7 @@ namespace hyecs
 
         //todo add support for sparse table access optimization
 
+    public:
         //explain : same query condition can have different access component list
         struct access_info
         {
@@ -470,9 +620,16 @@ namespace hyecs
 
             void on_archetype_add(archetype_storage* storage)
             {
+                const size_t width = access_list.size();
                 size_t old_size = indices_storage.size();
-                size_t new_size = old_size + access_list.size();
-                indices_storage.resize(new_size);
+                size_t new_size = old_size + width;
+                //the optional components the storage does not have stay absent
+                indices_storage.resize(new_size, absent_component_index);
+                //a reallocation moves the indices of the storages added before
+                for (size_t i = 0; i < archetype_access_infos.size(); i++)
+                    archetype_access_infos[i].component_indices = sequence_cref<uint32_t>(
+                            indices_storage.data() + i * width,
+                            indices_storage.data() + (i + 1) * width);
                 auto component_indices_seq = sequence_ref<uint32_t>(
                         indices_storage.data() + old_size,
                         indices_storage.data() + new_size);
@@ -490,7 +647,8 @@ namespace hyecs
             }
         };
 
-        using access_hash = uint64_t; //arch hash of access component list
+    private:
+        using access_hash = uint64_t; //ordered hash of access component list
         map<access_hash, access_info> m_access_infos;
 
         ASSERTION_CODE(query_condition m_condition);
@@ -552,6 +710,12 @@ namespace hyecs
 
         query& operator=(const query&) = delete;
 
+        //the storages iterated directly, including the direct set table queries
+        const vector<archetype_storage*>& archetype_storages() const { return m_archetype_storages; }
+
+        //the table queries of the tag archetypes, iterated through the tag storages
+        const vector<table_tag_query*>& tag_table_queries() const { return m_tag_table_queries; }
+
         //note that this is expensive
         size_t entity_count() const
         {
@@ -567,6 +731,25 @@ namespace hyecs
             return count;
         }
 
+        //the entities are owned by the archetype storages and table queries, only the access caches are counted
+        query_memory_info memory_info() const
+        {
+            query_memory_info info;
+            info.kind = query_memory_info::query_kind::query;
+            info.access_info_count = m_access_infos.size();
+            info.cache_bytes = m_archetype_storages.capacity() * sizeof(archetype_storage*) +
+                               m_tag_table_queries.capacity() * sizeof(table_tag_query*);
+            for (auto& [_, access]: m_access_infos)
+            {
+                info.cache_bytes += sizeof(std::pair<const access_hash, access_info>) + tree_node_overhead +
+                                    access.access_list.capacity() * sizeof(component_type_index) +
+                                    access.archetype_access_infos.capacity() * sizeof(access_info::archetype_access_info) +
+                                    access.indices_storage.capacity() * sizeof(uint32_t) +
+                                    access.table_query_access_infos.capacity() * sizeof(access_info::table_query_access_info);
+            }
+            return info;
+        }
+
 #ifdef HYECS_DEBUG
 
         const query_condition& condition_debug() const { return m_condition; }
@@ -588,7 +771,7 @@ namespace hyecs
 
         const access_info& get_access_info(sequence_cref<component_type_index> access_list)
         {
-            access_hash hash = archetype::addition_hash(0, append_component(access_list));
+            access_hash hash = access_list_hash(access_list);
             if (auto iter = m_access_infos.find(hash); iter != m_access_infos.end())
                 return iter->second;
 
@@ -606,50 +789,39 @@ namespace hyecs
             return info;
         }
 
-        void dynamic_for_each(
-                const access_info& acc_info,
-                function<void(entity, sequence_ref<void*>)> func)
+        //func takes (entity, sequence_ref<void*>), the addresses are in the order of the access list
+        template<typename Callable>
+        void dynamic_for_each(const access_info& acc_info, Callable&& func)
         {
             for (const auto& info: acc_info.archetype_access_infos)
             {
-                info.storage->dynamic_for_each(
-                        info.component_indices, [&](entity e, sequence_ref<void*> components)
-                        {
-                            func(e, components);
-                        });
+                HYECS_TRACE_SCOPE_COUNT("query::for_each archetype", info.storage->entity_count());
+                info.storage->dynamic_for_each(info.component_indices, func);
             }
             for (const auto& info: acc_info.table_query_access_infos)
-            {
-                info.query->dynamic_for_each(
-                        info.access_info, [&](entity e, sequence_ref<void*> components)
-                        {
-                            func(e, components);
-                        });
-            }
+                info.query->dynamic_for_each(info.access_info, func);
         }
 
-        template<typename T>
-        struct is_rw_component_param
+        //func takes (sequence_cref<entity>, sequence_cref<void*> columns, sequence_cref<uint32_t> strides, uint32_t count)
+        //once per run of rows, the component i of the row r is at columns[i] + r * strides[i] in the access list order
+        template<typename Callable>
+        void dynamic_for_each_batch(const access_info& acc_info, Callable&& func)
         {
-            static constexpr bool value =
-                    std::is_reference_v<T>
-                    && !std::is_const_v<std::remove_reference_t<T>>;
-        };
+            for (const auto& info: acc_info.archetype_access_infos)
+            {
+                HYECS_TRACE_SCOPE_COUNT("query::for_each archetype", info.storage->entity_count());
+                info.storage->dynamic_for_each_batch(info.component_indices, func);
+            }
+            for (const auto& info: acc_info.table_query_access_infos)
+                info.query->dynamic_for_each_batch(info.access_info, func);
+        }
 
         template<typename Callable>
         void for_each(Callable&& func, const access_info& acc_info)
         {
-            using params = typename function_traits<std::decay_t<Callable>>::args;
-            using component_param = typename params::template filter_with<is_static_component>;
-            using non_component_param = typename params::template filter_without<is_static_component>;
-            using rw_param = typename component_param::template filter_with<is_rw_component_param>;
-            using ro_param = typename component_param::template filter_without<is_rw_component_param>;
-
-            std::cout << type_name<rw_param> << std::endl;
-            std::cout << type_name<ro_param> << std::endl;
-
             for (const auto& [storage, component_indices]: acc_info.archetype_access_infos)
             {
+                HYECS_TRACE_SCOPE_COUNT("query::for_each archetype", storage->entity_count());
                 storage->for_each(std::forward<Callable>(func), component_indices);
             }
             for (const auto& info: acc_info.table_query_access_infos)
@@ -1,6 +1,7 @@
 #pragma once
 #include "ecs/type/entity.h"
 #include "core/hyecs_core.h"
+#include "container/streaming_store.h"
 
 namespace hyecs::query_parameter
 {
@@ -40,15 +41,29 @@ namespace hyecs::query_parameter
             requires (internal::decayed_type<T> && !std::is_base_of_v<descriptor_param, T>)
     using read_write = T&;
 
+    //write only, the old value is not read, so the system does not depend on the earlier writers of T
+    //the executer picks streaming stores for the columns larger than memory::streaming_store_threshold
     template<typename T>
     requires (internal::decayed_type<T> && !std::is_base_of_v<descriptor_param, T>)
     struct write : wo_component_param
     {
         using type = T;
-        void operator=(const T& other) { value = other; }
-        write(T& val) : value(val) {}
+        void operator=(const T& other)
+        {
+            if constexpr (memory::streamable<T>)
+            {
+                if (streaming)
+                {
+                    memory::stream_store(value, other);
+                    return;
+                }
+            }
+            value = other;
+        }
+        write(T& val, bool stream = false) : value(val), streaming(stream) {}
     private:
         T& value;
+        bool streaming;
     };
 
     //template<typename T>
@@ -67,11 +82,49 @@ namespace hyecs::query_parameter
     template<internal::decayed_type... T>
     struct none_of : none_param { using types = type_list<T...>; };
 
+    //one of the components, the first of the types the archetype of the row has
     template<typename... T>
-    struct variant : variant_param { using types = type_list<T...>; };
+    struct variant : variant_param
+    {
+        using types = type_list<T...>;
+        variant(uint32_t index, void* ptr) : m_index(index), m_ptr(ptr) {}
+        uint32_t index() const { return m_index; }
+
+        template<size_t I>
+        std::remove_reference_t<typename types::template get<I>>& get() const
+        {
+            assert(m_index == I);
+            return *static_cast<std::remove_reference_t<typename types::template get<I>>*>(m_ptr);
+        }
+
+        //calls visitor with the held component
+        template<typename Visitor>
+        void visit(Visitor&& visitor) const
+        {
+            [&]<size_t... I>(std::index_sequence<I...>)
+            {
+                ((m_index == I ? (visitor(get<I>()), true) : false) || ...);
+            }(std::index_sequence_for<T...>{});
+        }
+    private:
+        uint32_t m_index;
+        void* m_ptr;
+    };
 
+    //null when the archetype of the row does not have the component
     template<typename T>
-    struct optional : optional_param { using type = T; };
+    struct optional : optional_param
+    {
+        using type = T;
+        using value_type = std::remove_reference_t<T>;
+        optional(value_type* ptr) : value(ptr) {}
+        bool has_value() const { return value != nullptr; }
+        explicit operator bool() const { return value != nullptr; }
+        value_type& operator*() const { return *value; }
+        value_type* operator->() const { return value; }
+    private:
+        value_type* value;
+    };
 
     template<typename...>
     struct relation;
@@ -90,6 +143,8 @@ namespace hyecs::query_parameter
         struct is_filter : std::is_base_of<filter_param, T> {};
     }
 
+    //the target of the relation First of the row, with the components QueryParam of the target
+    //the rows whose entity has no target with the components are skipped
     template<typename First, typename... QueryParam>
     struct relation<First(QueryParam...)> : entity_relation_param
     {
@@ -99,19 +154,68 @@ namespace hyecs::query_parameter
         entity e;
         accessable::tuple_t components;
 
+        relation(entity e, typename accessable::tuple_t components) : e(e), components(components) {}
+
+        //addresses are the components of the target in the order of accessable
+        static relation from_addresses(entity e, void* const* addresses)
+        {
+            return [&]<size_t... I>(std::index_sequence<I...>)
+            {
+                return relation(e, typename accessable::tuple_t{
+                                static_cast<typename accessable::template get<I>>(
+                                    *static_cast<std::decay_t<typename accessable::template get<I>>*>(addresses[I]))...});
+            }(std::make_index_sequence<accessable::size>{});
+        }
+
+        template<size_t I>
+        decltype(auto) get() const { return std::get<I>(components); }
     };
 
     template<typename...>
     struct multi_relation;
 
+    //the targets of the relation First of the row that have the components QueryParam, a view over the
+    //targets resolved for the whole query, the elements are relation<First(QueryParam...)>
     template<typename First, typename... QueryParam>
     struct multi_relation<First(QueryParam...)> : entity_multi_relation_param
     {
         using relation_tag = First;
         using query_param = type_list<QueryParam...>;
         using accessable = query_param::template filter_without<internal::is_filter>;
-        entity e;
-        vector<typename accessable::tuple_t> components;
+        using value_type = relation<First(QueryParam...)>;
+
+        //slots index targets, the addresses of a target are at addresses[slot * accessable::size]
+        multi_relation(const uint32_t* slots, size_t count, const entity* targets, void* const* addresses)
+            : m_slots(slots), m_count(count), m_targets(targets), m_addresses(addresses)
+        {
+        }
+
+        size_t size() const { return m_count; }
+        bool empty() const { return m_count == 0; }
+
+        value_type operator[](size_t i) const
+        {
+            uint32_t slot = m_slots[i];
+            return value_type::from_addresses(m_targets[slot], m_addresses + size_t(slot) * accessable::size);
+        }
+
+        struct iterator
+        {
+            const multi_relation* view;
+            size_t index;
+            value_type operator*() const { return (*view)[index]; }
+            iterator& operator++() { ++index; return *this; }
+            bool operator==(const iterator& other) const { return index == other.index; }
+        };
+
+        iterator begin() const { return {this, 0}; }
+        iterator end() const { return {this, m_count}; }
+
+    private:
+        const uint32_t* m_slots;
+        size_t m_count;
+        const entity* m_targets;
+        void* const* m_addresses;
     };
 
     namespace
@@ -95,13 +95,13 @@ namespace hyecs
         {
             assert(category == relation_category::multi_embedded || category == relation_category::single_embedded);
             auto& scope = get_current_scope();
-            //embedded
+            //embedded, the reference points to the scope of the target
             scope.relation_references.emplace_back(relation_reference_info{
                     .name = "embedded",
                     .tag_hash = tag_hash,
                     .param_index = param_index,
                     .category = category,
-                    .scope_index = scope_stack.top()
+                    .scope_index = uint32_t(multi_access_info.size())
             });
             scope_stack.push(multi_access_info.size());
             auto& new_scope = multi_access_info.emplace_back();
@@ -217,13 +217,10 @@ namespace hyecs
         auto access_info_from()
         {
             using decayed = std::decay_t<T>;
-            static constexpr bool is_const = std::is_const_v<T>;
+            static constexpr bool is_const = std::is_const_v<std::remove_reference_t<T>>;
             static constexpr bool is_ref = std::is_reference_v<T>;
             static constexpr bool is_wo = std::is_base_of_v<query_parameter::wo_component_param, T>;
 
-            std::cout << type_name<T> << std::endl;
-
-
             if constexpr (is_wo)
             {
                 static_assert(!std::is_empty_v<typename T::type>, "empty component is not allowed to access");
@@ -233,12 +230,11 @@ namespace hyecs
             {
                 static_assert(!std::is_empty_v<decayed>, "empty component is not allowed to access");
 
-                if constexpr (is_const)
+                //a value parameter is a copy of the component, only write<T> is write only
+                if constexpr (is_const || !is_ref)
                     return access_info{type_hash::of<decayed>(), I, access_info::ro};
-                else if constexpr (is_ref)
-                    return access_info{type_hash::of<decayed>(), I, access_info::rw};
                 else
-                    return access_info{type_hash::of<decayed>(), I, access_info::wo};
+                    return access_info{type_hash::of<decayed>(), I, access_info::rw};
             }
         };
 
@@ -274,14 +270,16 @@ namespace hyecs
                 access_any.param_index = I;
                 for_each_type([&]<typename U>(type_wrapper<U>)
                               {
-                                  auto info = access_info_from<U>();
+                                  //the alternatives are accessed by reference
+                                  auto info = access_info_from<std::remove_reference_t<U>&, I>();
                                   cond_any.push_back(info.hash);
                                   access_any.access_components.push_back(info);
                               }, typename T::types{});
             }
             else if constexpr (std::is_base_of_v<query_parameter::optional_param, T>)
             {
-                auto info = access_info_from<typename T::type, I>();
+                //accessed through a pointer, written unless the type is const
+                auto info = access_info_from<std::remove_reference_t<typename T::type>&, I>();
                 add_optional_access_component(info);
             }
             else if constexpr (std::is_base_of_v<query_parameter::relation_param, T>)
@@ -340,14 +338,12 @@ namespace hyecs
                         else if constexpr (std::is_same_v<std::decay_t<T>, entity>)
                         {
                             static_assert(std::is_same_v<T, entity>, "entity must be value parameter");
-                            std::cout << type_name<T> << std::endl;
                             set_entity_access(I);
                         }
                         else if constexpr (std::is_same_v<std::decay_t<T>, storage_key>)
                         {
                             static_assert(std::is_same_v<T, storage_key>,
                                           "storage_key must be value parameter");
-                            std::cout << type_name<T> << std::endl;
                             set_storage_key_access(I);
                         }
                         else
@@ -0,0 +1,146 @@
+#pragma once
+#include "query_api.h"
+#include "ecs/storage/relation_storage.h"
+
+namespace hyecs
+{
+    //a relation parameter of an executer, the components of the targets are resolved once per call for all
+    //the targets of the relation, the rows read them by target slot instead of a random access per row
+    struct relation_binding
+    {
+        relation_storage* storage;
+        vector<component_type_index> access_list; //the components of the target in parameter order
+        //resolved per call
+        vector<void*> target_addresses; //access_list.size() entries per target slot, null when absent
+        vector<uint32_t> matched_slots; //the slots of the targets that have all the components, per source
+        vector<uint32_t> matched_offsets; //per source index, into matched_slots
+
+        //keeps the targets with all the components, once target_addresses is resolved
+        void match()
+        {
+            memory::frame_scope frame;
+            const size_t stride = access_list.size();
+            const size_t target_count = storage->targets().size();
+            memory::frame_vector<uint8_t> matched(target_count);
+            for (size_t slot = 0; slot < target_count; slot++)
+            {
+                auto row = target_addresses.begin() + slot * stride;
+                matched[slot] = std::none_of(row, row + stride, [](void* addr) { return addr == nullptr; });
+            }
+
+            auto slots = storage->target_slots();
+            auto offsets = storage->source_offsets();
+            matched_slots.clear();
+            matched_offsets.assign(1, 0);
+            for (size_t source_i = 0; source_i + 1 < offsets.size(); source_i++)
+            {
+                for (uint32_t i = offsets[source_i]; i < offsets[source_i + 1]; i++)
+                    if (matched[slots[i]]) matched_slots.push_back(slots[i]);
+                matched_offsets.push_back(uint32_t(matched_slots.size()));
+            }
+        }
+
+        sequence_cref<uint32_t> matched_targets_of(entity source)
+        {
+            uint32_t index = storage->source_index(source);
+            if (index == relation_storage::absent_index) return {};
+            return sequence_cref<uint32_t>(matched_slots.data() + matched_offsets[index],
+                                           matched_slots.data() + matched_offsets[index + 1]);
+        }
+    };
+
+    template<typename T>
+    struct is_embedded_relation_param
+    {
+        static constexpr bool value =
+                std::is_base_of_v<query_parameter::entity_relation_param, T> ||
+                std::is_base_of_v<query_parameter::entity_multi_relation_param, T>;
+    };
+
+    //the callable the query runs for an executer with relation parameters, the parameters of the row are
+    //passed through and the relation parameters are built from the bindings, in parameter order
+    template<typename Callable, typename RowParams>
+    class relation_row_invoker;
+
+    template<typename Callable, typename... RowParams>
+    class relation_row_invoker<Callable, type_list<RowParams...>>
+    {
+        using params = typename function_traits<std::decay_t<Callable>>::args;
+        using relation_params = typename params::template filter_with<is_embedded_relation_param>;
+
+        static constexpr auto relation_mask = []<typename... P>(type_list<P...>)
+        {
+            return std::array<bool, sizeof...(P)>{is_embedded_relation_param<P>::value...};
+        }(params{});
+
+        //the number of relation parameters before the parameter
+        static constexpr size_t relations_before(size_t param_i)
+        {
+            size_t count = 0;
+            for (size_t i = 0; i < param_i; i++) count += relation_mask[i];
+            return count;
+        }
+
+        Callable& m_callable;
+        relation_binding* m_bindings;
+
+        template<typename R>
+        std::optional<R> make_relation(entity source, relation_binding& binding)
+        {
+            static_assert(R::accessable::size == R::query_param::size,
+                          "filters on the targets are not supported by executer");
+            auto slots = binding.matched_targets_of(source);
+            if constexpr (std::is_base_of_v<query_parameter::entity_multi_relation_param, R>)
+            {
+                return R(slots.begin(), slots.size(), binding.storage->targets().begin(), binding.target_addresses.data());
+            }
+            else
+            {
+                //a row with no target is skipped
+                if (slots.size() == 0) return std::nullopt;
+                uint32_t slot = slots[0];
+                return R::from_addresses(binding.storage->targets()[slot],
+                                         binding.target_addresses.data() + size_t(slot) * R::accessable::size);
+            }
+        }
+
+        template<size_t... I>
+        auto make_relations(entity source, std::index_sequence<I...>)
+        {
+            return std::tuple<std::optional<typename relation_params::template get<I>>...>{
+                make_relation<typename relation_params::template get<I>>(source, m_bindings[I])...};
+        }
+
+        template<size_t... I>
+        void invoke(entity source, std::tuple<RowParams&...>& row, std::index_sequence<I...>)
+        {
+            auto relations = make_relations(source, std::make_index_sequence<relation_params::size>{});
+            bool complete = std::apply([](auto&... relation) { return (relation.has_value() && ...); }, relations);
+            if (!complete) return;
+
+            auto arg = [&]<size_t P>(std::integral_constant<size_t, P>) -> decltype(auto)
+            {
+                if constexpr (relation_mask[P])
+                    return *std::move(std::get<relations_before(P)>(relations));
+                else
+                {
+                    using row_param = typename params::template get<P>;
+                    return std::forward<row_param>(std::get<P - relations_before(P)>(row));
+                }
+            };
+            m_callable(arg(std::integral_constant<size_t, I>{})...);
+        }
+
+    public:
+        relation_row_invoker(Callable& callable, relation_binding* bindings)
+            : m_callable(callable), m_bindings(bindings)
+        {
+        }
+
+        void operator()(entity source, RowParams... row)
+        {
+            std::tuple<RowParams&...> row_refs(row...);
+            invoke(source, row_refs, std::make_index_sequence<params::size>{});
+        }
+    };
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "ecs/type/component.h"
+
+namespace hyecs
+{
+    //the components a system reads and writes, for ordering the systems of a frame
+    //a write<T> parameter is in writes only, the system does not read T so it does not wait for the data of
+    //the earlier writers of T, only for their order
+    struct system_access
+    {
+        vector<component_type_index> reads; //sorted
+        vector<component_type_index> writes; //sorted
+
+        //true when this system must run after the earlier one
+        bool depends_on(const system_access& earlier) const
+        {
+            return intersects(reads, earlier.writes) ||
+                   intersects(writes, earlier.reads) ||
+                   intersects(writes, earlier.writes);
+        }
+
+        //true when this system reads the data written by the earlier one
+        bool reads_from(const system_access& earlier) const
+        {
+            return intersects(reads, earlier.writes);
+        }
+
+    private:
+        static bool intersects(const vector<component_type_index>& a, const vector<component_type_index>& b)
+        {
+            auto iter_a = a.begin();
+            auto iter_b = b.begin();
+            while (iter_a != a.end() && iter_b != b.end())
+            {
+                if (*iter_a < *iter_b) ++iter_a;
+                else if (*iter_b < *iter_a) ++iter_b;
+                else return true;
+            }
+            return false;
+        }
+    };
+}
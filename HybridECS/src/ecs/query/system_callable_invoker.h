@@ -2,6 +2,7 @@
 #include "ecs/type/entity.h"
 #include "ecs/type/component.h"
 #include "ecs/storage/storage_key.h"
+#include "query_api.h"
 
 namespace hyecs
 {
@@ -51,30 +52,166 @@ namespace hyecs
 		// };
 	}
 	
+	//a parameter bound to components of the row, a static component, write<T>, optional<T> or variant<T...>
+	//width is the number of entries the parameter takes in the access list
+	//radix is the number of ways a storage can resolve it, present or absent for an optional,
+	//the held alternative for a variant, cached or streaming stores for a write
+	template<typename T>
+	struct access_param_traits
+	{
+		static constexpr bool is_access = is_static_component<T>::value;
+		static constexpr bool is_optional = false;
+		static constexpr bool is_variant = false;
+		static constexpr bool is_write = false;
+		static constexpr uint32_t width = 1;
+		static constexpr uint32_t radix = 1;
+		using component = std::decay_t<T>;
+	};
+
+	template<typename T>
+	struct access_param_traits<query_parameter::write<T>> : access_param_traits<T&>
+	{
+		static constexpr bool is_access = true;
+		static constexpr bool is_write = true;
+		static constexpr uint32_t radix = memory::streamable<T> ? 2 : 1;
+	};
+
+	template<typename T>
+	struct access_param_traits<query_parameter::optional<T>> : access_param_traits<T>
+	{
+		static constexpr bool is_access = true;
+		static constexpr bool is_optional = true;
+		static constexpr uint32_t radix = 2;
+	};
+
+	template<typename... T>
+	struct access_param_traits<query_parameter::variant<T...>>
+	{
+		static constexpr bool is_access = true;
+		static constexpr bool is_optional = false;
+		static constexpr bool is_variant = true;
+		static constexpr bool is_write = false;
+		static constexpr uint32_t width = sizeof...(T);
+		static constexpr uint32_t radix = sizeof...(T);
+	};
+
+	template<typename T>
+	struct is_access_param { static constexpr bool value = access_param_traits<T>::is_access; };
+
+	//the storage index of an optional or variant component the storage does not have
+	inline constexpr uint32_t absent_component_index = std::numeric_limits<uint32_t>::max();
+
 	template <typename Callable>
 	class system_callable_invoker
 	{
 		Callable m_callable;
 
+		using params = typename function_traits<std::decay_t<Callable>>::args;
+		using access_param = typename params::template filter_with<is_access_param>;
+
+		//the resolution of a storage is a mixed radix number with a digit per accessed parameter
+		template<typename>
+		struct access_layout;
+
+		template<typename... P>
+		struct access_layout<type_list<P...>>
+		{
+			static constexpr std::array<uint32_t, sizeof...(P)> widths{access_param_traits<P>::width...};
+			static constexpr std::array<uint32_t, sizeof...(P)> radices{access_param_traits<P>::radix...};
+			static constexpr std::array<bool, sizeof...(P)> writes{access_param_traits<P>::is_write...};
+
+			//the first entry of the parameter in the access list
+			static constexpr uint32_t offset(size_t param_i)
+			{
+				uint32_t offset = 0;
+				for (size_t i = 0; i < param_i; i++) offset += widths[i];
+				return offset;
+			}
+
+			static constexpr uint32_t stride(size_t param_i)
+			{
+				uint32_t stride = 1;
+				for (size_t i = 0; i < param_i; i++) stride *= radices[i];
+				return stride;
+			}
+
+			static constexpr uint32_t digit(uint32_t resolution, size_t param_i)
+			{
+				return resolution / stride(param_i) % radices[param_i];
+			}
+
+			static constexpr uint32_t resolution_count = stride(sizeof...(P));
+
+			static constexpr bool streams(uint32_t resolution)
+			{
+				for (size_t i = 0; i < sizeof...(P); i++)
+					if (writes[i] && digit(resolution, i) != 0) return true;
+				return false;
+			}
+		};
+
+		using layout = access_layout<access_param>;
+		static_assert(layout::resolution_count <= 256, "too many optional and variant combinations to specialize");
+
 	public:
 		system_callable_invoker(Callable&& callable)
 			: m_callable(std::forward<Callable>(callable))
 		{
 		}
 
+		//which optional components a storage has, which alternative of each variant it holds and which written
+		//columns are large enough for streaming stores, access_indices are the storage indices of the access list
+		//row_count is the contiguous rows of the call, paths with scattered rows pass 0 to keep the stores cached
+		uint32_t resolve(sequence_cref<uint32_t> access_indices, size_t row_count) const
+		{
+			uint32_t resolution = 0;
+			for_each_type_indexed([&]<typename P, size_t I>(type_wrapper<P>, std::integral_constant<size_t, I>)
+			{
+				using traits = access_param_traits<P>;
+				constexpr uint32_t offset = layout::offset(I);
+				if constexpr (traits::is_optional)
+				{
+					if (access_indices[offset] != absent_component_index)
+						resolution += layout::stride(I);
+				}
+				else if constexpr (traits::is_variant)
+				{
+					uint32_t alternative = 0;
+					while (alternative < traits::width && access_indices[offset + alternative] == absent_component_index)
+						alternative++;
+					//the any condition of the variant assures one of the alternatives
+					assert(alternative < traits::width);
+					resolution += alternative * layout::stride(I);
+				}
+				else if constexpr (traits::is_write && traits::radix > 1)
+				{
+					if (memory::prefer_streaming<typename traits::component>(row_count))
+						resolution += layout::stride(I);
+				}
+			}, access_param{});
+			return resolution;
+		}
 
-	private:
-
+		//calls body with the resolution of the storage as a constant, so the loop in body is instantiated
+		//for each resolution with no per entity check of the optional and variant components
+		template <typename Body>
+		void specialize(sequence_cref<uint32_t> access_indices, size_t row_count, Body&& body) const
+		{
+			const uint32_t resolution = resolve(access_indices, row_count);
+			[&]<uint32_t... R>(std::integer_sequence<uint32_t, R...>)
+			{
+				((resolution == R ? (body(std::integral_constant<uint32_t, R>{}), true) : false) || ...);
+			}(std::make_integer_sequence<uint32_t, layout::resolution_count>{});
+			if (layout::streams(resolution)) memory::stream_fence();
+		}
 
-		template <typename GetEntity, typename GetStorageKey, typename GetAddress, typename... Args>
+	private:
+		template <uint32_t Resolution, typename GetEntity, typename GetStorageKey, typename GetAddress, typename... Args>
 		auto invoke_impl(GetEntity get_entity,
 			GetStorageKey get_storage_key,
 			GetAddress get_address,
 			type_list<Args...>)
 		{
-			using params = type_list<Args...>;
-			using component_param = typename params::template filter_with<is_static_component>;
-			using non_component_param = typename params::template filter_without<is_static_component>;
 			auto get_param = [&](auto type) -> decltype(auto)
 			{
 				using param_type = typename decltype(type)::type;
@@ -82,9 +219,41 @@ namespace hyecs
 
 				if constexpr (is_static_component<param_type>::value)
 				{
-					void* data = get_address(type, component_param::template index_of<param_type>);
+					constexpr uint32_t offset = layout::offset(access_param::template index_of<param_type>);
+					void* data = get_address(type, offset);
 					return static_cast<param_type>(*static_cast<base_type*>(data));
 				}
+				else if constexpr (is_access_param<param_type>::value)
+				{
+					using traits = access_param_traits<param_type>;
+					constexpr size_t param_i = access_param::template index_of<param_type>;
+					constexpr uint32_t offset = layout::offset(param_i);
+					if constexpr (traits::is_variant)
+					{
+						constexpr uint32_t alternative = layout::digit(Resolution, param_i);
+						using alternative_type = typename param_type::types::template get<alternative>;
+						return param_type(alternative, get_address(type_wrapper<alternative_type>{}, offset + alternative));
+					}
+					else if constexpr (traits::is_optional)
+					{
+						using component = typename traits::component;
+						if constexpr (layout::digit(Resolution, param_i) != 0)
+							return param_type(static_cast<component*>(get_address(type, offset)));
+						else
+							return param_type(nullptr);
+					}
+					else
+					{
+						using component = typename traits::component;
+						constexpr bool streaming = layout::digit(Resolution, param_i) != 0;
+						return param_type(*static_cast<component*>(get_address(type, offset)), streaming);
+					}
+				}
+				else if constexpr (std::is_base_of_v<query_parameter::filter_param, param_type>)
+				{
+					//filters are resolved by the query
+					return param_type{};
+				}
 				else
 				{
 					if constexpr (std::is_same_v<param_type, entity>)
@@ -99,16 +268,21 @@ namespace hyecs
 		}
 
 	public:
-		template <typename GetEntity, typename GetStorageKey, typename GetAddress>
+		//get_address(type_wrapper<T>, index) gives the address of the entry at index of the access list
+		//Resolution comes from specialize, the absent optional components are never asked for
+		template <uint32_t Resolution, typename GetEntity, typename GetStorageKey, typename GetAddress>
 		auto invoke(GetEntity&& get_entity, GetStorageKey&& get_storage_key, GetAddress&& get_address)
 		{
-			using args = typename function_traits<Callable>::args;
-			invoke_impl(std::forward<GetEntity>(get_entity),
+			invoke_impl<Resolution>(std::forward<GetEntity>(get_entity),
                         std::forward<GetStorageKey>(get_storage_key),
                         std::forward<GetAddress>(get_address),
-                        args{});
+                        params{});
 		}
 
 
 	};
+
+	//an lvalue callable is held by reference
+	template <typename Callable>
+	system_callable_invoker(Callable&&) -> system_callable_invoker<Callable>;
 }
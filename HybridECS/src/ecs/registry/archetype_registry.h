@@ -15,6 +15,7 @@ namespace hyecs
 
 		vaildref_map<archetype_query_index, archetype_query_node> m_archetype_query_nodes;
 		vaildref_map<query_index, query_node> m_query_nodes;
+		component_match_index m_match_index;
 
 		function<void(archetype_index)> m_untag_archetype_addition_callback;
 		function<void(archetype_index, archetype_index)> m_tag_archetype_addition_callback;
@@ -203,20 +204,16 @@ namespace hyecs
 		void try_add_arch_query_to_subquery(
 			query_node* subquery,
 			const archetype_query_node* arch_query,
-			archetype_index arch,
-			const query_condition* base_condition_opt = nullptr,
-			const query_condition* tag_condition_opt = nullptr
+			archetype_index arch
 		)
 		{
 			decltype(auto) condition = subquery->condition();
-			std::optional<query_condition> base_condition_stack = std::nullopt;
-			if (!base_condition_opt) base_condition_stack = condition.base_incomplete_condition();
-			auto& base_condition = base_condition_opt ? *base_condition_opt : base_condition_stack.value();
+			auto& base_condition = subquery->base_incomplete_condition();
 
 			// base filter
 			if (!base_condition.match_all_none(arch)) return;
 
-			query_condition tag_condition = tag_condition_opt ? *tag_condition_opt : condition.tag_incomplete_condition();
+			auto& incomplete_tag_condition = subquery->tag_incomplete_condition();
 
 			const auto& comp_mask = arch.component_mask();
 			small_vector<uint32_t> maintain_any_index;
@@ -227,7 +224,7 @@ namespace hyecs
 				auto& any = anys[i];
 				if (!query_condition::match_any(comp_mask, any))//if any is empty it will be remove
                 {
-                    if (!tag_condition.anys()[i].empty())
+                    if (!incomplete_tag_condition.anys()[i].empty())
                         maintain_any_index.push_back(i);
                     else
                         return;
@@ -235,13 +232,14 @@ namespace hyecs
 			}
 
 			if (maintain_any_index.empty())
-				if (tag_condition.all().empty() && tag_condition.none().empty())
+				if (incomplete_tag_condition.all().empty() && incomplete_tag_condition.none().empty())
 				{
 					assert(arch_query->is_direct_set());
 					subquery->add_matched(arch_query);
 					return;
 				}
 			// tag filter
+			query_condition tag_condition = incomplete_tag_condition;
 			tag_condition.filter_anys_by_index(maintain_any_index);
 			tag_condition.completion();
 			//find or create new tag_archetype_node
@@ -273,53 +271,15 @@ namespace hyecs
 			}
 			archetype_query_node* full_node = add_archetype_node(arch);
 
-
-
-			uint64_t iterate_version = sequence_allocator<query_node>::allocate();
-
-			//update for original arch related queries
-			if (!origin_arch.empty())
-			{
-				auto& origin_arch_node = m_archetype_nodes.at(origin_arch.hash());
-				if (removings.size() != 0)
-					for (auto query : origin_arch_node.related_queries())
-					{
-						query->iterate_version = iterate_version;
-						try_add_arch_query_to_subquery(query, full_node, arch);
-					}
-				else
-					for (auto query : origin_arch_node.related_queries())
-					{
-						query->iterate_version = iterate_version;
-						if (query->type() == query_node::untag)//optimize for untag case
-						{
-							if (query->condition().match_none(arch))
-								query->add_matched(full_node);
-						}
-						else //mixed
-						{
-							try_add_arch_query_to_subquery(query, full_node, arch);
-						}
-					}
-
-			}
-
-			//single layer iteration : subquery try add
-			for (decltype(auto) component : adding)
+			//the candidates are the queries keyed on the components of the archetype, a query is keyed once so it is visited once
+			//the origin does not matter, a query matching the archetype is keyed on one of its components
+			for (auto component : arch)
 			{
-				auto com_node_hash = archetype::addition_hash(0, { component });
-				assert(m_query_nodes.contains(com_node_hash));
-				query_node* com_node_index = &m_query_nodes.at(com_node_hash);
-
-				com_node_index->add_matched(full_node);
-				for (auto query_node : com_node_index->subquery_nodes())
-				{
-					if (query_node->iterate_version == iterate_version) continue;
-					query_node->iterate_version = iterate_version;
-
+				assert(m_query_nodes.contains(component.hash()));
+				m_query_nodes.at(component.hash()).add_matched(full_node);
+				for (auto query_node : m_match_index.queries(component))
 					try_add_arch_query_to_subquery(query_node, full_node, arch);
-
-				}
+				m_match_index.add_archetype(component, full_node);
 			}
 
 			return full_node;
@@ -344,12 +304,10 @@ namespace hyecs
 			{
 				if (!comp.is_tag()) untag_removings_vec.push_back(comp);
 			}
-			vector<component_type_index> tag_adding_vec;
 			vector<component_type_index> untag_adding_vec;
 			for (decltype(auto) comp : adding)
 			{
-				if (comp.is_tag()) tag_adding_vec.push_back(comp);
-				else untag_adding_vec.push_back(comp);
+				if (!comp.is_tag()) untag_adding_vec.push_back(comp);
 			}
 
 
@@ -378,24 +336,18 @@ namespace hyecs
 			invoke_tag_archetype_addition(arch, base_arch_node->archetype());
 			//add to direct set this will dispatch to all sub-archetype_query_node
 			base_arch_full_q_node->add_matched(tag_arch_node);
-			//for pure tag queries
-			uint64_t iterate_version = sequence_allocator<query_node>::allocate();
-			for (decltype(auto) component : tag_adding_vec)
+			//for pure tag queries, from every tag of the archetype as the tags of the origin may complete a query too
+			for (decltype(auto) component : arch)
 			{
-				auto com_node_hash = archetype::addition_hash(0, { component });
-				assert(m_query_nodes.contains(com_node_hash));
-				query_node* com_node_index = &m_query_nodes.at(com_node_hash);
-
-				add_tag_to_pure_tag_query(com_node_index, tag_arch_node);
-
-				for (auto query_node : com_node_index->subquery_nodes())
+				if (!component.is_tag()) continue;
+				assert(m_query_nodes.contains(component.hash()));
+				add_tag_to_pure_tag_query(&m_query_nodes.at(component.hash()), tag_arch_node);
+				for (auto query_node : m_match_index.queries(component))
 				{
-					if (query_node->iterate_version == iterate_version) continue;
-					query_node->iterate_version = iterate_version;
-
 					if (query_node->condition().match(tag_arch_node->archetype()))
 						add_tag_to_pure_tag_query(query_node, tag_arch_node);
 				}
+				m_match_index.add_tag_archetype(component, tag_arch_node);
 			}
 
 
@@ -420,74 +372,26 @@ namespace hyecs
 
 			query_node* node = &m_query_nodes.emplace(hash, query_node(condition, q_type));
 			invoke_query_addition(node);
-			// select for initial set
-			const query_node::archetype_nodes_t* initial_set = nullptr;
-			size_t min_initial_set_size = std::numeric_limits<size_t>::max();
 
-			auto& search_condition_all = q_type == query_node::pure_tag ? tag_condition.all() : base_condition.all();
-			for (auto c : search_condition_all)
-			{
-				assert(m_query_nodes.contains(c.hash()));
-				query_node* component_node = &m_query_nodes.at(c.hash());
-				component_node->add_subquery(node);
-				if (component_node->archetype_query_nodes().size() < min_initial_set_size)
-				{
-					initial_set = &component_node->archetype_query_nodes();
-					min_initial_set_size = initial_set->size();
-				}
-			}
+			//rarest first, the archetypes of the component with the fewest archetypes are verified by the masks
+			auto& search_condition_all = q_type == query_node::pure_tag
+				? node->tag_incomplete_condition().all()
+				: node->base_incomplete_condition().all();
+			component_type_index rarest = m_match_index.rarest(search_condition_all);
+			assert(m_query_nodes.contains(rarest.hash()));
+			m_match_index.add_query(rarest, node);
 
 			if (q_type != query_node::pure_tag)
 			{
-				for (auto& [arch_node, arch_q_node] : *initial_set)
-				{
-					try_add_arch_query_to_subquery(node, arch_q_node, arch_node->archetype(), &base_condition, &tag_condition);
-					//// base filter
-					//if (!base_condition.match_all_none(arch_node->archetype()))
-					//	continue;
-					//const auto& comp_mask = arch_node->archetype().component_mask();
-					//small_vector<uint32_t> maintain_any_index;
-					//bool discard = false;
-					//auto& anys = condition.anys();
-					//for (uint32_t i = 0; i < anys.size(); i++)
-					//{
-					//	auto& any = anys[i];
-					//	if (!query_condition::match_any(comp_mask, any))
-					//		if (!tag_condition.anys()[i].empty())
-					//		{
-					//			maintain_any_index.push_back(i);
-					//		}
-					//		else
-					//		{
-					//			discard = true;
-					//			break;
-					//		}
-					//}
-					//if (discard) continue;
-
-					//if (maintain_any_index.empty())
-					//	if (tag_condition.all().empty() && tag_condition.none().empty())
-					//	{
-					//		assert(arch_q_node->is_direct_set());
-					//		node->add_matched(arch_q_node);
-					//		continue;
-					//	}
-					//// tag filter
-					//tag_condition.filter_anys_by_index(maintain_any_index);
-					////find or create new tag_archetype_node
-					//node->add_matched(get_archetype_query_node(arch_q_node, node, tag_condition));
-
-				}
+				for (auto arch_q_node : m_match_index.archetypes(rarest))
+					try_add_arch_query_to_subquery(node, arch_q_node, arch_q_node->archetype_node()->archetype());
 			}
 			else // pure_tag
 			{
-				for (auto& [arch_node, q_node] : *initial_set)
+				for (auto tag_node : m_match_index.tag_archetypes(rarest))
 				{
-					for (auto tag_node : q_node->tag_archetype_nodes())
-					{
-						if (node->condition().match(tag_node->archetype()))
-							add_tag_to_pure_tag_query(node, tag_node);
-					}
+					if (node->condition().match(tag_node->archetype()))
+						add_tag_to_pure_tag_query(node, tag_node);
 				}
 			}
 
@@ -535,6 +439,8 @@ namespace hyecs
 			const auto query_node = get_ingroup_query(condition);
 			return query_node->condition().hash();
 		}
+
+		const component_match_index& match_index() const { return m_match_index; }
 	};
 
 
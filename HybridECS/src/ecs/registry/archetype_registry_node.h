@@ -237,8 +237,10 @@ namespace hyecs
 
 	private:
 		query_condition m_condition;
+		//split once here, the matching checks them for every candidate archetype
+		query_condition m_base_incomplete_condition;
+		query_condition m_tag_incomplete_condition;
 		archetype_nodes_t m_archetype_query_nodes;
-		vector<query_node*> m_subquery_nodes;
 
 		vector<callback_t> m_archetype_query_addition_callbacks;
 
@@ -252,12 +254,18 @@ namespace hyecs
 
 	public:
 		query_node(sequence_cref<component_type_index> component_types, query_type type)
-			: m_condition(component_types), m_type(type)
+			: m_condition(component_types),
+			m_base_incomplete_condition(m_condition.base_incomplete_condition()),
+			m_tag_incomplete_condition(m_condition.tag_incomplete_condition()),
+			m_type(type)
 		{
 		}
 
 		query_node(const query_condition& condition, query_type type)
-			: m_condition(condition), m_type(type)
+			: m_condition(condition),
+			m_base_incomplete_condition(m_condition.base_incomplete_condition()),
+			m_tag_incomplete_condition(m_condition.tag_incomplete_condition()),
+			m_type(type)
 		{
 		}
 		query_node(query_node&) = delete;
@@ -265,8 +273,9 @@ namespace hyecs
 
 		query_type type() const { return m_type; }
 		const archetype_nodes_t& archetype_query_nodes() const { return m_archetype_query_nodes; }
-		const vector<query_node*>& subquery_nodes() const { return m_subquery_nodes; }
 		const query_condition& condition() const { return m_condition; }
+		const query_condition& base_incomplete_condition() const { return m_base_incomplete_condition; }
+		const query_condition& tag_incomplete_condition() const { return m_tag_incomplete_condition; }
 
 		query_condition tag_condition() const
 		{
@@ -289,8 +298,6 @@ namespace hyecs
 			m_archetype_query_addition_callbacks.emplace_back(std::move(callback));
 		}
 
-		void add_subquery(query_node* subquery) { m_subquery_nodes.push_back(subquery); }
-
 		void add_matched(const archetype_query_node* node)
 		{
 			assert(
@@ -303,9 +310,78 @@ namespace hyecs
 				node->archetype_node()->add_related_query(this); //bidirectional
 			publish_archetype_addition(node->query_index());
 		}
+	};
+
+	//inverted indexes of the in group matching, by the dense component id
+	//a query is keyed on a single component of its searched all set, the one with the fewest archetypes at registration
+	//so a new archetype visits each candidate query once, from the components it holds
+	class component_match_index
+	{
+		struct entry
+		{
+			vector<archetype_query_node*> archetypes; //direct nodes of the base archetypes holding the component
+			vector<tag_archetype_node*> tag_archetypes; //tag archetypes holding the tag
+			vector<query_node*> queries; //queries keyed on the component
+		};
+
+		vector<entry> m_entries;
+
+		entry& entry_of(component_type_index component)
+		{
+			if (component.id() >= m_entries.size())
+				m_entries.resize(component.id() + 1);
+			return m_entries[component.id()];
+		}
+
+		const entry& find_entry(component_type_index component) const
+		{
+			static const entry empty;
+			return component.id() < m_entries.size() ? m_entries[component.id()] : empty;
+		}
 
 	public:
-		uint64_t iterate_version = std::numeric_limits<uint64_t>::max();
+		void add_archetype(component_type_index component, archetype_query_node* node)
+		{
+			entry_of(component).archetypes.push_back(node);
+		}
+
+		void add_tag_archetype(component_type_index component, tag_archetype_node* node)
+		{
+			entry_of(component).tag_archetypes.push_back(node);
+		}
+
+		void add_query(component_type_index component, query_node* node)
+		{
+			entry_of(component).queries.push_back(node);
+		}
+
+		const vector<archetype_query_node*>& archetypes(component_type_index component) const
+		{
+			return find_entry(component).archetypes;
+		}
+
+		const vector<tag_archetype_node*>& tag_archetypes(component_type_index component) const
+		{
+			return find_entry(component).tag_archetypes;
+		}
+
+		const vector<query_node*>& queries(component_type_index component) const
+		{
+			return find_entry(component).queries;
+		}
+
+		//archetypes holding the component, the tag archetypes for a tag
+		size_t archetype_count(component_type_index component) const
+		{
+			return component.is_tag() ? tag_archetypes(component).size() : archetypes(component).size();
+		}
+
+		//the component with the fewest archetypes, the components must not be empty
+		component_type_index rarest(sequence_cref<component_type_index> components) const
+		{
+			assert(components.size() != 0);
+			return *std::ranges::min_element(components, {}, [this](component_type_index c) { return archetype_count(c); });
+		}
 	};
 
 
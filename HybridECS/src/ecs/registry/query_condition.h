@@ -59,7 +59,6 @@ namespace hyecs
 			Filter filter,
 			Complete = {}
 		)
-			: all_bitset_(all), none_bitset_(none)
 		{
 			size_t total_size = all.size() + none.size();
 			for (auto& any : anys) total_size += any.size();
@@ -89,6 +88,9 @@ namespace hyecs
 				auto& any_ = anys_.emplace_back();
 				append_cond(any, any_);
 			}
+			//masks of the filtered part, a base condition must not carry the tags
+			for (auto comp : all_) all_bitset_.insert(comp);
+			for (auto comp : none_) none_bitset_.insert(comp);
 
 			if (Complete::value)
 				compute_hash();
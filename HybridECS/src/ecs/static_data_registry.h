@@ -8,6 +8,14 @@ namespace hyecs
     {
     public:
         using data_registry::data_registry;
+        using data_registry::get_component_storage;
+
+        template<typename T>
+        component_storage& get_component_storage()
+        {
+            static const component_type_index index = m_component_type_infos.at(type_hash::of<T>());
+            return data_registry::get_component_storage(index);
+        }
 
         template<typename... T>
         auto get_sorted_component_types() -> const std::array<std::pair<size_t, component_type_index>, sizeof...(T)>&
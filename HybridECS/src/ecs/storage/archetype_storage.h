@@ -16,6 +16,15 @@ namespace hyecs
             Chunk,
         };
 
+        //incremental conversion runs in a dual state:
+        //the table lives in m_table and the sparse side in m_conversion_sparse until all entities are migrated
+        enum class conversion_state : uint8_t
+        {
+            none,
+            sparse_to_chunk,
+            chunk_to_sparse,
+        };
+
         archetype_index m_index;
         vector<component_type_index> m_notnull_components; //cache from m_component_storages
         vector<component_storage*> m_component_storages; //store for chunk to sparse convert
@@ -29,22 +38,36 @@ namespace hyecs
         //add and remove event are inside the m_table
         // vector<function<void(entity, storage_key)>> m_on_entity_add;
         // vector<function<void(entity, storage_key)>> m_on_entity_remove;
-        vector<function<void(entity, storage_key, storage_key)>> m_on_entity_move; //from, to
+        vector<function<void(sequence_cref<entity>, sequence_cref<storage_key>)>> m_on_entities_move; //moved inside the table, new keys
         vector<function<void()>> m_on_sparse_to_chunk;
         vector<function<void()>> m_on_chunk_to_sparse;
+        vector<function<void()>> m_on_conversion_begin;
 
-        uint32_t sparse_to_chunk_convert_limit;
-        uint32_t chunk_to_sparse_convert_limit;
+        conversion_state m_conversion = conversion_state::none;
+        bool m_incremental_conversion = false;
+        std::unique_ptr<sparse_table> m_conversion_sparse;
+        vector<entity> m_conversion_entities; //batch cache
+        vector<storage_key::table_offset_t> m_conversion_offsets; //batch cache
+
+        storage_policy m_storage_policy;
+        storage_access_profile m_access_profile;
+        uint32_t m_chunk_capacity;
+        size_t m_chunk_size;
+        chunk_arena* m_chunk_arena;
 
     public:
         archetype_storage(
                 archetype_index index,
                 sorted_sequence_cref<component_storage*> component_storages,
-                storage_key_registry::group_key_accessor key_registry)
+                storage_key_registry::group_key_accessor key_registry,
+                size_t chunk_size = component_table_chunk_traits::size,
+                chunk_arena* arena = nullptr)
                 : m_index(index),
                   m_component_storages(component_storages),
                   m_table(sparse_table(component_storages)),
-                  m_key_registry(key_registry)
+                  m_key_registry(key_registry),
+                  m_chunk_size(chunk_size),
+                  m_chunk_arena(arena)
         {
             m_notnull_components.reserve(component_storages.size());
             for (uint64_t i = 0; i < component_storages.size(); ++i)
@@ -54,17 +77,7 @@ namespace hyecs
             size_t components_size = sizeof(entity);
             for (auto& comp: index)
                 components_size += comp.size();
-
-            if (component_storages.size() > 1)
-            {
-                sparse_to_chunk_convert_limit = component_table_chunk_traits::size / components_size;
-                chunk_to_sparse_convert_limit = sparse_to_chunk_convert_limit / 2;
-            }
-            else
-            {
-                sparse_to_chunk_convert_limit = std::numeric_limits<uint32_t>::max();
-                chunk_to_sparse_convert_limit = 0;
-            }
+            m_chunk_capacity = chunk_size_policy::chunk_capacity(m_chunk_size, components_size);
         }
 
     public:
@@ -74,12 +87,125 @@ namespace hyecs
             return m_index;
         }
 
+        size_t chunk_size() const
+        {
+            return m_chunk_size;
+        }
+
         size_t entity_count() const
         {
-            return std::visit([](auto& t)
-                              {
-                                  return t.entity_count();
-                              }, m_table);
+            size_t count = std::visit([](auto& t)
+                                      {
+                                          return t.entity_count();
+                                      }, m_table);
+            if (m_conversion_sparse) count += m_conversion_sparse->entity_count();
+            return count;
+        }
+
+        bool is_converting() const
+        {
+            return m_conversion != conversion_state::none;
+        }
+
+        //convert through begin_*/step_conversion instead of converting at once when the threshold is crossed
+        void set_incremental_conversion(bool incremental)
+        {
+            m_incremental_conversion = incremental;
+        }
+
+        void set_storage_policy(const storage_policy& policy)
+        {
+            bool was_profiling = m_storage_policy.profile_random_access;
+            m_storage_policy = policy;
+            if (was_profiling == policy.profile_random_access) return;
+            //sync the sparse entity tracking with the new policy
+            auto track = [&](sparse_table& t)
+            {
+                for (auto e: t.get_entities())
+                {
+                    if (policy.profile_random_access) m_key_registry.track_sparse_entity(e, &m_access_profile);
+                    else m_key_registry.untrack_sparse_entity(e);
+                }
+            };
+            if (auto* sparse = std::get_if<sparse_table>(&m_table)) track(*sparse);
+            if (m_conversion_sparse) track(*m_conversion_sparse);
+        }
+
+        const storage_policy& get_storage_policy() const
+        {
+            return m_storage_policy;
+        }
+
+        const storage_access_profile& access_profile() const
+        {
+            return m_access_profile;
+        }
+
+        void record_sequential_access(size_t count)
+        {
+            m_access_profile.record_sequential(count);
+        }
+
+        storage_layout layout() const
+        {
+            return get_storage_type() == storage_type::Chunk ? storage_layout::chunk : storage_layout::sparse;
+        }
+
+        //the layout the policy asks for with the given entity count
+        storage_layout select_layout(size_t entity_count) const
+        {
+            return m_storage_policy.select(storage_policy_context{
+                    .layout = layout(),
+                    .entity_count = entity_count,
+                    .chunk_capacity = m_chunk_capacity,
+                    .component_count = m_component_storages.size(),
+                    .profile = m_access_profile
+            });
+        }
+
+        //convert to the layout selected by the policy, the table must not have holes to go back to sparse
+        void update_storage_layout()
+        {
+            if (is_converting()) return;
+            m_access_profile.decay(m_storage_policy.profile_window);
+            storage_layout target = select_layout(entity_count());
+            if (target == layout()) return;
+            if (target == storage_layout::chunk)
+            {
+                if (m_incremental_conversion) begin_sparse_to_chunk();
+                else sparse_convert_to_chunk();
+            }
+            else if (!std::get<table>(m_table).has_holes())
+            {
+                if (m_incremental_conversion) begin_chunk_to_sparse();
+                else chunk_convert_to_sparse();
+            }
+        }
+
+        //the component data of the sparse side is reported by the component storages
+        archetype_memory_info memory_info() const
+        {
+            archetype_memory_info info;
+            info.layout = layout();
+            info.converting = is_converting();
+            info.entity_count = entity_count();
+            info.chunk_capacity = m_chunk_capacity;
+            info.chunk_size = m_chunk_size;
+            if (const table* tb = std::get_if<table>(&m_table))
+            {
+                info.row_count = tb->entity_count();
+                info.chunk_count = tb->chunk_count();
+                info.chunk_capacity = tb->chunk_capacity();
+                info.hole_count = tb->hole_count();
+                info.used_bytes = tb->used_bytes();
+                info.reserved_bytes = tb->reserved_bytes();
+                info.index_bytes += tb->index_memory_usage();
+            }
+            if (const sparse_table* sparse = std::get_if<sparse_table>(&m_table))
+                info.index_bytes += sparse->memory_usage();
+            if (m_conversion_sparse)
+                info.index_bytes += m_conversion_sparse->memory_usage();
+            return info;
         }
 
         const storage_key_registry::group_key_accessor& get_key_registry() const
@@ -123,6 +249,50 @@ namespace hyecs
         }
 
 
+        //component addresses of a single entity, valid in every storage state
+        void components_addresses(entity e, sequence_cref<uint32_t> component_indices, sequence_ref<void*> addresses)
+        {
+            if (table* tb = get_table(); tb && m_key_registry.contains(e))
+            {
+                tb->components_addresses(m_key_registry.at(e), component_indices, addresses);
+                return;
+            }
+            for (uint32_t i = 0; i < component_indices.size(); i++)
+                addresses[i] = component_indices[i] == absent_component_index
+                                   ? nullptr
+                                   : m_component_storages[component_indices[i]]->at(e);
+        }
+
+    private:
+        template<typename SeqParam>
+        void track_sparse_entities(sequence_cref<entity, SeqParam> entities)
+        {
+            if (!m_storage_policy.profile_random_access) return;
+            for (auto e: entities) m_key_registry.track_sparse_entity(e, &m_access_profile);
+        }
+
+        template<typename SeqParam>
+        void untrack_sparse_entities(sequence_cref<entity, SeqParam> entities)
+        {
+            if (!m_storage_policy.profile_random_access) return;
+            for (auto e: entities) m_key_registry.untrack_sparse_entity(e);
+        }
+
+        void attach_table(table& tb)
+        {
+            m_key_registry.register_table(&tb);
+            tb.set_access_profile(&m_access_profile);
+            tb.bind_on_entities_move([this](sequence_cref<entity> entities, sequence_cref<storage_key> keys)
+            {
+                for (size_t i = 0; i < entities.size(); i++)
+                    m_key_registry.update(entities[i], keys[i]);
+                for (const auto& on_entities_move: m_on_entities_move)
+                    on_entities_move(entities, keys);
+            });
+            m_access_profile.conversion_count++;
+        }
+
+    public:
         void bind_on_entity_add(function<void(entity, storage_key)> callback)
         {
             std::visit([&](auto& t)
@@ -146,6 +316,11 @@ namespace hyecs
                 archetype_storage* dest_archetype,
                 sorted_sequence_cref<generic::constructor> adding_constructors)
         {
+            HYECS_TRACE_SCOPE_COUNT("archetype_storage::entity_change_archetype", entities.size());
+            //entities may be split between both sides while converting
+            complete_conversion();
+            dest_archetype->complete_conversion();
+
             auto constructors_iter = adding_constructors.begin();
 
             using src_accessor_variant = std::variant<table::deallocate_accessor, sparse_table::deallocate_accessor>;
@@ -158,6 +333,8 @@ namespace hyecs
                 keys.reserve(entities.size());
                 for (auto e: entities) keys.push_back(m_key_registry.at(e).get_table_offset());
             }
+            else untrack_sparse_entities(entities);
+            if (dest.index() == 1) dest_archetype->track_sparse_entities(entities);
             auto src_accessor_var = std::visit([&](auto& t) -> src_accessor_variant
                                                {
                                                    using table_type = std::decay_t<decltype(t)>;
@@ -231,16 +408,44 @@ namespace hyecs
                            src_accessor.notify_destruct_finish();
                            dest_accessor.notify_construct_finish();
                        }, src_accessor_var, dest_accessor_var);
+
+            //the source may have shrunk below the policy threshold
+            update_storage_layout();
+        }
+
+        //destructs the components of the entities and frees their rows, all entities must be in this storage
+        void destroy_entities(sequence_cref<entity> entities)
+        {
+            HYECS_TRACE_SCOPE_COUNT("archetype_storage::destroy_entities", entities.size());
+            complete_conversion();
+            if (table* tb = get_table())
+            {
+                memory::frame_scope frame;
+                memory::frame_vector<storage_key::table_offset_t> offsets;
+                offsets.reserve(entities.size());
+                for (auto e: entities) offsets.push_back(m_key_registry.at(e).get_table_offset());
+                tb->get_deallocate_accessor(offsets).destruct();
+                for (auto e: entities) m_key_registry.erase(e);
+            }
+            else
+            {
+                untrack_sparse_entities(entities);
+                std::get<sparse_table>(m_table).get_deallocate_accessor(entities).destruct();
+            }
+            update_storage_layout();
         }
 
         //fixme event callback for entity move?
         void sparse_convert_to_chunk()
         {
+            assert(!is_converting());
+            HYECS_TRACE_SCOPE_COUNT("archetype_storage::sparse_convert_to_chunk", entity_count());
             auto sparse_table_ptr = std::make_unique<sparse_table>(std::move(std::get<sparse_table>(m_table)));
             sorted_sequence_cref<component_type_index> components(m_index.begin(), m_index.end());
-            table& tb = m_table.emplace<table>(components);
-            m_key_registry.register_table(&tb);
+            table& tb = m_table.emplace<table>(components, m_chunk_size, m_chunk_arena);
+            attach_table(tb);
             auto& entities = sparse_table_ptr->get_entities();
+            untrack_sparse_entities(sequence_cref(entities.begin(), entities.end()));
 
             auto src_accessor = sparse_table_ptr->get_raw_accessor();
             auto entity_seq = sequence_cref(entities.begin(), entities.end());
@@ -281,18 +486,18 @@ namespace hyecs
 
         void chunk_convert_to_sparse()
         {
+            assert(!is_converting());
+            HYECS_TRACE_SCOPE_COUNT("archetype_storage::chunk_convert_to_sparse", entity_count());
             table* table_ptr = &std::get<table>(m_table);
             m_key_registry.unregister_table(table_ptr);
             auto sparse_ptr = std::make_unique<sparse_table>(sorted_sequence_cref(m_component_storages));
             auto entities = table_ptr->get_entities();
+            m_access_profile.conversion_count++;
+            track_sparse_entities(sequence_cref(entities));
             auto src_accessor = table_ptr->get_raw_accessor();
             auto dest_accessor = sparse_ptr->get_allocate_accessor(
                     sequence_cref(entities),
-                    [this](entity e, storage_key s)
-                    {
-                        //todo may need erase key
-                        // m_key_registry.insert(e, s);//need to set the key to null
-                    });
+                    [](entity, storage_key) {});
 
             auto src_component_accessors = src_accessor.begin();
             auto dest_component_accessors = dest_accessor.begin();
@@ -311,6 +516,8 @@ namespace hyecs
                 dest_component_accessors++;
             }
 
+            //the table index is free for another table, the sparse entities are not keyed
+            for (auto e: entities) m_key_registry.erase(e);
             m_table = std::move(*sparse_ptr);
 
             for (auto& on_chunk_to_sparse: m_on_chunk_to_sparse)
@@ -321,6 +528,173 @@ namespace hyecs
             dest_accessor.construct_finish_external_notified();
         }
 
+    private:
+        template<typename SrcAccessor, typename DestAccessor>
+        static void move_components(SrcAccessor& src_accessor, DestAccessor& dest_accessor)
+        {
+            auto src_component_accessors = src_accessor.begin();
+            auto dest_component_accessors = dest_accessor.begin();
+            while (src_component_accessors != src_accessor.end())
+            {
+                auto src_comp_iter = src_component_accessors.begin();
+                auto dest_comp_iter = dest_component_accessors.begin();
+                component_type_index type = src_component_accessors.component_type();
+                assert(type == dest_component_accessors.component_type());
+                while (src_comp_iter != src_component_accessors.end())
+                {
+                    type.move_constructor(*dest_comp_iter, *src_comp_iter);
+                    src_comp_iter++;
+                    dest_comp_iter++;
+                }
+                src_component_accessors++;
+                dest_component_accessors++;
+            }
+        }
+
+        void finish_conversion()
+        {
+            switch (m_conversion)
+            {
+                case conversion_state::none:
+                    return;
+                case conversion_state::sparse_to_chunk:
+                    assert(m_conversion_sparse->entity_count() == 0);
+                    m_conversion_sparse.reset();
+                    m_conversion = conversion_state::none;
+                    for (const auto& on_sparse_to_chunk: m_on_sparse_to_chunk)
+                        on_sparse_to_chunk();
+                    break;
+                case conversion_state::chunk_to_sparse:
+                {
+                    table* table_ptr = &std::get<table>(m_table);
+                    assert(table_ptr->entity_count() == 0);
+                    m_key_registry.unregister_table(table_ptr);
+                    m_table = std::move(*m_conversion_sparse);
+                    m_conversion_sparse.reset();
+                    m_conversion = conversion_state::none;
+                    for (const auto& on_chunk_to_sparse: m_on_chunk_to_sparse)
+                        on_chunk_to_sparse();
+                }
+                    break;
+            }
+        }
+
+    public:
+        //start a sparse to chunk conversion, entities are migrated by step_conversion
+        //new entities go to the table right away
+        void begin_sparse_to_chunk()
+        {
+            assert(!is_converting());
+            m_conversion_sparse = std::make_unique<sparse_table>(std::move(std::get<sparse_table>(m_table)));
+            sorted_sequence_cref<component_type_index> components(m_index.begin(), m_index.end());
+            table& tb = m_table.emplace<table>(components, m_chunk_size, m_chunk_arena);
+            attach_table(tb);
+            m_conversion = conversion_state::sparse_to_chunk;
+            for (const auto& on_conversion_begin: m_on_conversion_begin)
+                on_conversion_begin();
+        }
+
+        //start a chunk to sparse conversion, entities are migrated by step_conversion
+        //new entities go to the sparse side right away
+        void begin_chunk_to_sparse()
+        {
+            assert(!is_converting());
+            m_conversion_sparse = std::make_unique<sparse_table>(sorted_sequence_cref(m_component_storages));
+            m_access_profile.conversion_count++;
+            m_conversion = conversion_state::chunk_to_sparse;
+            for (const auto& on_conversion_begin: m_on_conversion_begin)
+                on_conversion_begin();
+        }
+
+        //migrate at most max_entities entities, finishes the conversion when nothing is left
+        //returns the number of migrated entities
+        size_t step_conversion(size_t max_entities)
+        {
+            size_t migrated = 0;
+            while (is_converting() && migrated < max_entities)
+            {
+                auto& batch = m_conversion_entities;
+                table& tb = std::get<table>(m_table);
+                if (m_conversion == conversion_state::sparse_to_chunk)
+                {
+                    auto& entities = m_conversion_sparse->get_entities();
+                    if (entities.size() == 0)
+                    {
+                        finish_conversion();
+                        break;
+                    }
+                    size_t count = std::min(max_entities - migrated, entities.size());
+                    batch.assign(entities.end() - count, entities.end());
+                    auto entity_seq = sequence_cref(batch);
+                    auto src_accessor = m_conversion_sparse->get_raw_accessor(entity_seq);
+                    auto dest_accessor = tb.get_allocate_accessor(entity_seq, [this](entity e, storage_key s)
+                    {
+                        m_key_registry.insert(e, s);
+                    });
+                    move_components(src_accessor, dest_accessor);
+                    //same archetype, no add/remove event
+                    dest_accessor.construct_finish_external_notified();
+                    m_conversion_sparse->detach_entities(entity_seq);
+                    untrack_sparse_entities(entity_seq);
+                    migrated += count;
+                    if (m_conversion_sparse->entity_count() == 0) finish_conversion();
+                }
+                else
+                {
+                    if (tb.entity_count() == 0)
+                    {
+                        finish_conversion();
+                        break;
+                    }
+                    tb.tail_rows(max_entities - migrated, batch, m_conversion_offsets);
+                    auto entity_seq = sequence_cref(batch);
+                    auto src_accessor = tb.get_raw_accessor(m_conversion_offsets);
+                    auto dest_accessor = m_conversion_sparse->get_allocate_accessor(entity_seq, [](entity, storage_key) {});
+                    move_components(src_accessor, dest_accessor);
+                    dest_accessor.construct_finish_external_notified();
+                    track_sparse_entities(entity_seq);
+                    tb.pop_tail_rows(batch.size());
+                    for (auto e: batch) m_key_registry.erase(e);
+                    migrated += batch.size();
+                    if (tb.entity_count() == 0) finish_conversion();
+                }
+            }
+            return migrated;
+        }
+
+        void complete_conversion()
+        {
+            step_conversion(std::numeric_limits<size_t>::max());
+        }
+
+        void add_callback_on_entities_move(function<void(sequence_cref<entity>, sequence_cref<storage_key>)>&& callback)
+        {
+            m_on_entities_move.emplace_back(callback);
+        }
+
+        bool is_compact()
+        {
+            table* tb = get_table();
+            return !tb || tb->is_compact();
+        }
+
+        //fill the table holes and release chunks, moving at most max_rows rows between chunks
+        //the layout is re-evaluated once the table is compact
+        //returns the number of rows moved between chunks
+        size_t compact(size_t max_rows = std::numeric_limits<size_t>::max())
+        {
+            table* tb = get_table();
+            if (!tb || is_converting()) return 0;
+            size_t moved = tb->compact(max_rows);
+            if (tb->is_compact()) update_storage_layout();
+            return moved;
+        }
+
+        void add_callback_on_conversion_begin(function<void()>&& callback)
+        {
+            m_on_conversion_begin.emplace_back(callback);
+        }
+
         void add_callback_on_sparse_to_chunk(function<void()>&& callback)
         {
             m_on_sparse_to_chunk.emplace_back(callback);
@@ -510,19 +884,25 @@ namespace hyecs
         template<typename SeqParam>
         auto get_allocate_accessor(sequence_cref<entity, SeqParam> entities)
         {
-            std::visit([&](auto& t)
-                       {
-                           using table_type = std::decay_t<decltype(t)>;
-                           if constexpr (std::is_same_v<table_type, sparse_table>)
-                           {
-                               if (t.entity_count() + entities.size() > sparse_to_chunk_convert_limit)
-                                   sparse_convert_to_chunk();
-                           }
-                       }, m_table);
+            m_access_profile.decay(m_storage_policy.profile_window);
+            if (!is_converting() && get_storage_type() == storage_type::Sparse &&
+                select_layout(entity_count() + entities.size()) == storage_layout::chunk)
+            {
+                if (m_incremental_conversion) begin_sparse_to_chunk();
+                else sparse_convert_to_chunk();
+            }
+
+            if (m_conversion == conversion_state::chunk_to_sparse)
+            {
+                track_sparse_entities(entities);
+                return allocate_accessor<SeqParam>(m_conversion_sparse->get_allocate_accessor(entities, [](entity, storage_key) {}));
+            }
+            if (get_storage_type() == storage_type::Sparse)
+                track_sparse_entities(entities);
 
             return std::visit([&]<typename table_type>(table_type& t)
                               {
-                                  return allocate_accessor(t.get_allocate_accessor(entities, [this](entity e, storage_key s)
+                                  return allocate_accessor<SeqParam>(t.get_allocate_accessor(entities, [this](entity e, storage_key s)
                                   {
                                       if constexpr (std::is_same_v<table_type, table>)
                                       {
@@ -536,17 +916,44 @@ namespace hyecs
                               }, m_table);
         }
 
-        void dynamic_for_each(sequence_cref<uint32_t> component_indices, function<void(entity, sequence_ref<void*>)> func)
+        template<typename Callable>
+        void dynamic_for_each(sequence_cref<uint32_t> component_indices, Callable&& func)
         {
+            m_access_profile.record_sequential(entity_count());
             std::visit([&](auto& t)
                        {
                            t.dynamic_for_each(component_indices, func);
                        }, m_table);
+            if (m_conversion_sparse)
+                m_conversion_sparse->dynamic_for_each(component_indices, func);
+        }
+
+        //func takes (sequence_cref<entity>, sequence_cref<void*> columns, sequence_cref<uint32_t> strides, uint32_t count)
+        template<typename Callable>
+        void dynamic_for_each_batch(sequence_cref<uint32_t> component_indices, Callable&& func)
+        {
+            m_access_profile.record_sequential(entity_count());
+            std::visit([&](auto& t)
+                       {
+                           t.dynamic_for_each_batch(component_indices, func);
+                       }, m_table);
+            if (m_conversion_sparse)
+                m_conversion_sparse->dynamic_for_each_batch(component_indices, func);
         }
 
         template<typename Callable>
         void for_each(Callable&& func, sequence_cref<uint32_t> component_indices)
         {
+            m_access_profile.record_sequential(entity_count());
+            if (m_conversion_sparse)
+            {
+                std::visit([&](auto& t)
+                           {
+                               t.for_each(func, component_indices);
+                           }, m_table);
+                m_conversion_sparse->for_each(func, component_indices);
+                return;
+            }
             std::visit([&](auto& t)
                        {
                            t.template for_each<Callable>(std::forward<Callable>(func), component_indices);
@@ -0,0 +1,53 @@
+#pragma once
+#include "container/container.h"
+#include "ecs/type/entity.h"
+
+namespace hyecs
+{
+	//gathers rows of component addresses into runs in which every column advances by its stride,
+	//for the layouts without chunk columns, the rows of a storage that was filled in bulk fall in long runs
+	//a run is handed to func(sequence_cref<entity>, sequence_cref<void*> columns, sequence_cref<uint32_t> strides, uint32_t count)
+	class column_run_builder
+	{
+	public:
+		static constexpr uint32_t max_run_rows = 256;
+
+	private:
+		access_buffer<void*> m_columns;
+		access_buffer<uint32_t> m_strides;
+		access_buffer<entity> m_entities;
+
+		bool continues(sequence_ref<void*> addresses) const
+		{
+			const size_t count = m_entities.size();
+			for (size_t i = 0; i < addresses.size(); i++)
+				if (addresses[i] != static_cast<std::byte*>(m_columns[i]) + count * m_strides[i]) return false;
+			return true;
+		}
+
+	public:
+		column_run_builder(sequence_cref<uint32_t> strides)
+			: m_columns(strides.size()), m_strides(strides.begin(), strides.end())
+		{
+			m_entities.reserve(max_run_rows);
+		}
+
+		template<typename Callable>
+		void push(entity e, sequence_ref<void*> addresses, Callable& func)
+		{
+			if (!m_entities.empty() && !continues(addresses)) flush(func);
+			if (m_entities.empty()) std::copy(addresses.begin(), addresses.end(), m_columns.begin());
+			m_entities.push_back(e);
+			if (m_entities.size() == max_run_rows) flush(func);
+		}
+
+		template<typename Callable>
+		void flush(Callable& func)
+		{
+			if (m_entities.empty()) return;
+			func(sequence_cref<entity>(m_entities), sequence_cref<void*>(m_columns), sequence_cref<uint32_t>(m_strides),
+			     uint32_t(m_entities.size()));
+			m_entities.clear();
+		}
+	};
+}
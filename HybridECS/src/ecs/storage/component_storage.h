@@ -2,6 +2,7 @@
 #include "ecs/type/entity.h"
 #include "ecs/type/component.h"
 #include "entity_map.h"
+#include "ecs/memory_report.h"
 
 namespace hyecs
 {
@@ -13,9 +14,9 @@ namespace hyecs
 
 		//todo notify addition/removal of components
 	public:
-		component_storage(component_type_index index) :
+		component_storage(component_type_index index, chunk_arena* arena = nullptr) :
 			m_component_type(index),
-			m_storage(index.size(),index.alignment())
+			m_storage(index.size(),index.alignment(), arena)
 		{
 			assert(!index.is_empty());
 		}
@@ -35,6 +36,28 @@ namespace hyecs
 			return m_component_type;
 		}
 
+		component_storage_memory_info memory_info() const
+		{
+			const auto& dense = m_storage.dense();
+			const auto& sparse = m_storage.sparse();
+			component_storage_memory_info info;
+			info.type_size = m_component_type.size();
+			info.dense_size = dense.size();
+			info.dense_capacity = dense.capacity();
+			info.dense_chunk_count = dense.chunk_count();
+			info.dense_bytes = dense.memory_usage();
+			info.sparse_page_count = sparse.page_count();
+			info.sparse_slot_count = sparse.slot_count();
+			info.sparse_occupied_count = sparse.occupied_count();
+			info.sparse_bytes = sparse.memory_usage();
+			return info;
+		}
+
+		bool contains(entity e)
+		{
+			return m_storage.contains(e);
+		}
+
 		void* at(entity e)
 		{
 			assert(m_storage.contains(e));
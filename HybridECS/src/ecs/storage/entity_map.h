@@ -107,6 +107,12 @@ namespace hyecs
                 return data[offset];
             }
 
+            const version_value_pair& at(uint32_t offset) const
+            {
+                assert(offset < page_capacity);
+                return data[offset];
+            }
+
             template<class... Args>
             version_value_pair& emplace(uint32_t offset, entity_version_t version, Args&& ... args)
             {
@@ -124,14 +130,23 @@ namespace hyecs
         static_assert(sizeof(page) == page_byte_size);
 
         vector<page*> pages;
+        chunk_arena* m_arena = nullptr;
 
         page* alloc_page()
         {
+            if (m_arena) return new(m_arena->allocate(sizeof(page))) page();
             return new page();
         }
 
         void dealloc_page(page* p)
         {
+            if (!p) return;
+            if (m_arena)
+            {
+                p->~page();
+                m_arena->deallocate(reinterpret_cast<std::byte*>(p), sizeof(page));
+                return;
+            }
             delete p;
         }
 
@@ -139,7 +154,9 @@ namespace hyecs
 
         entity_sparse_table() {};
 
-        entity_sparse_table(const entity_sparse_table& other)
+        entity_sparse_table(chunk_arena* arena) : m_arena(arena) {};
+
+        entity_sparse_table(const entity_sparse_table& other) : m_arena(other.m_arena)
         {
             pages.resize(other.pages.size());
             for (size_t i = 0; i < other.pages.size(); i++)
@@ -273,7 +290,34 @@ namespace hyecs
             return pair.value();
         }
 
+        //allocated pages
+        size_t page_count() const
+        {
+            return size_t(std::ranges::count_if(pages, [](const page* p) { return p != nullptr; }));
+        }
+
+        size_t slot_count() const
+        {
+            return page_count() * page_capacity;
+        }
+
+        //scans all allocated pages
+        size_t occupied_count() const
+        {
+            size_t count = 0;
+            for (const page* p: pages)
+            {
+                if (!p) continue;
+                for (uint32_t i = 0; i < page_capacity; i++)
+                    if (p->at(i).version != null_entity.version()) count++;
+            }
+            return count;
+        }
 
+        size_t memory_usage() const
+        {
+            return page_count() * sizeof(page) + pages.capacity() * sizeof(page*);
+        }
     };
 
 
@@ -340,6 +384,11 @@ namespace hyecs
 
         [[nodiscard]] size_t size() const { return m_dense.size(); }
 
+        [[nodiscard]] size_t memory_usage() const
+        {
+            return m_sparse.memory_usage() + m_dense.capacity() * sizeof(entity);
+        }
+
     };
 
     template<typename T>
@@ -354,6 +403,12 @@ namespace hyecs
 
         ~entity_dense_map() = default;
 
+        void clear()
+        {
+            m_sparse.clear();
+            m_dense.clear();
+        }
+
         bool contains(entity e) const
         {
             return m_sparse.contains(e);
@@ -416,6 +471,11 @@ namespace hyecs
 
         auto entities() const { return m_dense; }
 
+        size_t memory_usage() const
+        {
+            return m_sparse.memory_usage() + m_dense.capacity() * sizeof(std::pair<entity, T>);
+        }
+
     };
 
 //    template<
@@ -440,7 +500,7 @@ namespace hyecs
             typename Value,
             typename Hash = std::hash<Key>,
             typename Equal = std::equal_to<Key>,
-            typename Alloc = std::allocator<std::pair<Key, Value>>
+            typename Alloc = memory::resource_allocator<std::pair<Key, Value>>
     >
     struct dense_map;
 
@@ -448,7 +508,7 @@ namespace hyecs
             class T,
             typename Hash = std::hash<T>,
             typename Equal = std::equal_to<T>,
-            typename Alloc = std::allocator<T>
+            typename Alloc = memory::resource_allocator<T>
     >
     struct dense_set;
 
@@ -500,9 +560,9 @@ namespace hyecs
                     value((uint8_t*) ptr + sizeof(entity)) {}
         };
 
-        raw_entity_dense_map(size_t value_size, size_t alignment) :
-                m_sparse(),
-                m_dense(sizeof(entity) + value_size, std::max(alignment, alignof(entity)))
+        raw_entity_dense_map(size_t value_size, size_t alignment, chunk_arena* arena = nullptr) :
+                m_sparse(arena),
+                m_dense(sizeof(entity) + value_size, std::max(alignment, alignof(entity)), arena)
         {
             assert(alignment <= sizeof(entity));//todo support for lager alignment
         }
@@ -582,6 +642,10 @@ namespace hyecs
 
         size_t size() const { return m_dense.size(); }
 
+        const raw_segmented_vector& dense() const { return m_dense; }
+
+        const auto& sparse() const { return m_sparse; }
+
         bool contains(entity e)
         {
             return m_sparse.contains(e);
@@ -0,0 +1,233 @@
+#pragma once
+#include "ecs/type/entity.h"
+#include "ecs/type/component.h"
+#include "entity_map.h"
+
+namespace hyecs
+{
+    //the pairs source -(relation)-> target of one relation type, the relation type is a component of its group
+    //the pairs are kept in compressed arrays rebuilt on update, edits are queued until then
+    //  forward:  source i -> m_targets[m_source_offsets[i] .. m_source_offsets[i + 1]]
+    //  reverse:  target slot j -> m_reverse_sources[m_target_offsets[j] .. m_target_offsets[j + 1]]
+    //a target slot is the index of the target in the distinct targets, so the components of the targets
+    //can be resolved once per slot and shared by all the sources relating to it
+    class relation_storage : non_movable
+    {
+        struct relation_edit
+        {
+            entity source;
+            entity target;
+            bool add;
+        };
+
+        component_type_index m_relation_type;
+
+        //forward adjacency, sources sorted
+        vector<entity> m_sources;
+        vector<uint32_t> m_source_offsets{0};
+        vector<entity> m_targets;
+        vector<uint32_t> m_target_slots;
+        dense_map<entity, uint32_t> m_source_indices;
+
+        //reverse adjacency, distinct targets sorted
+        vector<entity> m_distinct_targets;
+        vector<uint32_t> m_target_offsets{0};
+        vector<entity> m_reverse_sources;
+        dense_map<entity, uint32_t> m_target_indices;
+
+        vector<relation_edit> m_edits;
+        vector<entity> m_removed_entities;
+        uint64_t m_version = 0;
+
+        static bool pair_less(const std::pair<entity, entity>& lhs, const std::pair<entity, entity>& rhs)
+        {
+            return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+        }
+
+        static bool pair_equal(const std::pair<entity, entity>& lhs, const std::pair<entity, entity>& rhs)
+        {
+            return lhs.first == rhs.first && lhs.second == rhs.second;
+        }
+
+        void rebuild()
+        {
+            memory::frame_scope frame;
+            using pair = std::pair<entity, entity>;
+
+            //the last edit of a pair decides
+            std::ranges::stable_sort(m_edits, [](const relation_edit& lhs, const relation_edit& rhs)
+            {
+                return pair_less({lhs.source, lhs.target}, {rhs.source, rhs.target});
+            });
+            memory::frame_vector<pair> added;
+            memory::frame_vector<pair> removed;
+            for (size_t i = 0; i < m_edits.size(); i++)
+            {
+                auto& edit = m_edits[i];
+                if (i + 1 < m_edits.size() && m_edits[i + 1].source == edit.source && m_edits[i + 1].target == edit.target)
+                    continue;
+                (edit.add ? added : removed).emplace_back(edit.source, edit.target);
+            }
+            m_edits.clear();
+
+            std::sort(m_removed_entities.begin(), m_removed_entities.end());
+            auto is_removed = [&](entity e)
+            {
+                return std::binary_search(m_removed_entities.begin(), m_removed_entities.end(), e);
+            };
+
+            //merge the sorted current pairs with the edits
+            memory::frame_vector<pair> pairs;
+            pairs.reserve(m_targets.size() + added.size());
+            size_t added_i = 0;
+            size_t removed_i = 0;
+            auto push = [&](const pair& p)
+            {
+                while (removed_i < removed.size() && pair_less(removed[removed_i], p)) removed_i++;
+                if (removed_i < removed.size() && pair_equal(removed[removed_i], p)) return;
+                if (is_removed(p.first) || is_removed(p.second)) return;
+                if (!pairs.empty() && pair_equal(pairs.back(), p)) return;
+                pairs.push_back(p);
+            };
+            for (uint32_t source_i = 0; source_i < m_sources.size(); source_i++)
+            {
+                for (uint32_t i = m_source_offsets[source_i]; i < m_source_offsets[source_i + 1]; i++)
+                {
+                    pair p{m_sources[source_i], m_targets[i]};
+                    while (added_i < added.size() && pair_less(added[added_i], p)) push(added[added_i++]);
+                    push(p);
+                }
+            }
+            while (added_i < added.size()) push(added[added_i++]);
+            m_removed_entities.clear();
+
+            //forward
+            m_sources.clear();
+            m_source_offsets.assign(1, 0);
+            m_targets.clear();
+            m_targets.reserve(pairs.size());
+            m_source_indices.clear();
+            for (auto& [source, target]: pairs)
+            {
+                if (m_sources.empty() || !(m_sources.back() == source))
+                {
+                    if (!m_sources.empty()) m_source_offsets.push_back(uint32_t(m_targets.size()));
+                    m_source_indices.emplace(source, uint32_t(m_sources.size()));
+                    m_sources.push_back(source);
+                }
+                m_targets.push_back(target);
+            }
+            if (!m_sources.empty()) m_source_offsets.push_back(uint32_t(m_targets.size()));
+
+            //distinct targets
+            m_distinct_targets.assign(m_targets.begin(), m_targets.end());
+            std::sort(m_distinct_targets.begin(), m_distinct_targets.end());
+            m_distinct_targets.erase(std::unique(m_distinct_targets.begin(), m_distinct_targets.end()),
+                                     m_distinct_targets.end());
+            m_target_indices.clear();
+            for (uint32_t slot = 0; slot < m_distinct_targets.size(); slot++)
+                m_target_indices.emplace(m_distinct_targets[slot], slot);
+
+            m_target_slots.resize(m_targets.size());
+            for (size_t i = 0; i < m_targets.size(); i++)
+                m_target_slots[i] = m_target_indices.at(m_targets[i]);
+
+            //reverse, a counting sort of the pairs by target slot, the sources of a target stay sorted
+            m_target_offsets.assign(m_distinct_targets.size() + 1, 0);
+            for (auto slot: m_target_slots) m_target_offsets[slot + 1]++;
+            for (size_t slot = 0; slot < m_distinct_targets.size(); slot++)
+                m_target_offsets[slot + 1] += m_target_offsets[slot];
+            m_reverse_sources.resize(m_targets.size());
+            memory::frame_vector<uint32_t> cursor(m_target_offsets.begin(), m_target_offsets.end() - 1);
+            for (uint32_t source_i = 0; source_i < m_sources.size(); source_i++)
+                for (uint32_t i = m_source_offsets[source_i]; i < m_source_offsets[source_i + 1]; i++)
+                    m_reverse_sources[cursor[m_target_slots[i]]++] = m_sources[source_i];
+
+            m_version++;
+        }
+
+    public:
+        static constexpr uint32_t absent_index = std::numeric_limits<uint32_t>::max();
+
+        relation_storage(component_type_index relation_type) : m_relation_type(relation_type)
+        {
+        }
+
+        component_type_index relation_type() const { return m_relation_type; }
+
+        void add(entity source, entity target)
+        {
+            m_edits.push_back({source, target, true});
+        }
+
+        void remove(entity source, entity target)
+        {
+            m_edits.push_back({source, target, false});
+        }
+
+        //drops the pairs the entities take part in, as source or as target
+        void remove_entities(sequence_cref<entity> entities)
+        {
+            if (m_sources.empty() && m_edits.empty()) return;
+            m_removed_entities.insert(m_removed_entities.end(), entities.begin(), entities.end());
+        }
+
+        bool is_dirty() const { return !m_edits.empty() || !m_removed_entities.empty(); }
+
+        //applies the queued edits, the views of the storage are valid until the next update
+        void update()
+        {
+            if (is_dirty()) rebuild();
+        }
+
+        //changes on each rebuild, for caches over the slots
+        uint64_t version() const { return m_version; }
+
+        size_t pair_count() const { return m_targets.size(); }
+
+        //forward, the index of the source or absent_index
+        uint32_t source_index(entity source)
+        {
+            auto iter = m_source_indices.find(source);
+            return iter == m_source_indices.end() ? absent_index : iter->second;
+        }
+
+        sequence_cref<entity> sources() const { return m_sources; }
+
+        sequence_cref<uint32_t> source_offsets() const { return m_source_offsets; }
+
+        //the target slots of the pairs, in the order of the forward adjacency
+        sequence_cref<uint32_t> target_slots() const { return m_target_slots; }
+
+        //the distinct targets, indexed by slot
+        sequence_cref<entity> targets() const { return m_distinct_targets; }
+
+        sequence_cref<entity> targets_of(entity source)
+        {
+            update();
+            uint32_t index = source_index(source);
+            if (index == absent_index) return {};
+            return sequence_cref<entity>(m_targets.data() + m_source_offsets[index],
+                                         m_targets.data() + m_source_offsets[index + 1]);
+        }
+
+        sequence_cref<entity> sources_of(entity target)
+        {
+            update();
+            auto iter = m_target_indices.find(target);
+            if (iter == m_target_indices.end()) return {};
+            uint32_t slot = iter->second;
+            return sequence_cref<entity>(m_reverse_sources.data() + m_target_offsets[slot],
+                                         m_reverse_sources.data() + m_target_offsets[slot + 1]);
+        }
+
+        size_t memory_usage() const
+        {
+            return (m_sources.capacity() + m_targets.capacity() + m_distinct_targets.capacity() +
+                    m_reverse_sources.capacity() + m_removed_entities.capacity()) * sizeof(entity) +
+                   (m_source_offsets.capacity() + m_target_slots.capacity() + m_target_offsets.capacity()) * sizeof(uint32_t) +
+                   m_edits.capacity() * sizeof(relation_edit) +
+                   m_source_indices.memory_usage() + m_target_indices.memory_usage();
+        }
+    };
+}
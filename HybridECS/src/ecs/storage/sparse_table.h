@@ -2,6 +2,8 @@
 #include "ecs/type/entity.h"
 #include "component_storage.h"
 #include "storage_key_registry.h"
+#include "column_run.h"
+#include "ecs/query/system_callable_invoker.h"
 
 namespace hyecs
 {
@@ -52,6 +54,20 @@ namespace hyecs
             m_entities.clear();
         }
 
+        //remove entities whose components were moved out, no remove event is sent
+        void detach_entities(sequence_cref<entity> entities)
+        {
+            for (auto e : entities)
+            {
+                m_entities.erase(e);
+                for (auto storage : m_component_storages)
+                    if constexpr (DESTROY_MOVED_COMPONENTS)
+                        storage->erase_component(e);
+                    else
+                        storage->deallocate_component(e);
+            }
+        }
+
 	private:
 		void allocate_entity(entity e, sequence_ref<void*> components)
 		{
@@ -64,6 +80,7 @@ namespace hyecs
 
 	public:
 		size_t entity_count() const { return m_entities.size(); }
+		size_t memory_usage() const { return m_entities.memory_usage(); }
 		const dense_set<entity>& get_entities() { return m_entities; }
 
 		void bind_on_entity_add(function<void(entity, storage_key)> callback)
@@ -408,9 +425,11 @@ namespace hyecs
 			return deallocate_accessor(*this, entities);
 		}
 
-		void dynamic_for_each(sequence_cref<uint32_t> component_indices, function<void(entity, sequence_ref<void*>)> func)
+		template <typename Callable>
+		void dynamic_for_each(sequence_cref<uint32_t> component_indices, Callable&& func)
 		{
-			vector<void*> addrs(component_indices.size()); //todo this allocation can be optimized
+			access_buffer<void*> address_cache(component_indices.size());
+			sequence_ref<void*> addrs(address_cache);
 			for (const auto& entity : m_entities)
 			{
 				for (size_t i = 0; i < component_indices.size(); i++)
@@ -421,19 +440,45 @@ namespace hyecs
 			}
 		}
 
+		//func takes (sequence_cref<entity>, sequence_cref<void*> columns, sequence_cref<uint32_t> strides, uint32_t count)
+		//once per run of entities whose components lie next to each other in every storage
+		template <typename Callable>
+		void dynamic_for_each_batch(sequence_cref<uint32_t> component_indices, Callable&& func)
+		{
+			access_buffer<uint32_t> strides(component_indices.size());
+			for (size_t i = 0; i < component_indices.size(); i++)
+				strides[i] = m_component_storages[component_indices[i]]->component_type().size();
+			access_buffer<void*> address_cache(component_indices.size());
+			sequence_ref<void*> addrs(address_cache);
+			column_run_builder runs(strides);
+			for (const auto& entity : m_entities)
+			{
+				for (size_t i = 0; i < component_indices.size(); i++)
+				{
+					addrs[i] = m_component_storages[component_indices[i]]->at(entity);
+				}
+				runs.push(entity, addrs, func);
+			}
+			runs.flush(func);
+		}
+
 		template <typename Callable>
 		void for_each(Callable&& func, sequence_cref<uint32_t> component_indices)
 		{
 			auto invoker = system_callable_invoker(std::forward<Callable>(func));
 
-			for (auto& e : m_entities)
+			//the components are in per entity slots of the component storages, no streaming stores
+			invoker.specialize(component_indices, 0, [&](auto resolution)
 			{
-				invoker.invoke(
-					[&] { return e; },
-					[&] { return storage_key{}; },
-					[&](auto type, size_t index) { return m_component_storages[component_indices[index]]->at(e); }
-				);
-			}
+				for (auto& e : m_entities)
+				{
+					invoker.template invoke<decltype(resolution)::value>(
+						[&] { return e; },
+						[&] { return storage_key{}; },
+						[&](auto type, size_t index) { return m_component_storages[component_indices[index]]->at(e); }
+					);
+				}
+			});
 		}
 	};
 
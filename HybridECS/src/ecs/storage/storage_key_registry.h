@@ -13,6 +13,8 @@ namespace hyecs
 		dense_map<entity, storage_key> m_entity_storage_keys;
 		vector<table*> m_tables;
 		stack<size_t> free_table_indices;
+		//owner profile of sparse entities, only for archetypes that profile random access
+		dense_map<entity, storage_access_profile*> m_sparse_access_profiles;
 
 
 	public:
@@ -27,6 +29,15 @@ namespace hyecs
             return m_entity_storage_keys.find(e);
         }
 
+        size_t key_count() const { return m_entity_storage_keys.size(); }
+
+        size_t memory_usage() const
+        {
+            return m_entity_storage_keys.memory_usage() +
+                   m_sparse_access_profiles.memory_usage() +
+                   m_tables.capacity() * sizeof(table*);
+        }
+
         auto begin() { return m_entity_storage_keys.begin(); }
 
         auto end() { return m_entity_storage_keys.end(); }
@@ -62,6 +73,18 @@ namespace hyecs
         	return m_tables[table_index.table_index()];
         }
 
+		void record_random_access(storage_key key)
+		{
+			find_table(key.get_table_index())->record_random_access();
+		}
+
+		void record_sparse_random_access(entity e)
+		{
+			if (m_sparse_access_profiles.size() == 0) return;
+			if (m_sparse_access_profiles.contains(e))
+				m_sparse_access_profiles.at(e)->record_random();
+		}
+
 		class group_key_accessor
 		{
 			storage_key_registry& m_registry;
@@ -85,6 +108,12 @@ namespace hyecs
 				storage_map().erase(e);
 			}
 
+			//overwrite the key of an entity moved inside its table
+			void update(entity e, storage_key key)
+			{
+				storage_map().at(e) = key;
+			}
+
 			storage_key at(entity e) const
 			{
 				return storage_map().at(e);
@@ -114,6 +143,16 @@ namespace hyecs
 	        {
 				return m_registry.find_table(table_index);
 			}
+
+			void track_sparse_entity(entity e, storage_access_profile* profile)
+			{
+				m_registry.m_sparse_access_profiles.insert({ e, profile });
+			}
+
+			void untrack_sparse_entity(entity e)
+			{
+				m_registry.m_sparse_access_profiles.erase(e);
+			}
 		};
 
 		group_key_accessor get_group_key_accessor()
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "core/hyecs_core.h"
+
+namespace hyecs
+{
+    //access counters of an archetype storage
+    //sequential accesses are fed by the query iteration, random accesses by the entity lookup paths
+    struct storage_access_profile
+    {
+        uint64_t sequential_access = 0;
+        uint64_t random_access = 0;
+        uint32_t conversion_count = 0;
+
+        void record_sequential(size_t count) { sequential_access += count; }
+
+        void record_random(size_t count = 1) { random_access += count; }
+
+        //halve the counters once they exceed the window so old history fades out
+        void decay(uint64_t window)
+        {
+            if (sequential_access + random_access <= window) return;
+            sequential_access >>= 1;
+            random_access >>= 1;
+        }
+    };
+
+    enum class storage_layout : uint8_t
+    {
+        sparse,
+        chunk,
+    };
+
+    struct storage_policy_context
+    {
+        storage_layout layout; //current layout
+        size_t entity_count; //entity count after the pending change
+        size_t chunk_capacity;
+        size_t component_count; //non empty components
+        const storage_access_profile& profile;
+    };
+
+    //the fixed limits: convert to chunk above a chunk of entities, back to sparse below half of it
+    struct threshold_storage_policy
+    {
+        float to_chunk = 1.0f;
+        float to_sparse = 0.5f;
+
+        storage_layout operator()(const storage_policy_context& ctx) const
+        {
+            //single component archetype is already dense in the component storage
+            if (ctx.component_count <= 1) return storage_layout::sparse;
+            const float capacity = float(ctx.chunk_capacity);
+            if (ctx.layout == storage_layout::sparse)
+                return float(ctx.entity_count) > capacity * to_chunk ? storage_layout::chunk : storage_layout::sparse;
+            return float(ctx.entity_count) < capacity * to_sparse ? storage_layout::sparse : storage_layout::chunk;
+        }
+    };
+
+    //thresholds driven by the access profile with hysteresis
+    //every conversion widens the band between the two thresholds so an archetype around the threshold settles,
+    //random access dominated archetypes stay sparse until they grow past random_sparse_limit chunks
+    struct adaptive_storage_policy
+    {
+        float high_water = 1.0f; //sparse to chunk, in chunk capacity
+        float low_water = 0.25f; //chunk to sparse, in chunk capacity
+        float random_ratio = 1.0f; //random accesses per sequential access to count as randomly accessed
+        float random_sparse_limit = 4.0f; //in chunk capacity
+        float backoff = 2.0f; //band factor per conversion
+        uint32_t max_backoff = 4;
+
+        storage_layout operator()(const storage_policy_context& ctx) const
+        {
+            if (ctx.component_count <= 1) return storage_layout::sparse;
+            const auto& profile = ctx.profile;
+            float band = 1.0f;
+            for (uint32_t i = 0; i < std::min(profile.conversion_count, max_backoff); i++)
+                band *= backoff;
+            const float capacity = float(ctx.chunk_capacity);
+            const bool random_access = float(profile.random_access) > float(profile.sequential_access) * random_ratio;
+            if (ctx.layout == storage_layout::sparse)
+            {
+                float limit = capacity * high_water * band;
+                if (random_access) limit = std::max(limit, capacity * random_sparse_limit);
+                return float(ctx.entity_count) > limit ? storage_layout::chunk : storage_layout::sparse;
+            }
+            float limit = capacity * low_water / band;
+            return float(ctx.entity_count) < limit ? storage_layout::sparse : storage_layout::chunk;
+        }
+    };
+
+    struct storage_policy
+    {
+        function<storage_layout(const storage_policy_context&)> select = threshold_storage_policy{};
+        //track the owner of sparse entities so their random accesses are counted,
+        //costs a map entry per sparse entity
+        bool profile_random_access = false;
+        //counter window of the access profile
+        uint64_t profile_window = 1 << 20;
+
+        static storage_policy threshold(threshold_storage_policy policy = {})
+        {
+            return {policy, false};
+        }
+
+        static storage_policy adaptive(adaptive_storage_policy policy = {})
+        {
+            return {policy, true};
+        }
+    };
+}
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "core/hyecs_core.h"
+#include "container/chunk_arena.h"
 #include "ecs/type/archetype.h"
 #include "ecs/type/entity.h"
 #include "storage_key.h"
+#include "storage_policy.h"
 #include "ecs/query/system_callable_invoker.h"
 
 
@@ -15,7 +17,34 @@ namespace hyecs
 {
     struct component_table_chunk_traits
     {
-        static constexpr size_t size = 2 * 1024;
+        static constexpr size_t size = 2 * 1024; //default chunk size
+        static constexpr size_t min_size = 2 * 1024;
+        static constexpr size_t max_size = 64 * 1024;
+        static constexpr size_t header_size = 64; //chunk header, also the data alignment of a chunk
+    };
+
+    //picks the chunk size of a table from its row size (entity + non-empty components)
+    //the chunk size is a power of two in [min_size, max_size] that holds about target_entity_count rows
+    struct chunk_size_policy
+    {
+        uint32_t target_entity_count = 128;
+        uint32_t min_size = component_table_chunk_traits::min_size;
+        uint32_t max_size = component_table_chunk_traits::max_size;
+
+        size_t chunk_size(size_t row_size) const
+        {
+            assert(row_size != 0);
+            assert(std::has_single_bit(min_size) && std::has_single_bit(max_size) && min_size <= max_size);
+            size_t wanted = std::bit_ceil(row_size * target_entity_count);
+            size_t size = std::clamp<size_t>(wanted, min_size, max_size);
+            //at least one row must fit
+            return std::max(size, std::bit_ceil(row_size + component_table_chunk_traits::header_size));
+        }
+
+        static size_t chunk_capacity(size_t chunk_size, size_t row_size)
+        {
+            return (chunk_size - component_table_chunk_traits::header_size) / row_size;
+        }
     };
 
 
@@ -31,32 +60,32 @@ namespace hyecs
         using table_offset_t = storage_key::table_offset_t; //table offset is not consistent
 
 
-        class chunk
+        //chunk header, the column data follows the header in the same allocation
+        class alignas(component_table_chunk_traits::header_size) chunk
         {
         private:
-            std::array<byte, component_table_chunk_traits::size> m_data;
             size_t m_size = 0;
 
         public:
 
-            chunk() { ASSERTION_CODE(m_data.fill(0xFF)); }
+            chunk(size_t data_size) { ASSERTION_CODE(std::memset(data(), 0xFF, data_size)); }
 
             size_t size() const { return m_size; }
 
-            byte* data() { return m_data.data(); }
+            byte* data() { return reinterpret_cast<byte*>(this) + sizeof(chunk); }
 
-            const byte* data() const { return m_data.data(); }
+            const byte* data() const { return reinterpret_cast<const byte*>(this) + sizeof(chunk); }
 
             sequence_ref<entity> entities()
             {
-                auto begin = reinterpret_cast<entity*>(m_data.data());
+                auto begin = reinterpret_cast<entity*>(data());
                 auto end = begin + m_size;
                 return {begin, end};
             }
 
             sequence_cref<entity> entities() const
             {
-                auto begin = reinterpret_cast<const entity*>(m_data.data());
+                auto begin = reinterpret_cast<const entity*>(data());
                 auto end = begin + m_size;
                 return {begin, end};
             }
@@ -65,10 +94,9 @@ namespace hyecs
 
             void decrease_size(size_t size) { m_size -= size; }
         };
+        static_assert(sizeof(chunk) == component_table_chunk_traits::header_size);
 
-        using chunk_allocator = generic::allocator;
-
-        [[no_unique_address]] chunk_allocator m_allocator;
+        chunk_allocator m_allocator;
 
         struct table_comp_type_info : public cached_component_type_index
         {
@@ -94,10 +122,12 @@ namespace hyecs
         vector<table_comp_type_info> m_notnull_components;
         //todo add allocator for vec?
         vector<chunk*> m_chunks;
+        size_t m_chunk_size; //bytes of a chunk allocation, header included
         size_t m_chunk_capacity;
         size_t m_entity_count;
         uint32_t m_chunk_offset_bits;
         table_index_t m_table_index;
+        storage_access_profile* m_access_profile = nullptr; //owner's profile, counts random accesses
 
 
         struct entity_table_index
@@ -106,51 +136,134 @@ namespace hyecs
             uint32_t chunk_offset;
         };
 
-        //temporary hole in the table for batch adding removing entities
-        struct free_indices_stack
+        //temporary holes in the table for batch adding removing entities
+        //one bit per row, a set bit is a removed row that is not swapped back yet
+        //allocation reuses the first hole, iteration skips the holes
+        class hole_mask
         {
+            vector<uint64_t> m_bits; //words_per_chunk words per chunk
+            vector<uint32_t> m_counts; //holes per chunk
+            vector<uint32_t> m_hole_chunks; //chunks with holes
+            uint32_t m_words_per_chunk = 0;
+            size_t m_total = 0;
+
         public:
-            vector<stack<uint32_t>> m_free_indices;
-            stack<uint32_t> m_free_chunks_indices;
+            static constexpr uint32_t word_bits = 64;
+
+            void set_chunk_capacity(size_t capacity)
+            {
+                m_words_per_chunk = (capacity + word_bits - 1) / word_bits;
+            }
+
+            const uint64_t* chunk_words(uint32_t chunk_index) const
+            {
+                return m_bits.data() + size_t(chunk_index) * m_words_per_chunk;
+            }
+
+            uint64_t* chunk_words(uint32_t chunk_index)
+            {
+                return m_bits.data() + size_t(chunk_index) * m_words_per_chunk;
+            }
 
             void push(entity_table_index index)
             {
-                if (m_free_indices.size() <= index.chunk_index)
-                {
-                    m_free_indices.resize(index.chunk_index + 1);
-                }
-                if (m_free_indices[index.chunk_index].empty())
+                if (m_counts.size() <= index.chunk_index)
                 {
-                    m_free_chunks_indices.push(index.chunk_index);
+                    m_counts.resize(index.chunk_index + 1);
+                    m_bits.resize(m_counts.size() * m_words_per_chunk);
                 }
-                m_free_indices[index.chunk_index].push(index.chunk_offset);
+                if (m_counts[index.chunk_index]++ == 0)
+                    m_hole_chunks.push_back(index.chunk_index);
+                uint64_t& word = chunk_words(index.chunk_index)[index.chunk_offset / word_bits];
+                assert(!(word & (uint64_t(1) << index.chunk_offset % word_bits)));
+                word |= uint64_t(1) << index.chunk_offset % word_bits;
+                m_total++;
             }
 
             bool empty() const
             {
-                return m_free_chunks_indices.empty();
+                return m_total == 0;
             }
 
-            entity_table_index top()
+            size_t size() const
+            {
+                return m_total;
+            }
+
+            uint32_t count(uint32_t chunk_index) const
             {
-                uint32_t chunk_index = m_free_chunks_indices.top();
-                uint32_t chunk_offset = m_free_indices[chunk_index].top();
-                return {chunk_index, chunk_offset};
+                return chunk_index < m_counts.size() ? m_counts[chunk_index] : 0;
+            }
+
+            bool contains(entity_table_index index) const
+            {
+                if (count(index.chunk_index) == 0) return false;
+                return chunk_words(index.chunk_index)[index.chunk_offset / word_bits] & (uint64_t(1) << index.chunk_offset % word_bits);
+            }
+
+            //first hole of the last chunk that got a hole
+            entity_table_index top() const
+            {
+                assert(!empty());
+                uint32_t chunk_index = m_hole_chunks.back();
+                const uint64_t* words = chunk_words(chunk_index);
+                for (uint32_t w = 0;; w++)
+                {
+                    if (words[w]) return {chunk_index, w * word_bits + uint32_t(std::countr_zero(words[w]))};
+                }
             }
 
             void pop()
             {
-                assert(!m_free_chunks_indices.empty());
-                uint32_t chunk_index = m_free_chunks_indices.top();
-                m_free_indices[chunk_index].pop();
-                if (m_free_indices[chunk_index].empty())
+                erase(top());
+            }
+
+            void erase(entity_table_index index)
+            {
+                assert(contains(index));
+                chunk_words(index.chunk_index)[index.chunk_offset / word_bits] &= ~(uint64_t(1) << index.chunk_offset % word_bits);
+                m_total--;
+                if (--m_counts[index.chunk_index] == 0)
+                    std::erase(m_hole_chunks, index.chunk_index);
+            }
+
+            //collect the holes of a chunk in ascending order and clear them
+            void take_chunk(uint32_t chunk_index, vector<uint32_t>& offsets)
+            {
+                uint64_t* words = chunk_words(chunk_index);
+                for (uint32_t w = 0; w < m_words_per_chunk; w++)
                 {
-                    m_free_chunks_indices.pop();
+                    for (uint64_t word = words[w]; word; word &= word - 1)
+                        offsets.push_back(w * word_bits + uint32_t(std::countr_zero(word)));
+                    words[w] = 0;
                 }
+                m_total -= m_counts[chunk_index];
+                m_counts[chunk_index] = 0;
+                std::erase(m_hole_chunks, chunk_index);
+            }
+
+            uint32_t back_chunk() const
+            {
+                return m_hole_chunks.back();
+            }
+
+            uint32_t max_chunk_count() const
+            {
+                uint32_t max_count = 0;
+                for (auto c: m_hole_chunks) max_count = std::max(max_count, m_counts[c]);
+                return max_count;
+            }
+
+            //bytes of the bookkeeping
+            size_t memory_usage() const
+            {
+                return m_bits.capacity() * sizeof(uint64_t) +
+                       m_counts.capacity() * sizeof(uint32_t) +
+                       m_hole_chunks.capacity() * sizeof(uint32_t);
             }
         };
 
-        free_indices_stack m_free_indices;
+        hole_mask m_free_indices;
         stack<std::pair<chunk*, uint32_t>> m_free_chunks; //free chunk and it's index
 
         //event
@@ -158,16 +271,22 @@ namespace hyecs
         multicast_function<void(entity, storage_key)> m_on_entity_add;
         //removing or move out of
         multicast_function<void(entity)> m_on_entity_remove;
-        //mainly for internal move notify
-        multicast_function<void(entity, storage_key)> m_on_entity_move;
+        //internal moves (swap back and compaction), the new keys are sent in bulk
+        multicast_function<void(sequence_cref<entity>, sequence_cref<storage_key>)> m_on_entities_move;
+        vector<entity> m_moved_entities; //bulk move notify cache
+        vector<storage_key> m_moved_keys;
 
     public:
-        table(sorted_sequence_cref<component_type_index> components)
-                : m_entity_count(0)
+        table(sorted_sequence_cref<component_type_index> components,
+              size_t chunk_size = component_table_chunk_traits::size,
+              chunk_arena* arena = nullptr)
+                : m_allocator(arena),
+                  m_chunk_size(chunk_size),
+                  m_entity_count(0)
         {
             size_t column_size = sizeof(entity);
             size_t offset = 0;
-            uint32_t max_align = 4;
+            uint32_t max_align = alignof(chunk);
 
             for (auto& type: components)
             {
@@ -177,7 +296,10 @@ namespace hyecs
             }
             m_allocator.set_alignment(max_align);
 
-            m_chunk_capacity = component_table_chunk_traits::size / column_size;
+            assert(m_chunk_size % max_align == 0);
+            m_chunk_capacity = chunk_size_policy::chunk_capacity(m_chunk_size, column_size);
+            m_free_indices.set_chunk_capacity(m_chunk_capacity);
+            assert(m_chunk_capacity > 0);
             offset = sizeof(entity) * m_chunk_capacity;
             //how many bits needed to store chunk offset
             m_chunk_offset_bits = std::bit_width(m_chunk_capacity - 1);
@@ -221,6 +343,27 @@ namespace hyecs
             return m_table_index;
         }
 
+        void set_access_profile(storage_access_profile* profile)
+        {
+            m_access_profile = profile;
+        }
+
+        void record_random_access(size_t count = 1)
+        {
+            if (m_access_profile) m_access_profile->record_random(count);
+        }
+
+        //rows were removed and phase_swap_back was not called yet
+        bool has_holes() const
+        {
+            return !m_free_indices.empty();
+        }
+
+        size_t hole_count() const
+        {
+            return m_free_indices.size();
+        }
+
         //table(const table&) = delete;
         //table(table&&) = default;
 
@@ -235,7 +378,7 @@ namespace hyecs
         //	m_free_chunks(std::move(other.m_free_chunks)),
         //	m_on_entity_add(std::move(other.m_on_entity_add)),
         //	m_on_entity_remove(std::move(other.m_on_entity_remove)),
-        //	m_on_entity_move(std::move(other.m_on_entity_move))
+        //	m_on_entities_move(std::move(other.m_on_entities_move))
         //{
         //}
 
@@ -245,10 +388,10 @@ namespace hyecs
             for (uint32_t chunk_index = 0; chunk_index < m_chunks.size(); chunk_index++)
             {
                 const auto chunk = m_chunks[chunk_index];
-                for (uint32_t i = 0; i < chunk->size(); i++)
+                for_each_row(chunk_index, [&](uint32_t i)
                 {
                     callback(chunk->entities()[i], {m_table_index, table_offset({chunk_index, i})});
-                }
+                });
             }
 
             m_on_entity_add += callback;
@@ -259,10 +402,15 @@ namespace hyecs
             m_on_entity_remove += callback;
         }
 
+        void bind_on_entities_move(function<void(sequence_cref<entity>, sequence_cref<storage_key>)> callback)
+        {
+            m_on_entities_move += callback;
+        }
+
     private:
         chunk* allocate_chunk()
         {
-            chunk* new_chunk = new(m_allocator.allocate(sizeof(chunk))) chunk();
+            chunk* new_chunk = new(m_allocator.allocate(m_chunk_size)) chunk(m_chunk_size - sizeof(chunk));
             m_chunks.push_back(new_chunk);
             uint32_t chunk_index = m_chunks.size() - 1;
             m_free_chunks.push({new_chunk, chunk_index});
@@ -277,7 +425,7 @@ namespace hyecs
                 auto& comp_type = m_notnull_components[component_index];
                 comp_type.destructor(_chunk->data() + comp_type.offset(), _chunk->size());
             }
-            m_allocator.deallocate((std::byte*) _chunk, sizeof(chunk));
+            m_allocator.deallocate((std::byte*) _chunk, m_chunk_size);
         }
 
         entity_table_index allocate_entity()
@@ -312,31 +460,93 @@ namespace hyecs
             deallocate_entity(chunk_index_offset(table_offset));
         }
 
+        //visit the live rows of a chunk, the holes are skipped while the swap back is deferred
+        template<typename Func>
+        void for_each_row(uint32_t chunk_index, Func&& func) const
+        {
+            const uint32_t size = m_chunks[chunk_index]->size();
+            if (m_free_indices.count(chunk_index) == 0)
+            {
+                for (uint32_t offset = 0; offset < size; offset++) func(offset);
+                return;
+            }
+            const uint64_t* holes = m_free_indices.chunk_words(chunk_index);
+            for (uint32_t base = 0; base < size; base += hole_mask::word_bits)
+            {
+                uint64_t live = ~holes[base / hole_mask::word_bits];
+                if (size - base < hole_mask::word_bits) live &= (uint64_t(1) << (size - base)) - 1;
+                for (; live; live &= live - 1)
+                    func(base + uint32_t(std::countr_zero(live)));
+            }
+        }
+
+        //visit the runs of consecutive live rows of a chunk as [begin, end)
+        template<typename Func>
+        void for_each_run(uint32_t chunk_index, Func&& func) const
+        {
+            const uint32_t size = m_chunks[chunk_index]->size();
+            if (size == 0) return;
+            if (m_free_indices.count(chunk_index) == 0)
+            {
+                func(0u, size);
+                return;
+            }
+            const uint64_t* holes = m_free_indices.chunk_words(chunk_index);
+            uint32_t run_begin = 0;
+            uint32_t run_end = 0;
+            for (uint32_t base = 0; base < size; base += hole_mask::word_bits)
+            {
+                uint64_t live = ~holes[base / hole_mask::word_bits];
+                if (size - base < hole_mask::word_bits) live &= (uint64_t(1) << (size - base)) - 1;
+                while (live)
+                {
+                    const uint32_t begin = std::countr_zero(live);
+                    const uint32_t length = std::countr_one(live >> begin);
+                    //a run that reaches the end of the previous word goes on
+                    if (base + begin != run_end)
+                    {
+                        if (run_end != run_begin) func(run_begin, run_end);
+                        run_begin = base + begin;
+                    }
+                    run_end = base + begin + length;
+                    live = begin + length == hole_mask::word_bits ? 0 : live & ~((uint64_t(1) << (begin + length)) - 1);
+                }
+            }
+            if (run_end != run_begin) func(run_begin, run_end);
+        }
+
+        void record_move(entity e, entity_table_index index)
+        {
+            m_moved_entities.push_back(e);
+            m_moved_keys.push_back({m_table_index, table_offset(index)});
+        }
+
+        void notify_moves()
+        {
+            if (m_moved_entities.empty()) return;
+            m_on_entities_move(sequence_cref(m_moved_entities), sequence_cref(m_moved_keys));
+            m_moved_entities.clear();
+            m_moved_keys.clear();
+        }
+
     public:
         //call after all addition and removal were done
-        //todo this will cause invalid storage key reference need to update storage key references
-        void phase_swap_back()
+        //the moved entities are sent to on_entities_move
+        //moves at most max_rows rows, the holes left are kept for the next call
+        //returns the moved row count
+        size_t phase_swap_back(size_t max_rows = std::numeric_limits<size_t>::max())
         {
-            size_t max_len = 0;
-            for (auto& free_indices: m_free_indices.m_free_indices)
-                max_len = std::max(max_len, free_indices.size());
+            HYECS_TRACE_SCOPE("table::phase_swap_back");
+            size_t moved = 0;
             vector<uint32_t> sorted_indices;
-            sorted_indices.reserve(max_len);
-            while (!m_free_indices.empty())//for each chunk
+            sorted_indices.reserve(m_free_indices.max_chunk_count());
+            while (!m_free_indices.empty() && moved < max_rows)//for each chunk
             {
-                //get all free indices in chunk and sort it
+                //get all holes in chunk, ascending from the bit mask
                 //moving tail elements to head holes
-                auto chunk_index = m_free_indices.m_free_chunks_indices.top();
-                m_free_indices.m_free_chunks_indices.pop();
-                auto& free_indices = m_free_indices.m_free_indices[chunk_index];
+                auto chunk_index = m_free_indices.back_chunk();
                 sorted_indices.clear();
-                while (!free_indices.empty())
-                {
-                    auto chunk_offset = free_indices.top();
-                    free_indices.pop();
-                    sorted_indices.push_back(chunk_offset);
-                }
-                std::sort(sorted_indices.begin(), sorted_indices.end());
+                m_free_indices.take_chunk(chunk_index, sorted_indices);
                 auto head_hole_iter = sorted_indices.begin();
                 auto tail_hole_iter = sorted_indices.rbegin();
                 chunk* chunk = m_chunks[chunk_index];
@@ -358,16 +568,22 @@ namespace hyecs
                     }
                     last_entity_offset--;
                     head_hole_iter++;
+                    moved++;
 
-                    //todo this is the storage key change call back but 'm_on_entity_move' is not used yet
-                    m_on_entity_move.invoke(last_entity, {m_table_index, table_offset({chunk_index, head_offset})});
+                    record_move(last_entity, {chunk_index, head_offset});
                 };
 
+                bool out_of_budget = false;
                 while (true)
                 {
                     auto head_entity_offset = *head_hole_iter;
                     auto tail_entity_offset = *tail_hole_iter;
                     bool skip = tail_entity_offset == last_entity_offset;
+                    if (!skip && moved == max_rows)
+                    {
+                        out_of_budget = true;
+                        break;
+                    }
                     if (head_entity_offset == tail_entity_offset)
                     {
                         if (!skip) move_to_head(head_entity_offset);
@@ -385,21 +601,95 @@ namespace hyecs
                 assert(sorted_indices.size() != 0);//this should never happen
                 if (chunk->size() == m_chunk_capacity)
                     m_free_chunks.emplace(chunk, chunk_index);
+                if (out_of_budget)
+                {
+                    //the rows behind the last entity are dead, the holes not filled yet stay holes
+                    uint32_t removed = chunk->size() - (last_entity_offset + 1);
+                    chunk->decrease_size(removed);
+                    m_entity_count -= removed;
+                    for (auto iter = head_hole_iter; iter != tail_hole_iter.base(); ++iter)
+                        m_free_indices.push({chunk_index, *iter});
+                    break;
+                }
                 chunk->decrease_size(sorted_indices.size());
                 m_entity_count -= sorted_indices.size();
+            }
+            notify_moves();
+            return moved;
+        }
 
-                //todo swap / deallocate chunk
+        //no holes and no more chunks than the entities need
+        bool is_compact() const
+        {
+            return m_free_indices.empty() &&
+                   m_chunks.size() == (m_entity_count + m_chunk_capacity - 1) / m_chunk_capacity;
+        }
 
-                //if (last_chunk->size() == 0)
-                //{
-                //	m_chunks.pop_back();
-                //	m_allocator.deallocate(last_chunk, 1);
-                //	if (m_chunks.empty()) return;
-                //	last_chunk = m_chunks.back();
-                //}
+        //swap back the holes, then move rows from the tail chunks into the free space of the front chunks
+        //and release the emptied chunks
+        //moves at most max_rows rows in both phases so a large table can be compacted over several calls,
+        //the new keys are sent to on_entities_move in one batch
+        //returns the moved row count
+        size_t compact(size_t max_rows = std::numeric_limits<size_t>::max())
+        {
+            size_t moved = phase_swap_back(max_rows);
+            if (has_holes()) return moved;
+            uint32_t dst_index = 0;
+            uint32_t src_end = m_chunks.size();
+            while (moved < max_rows)
+            {
+                while (src_end > 0 && m_chunks[src_end - 1]->size() == 0) src_end--;
+                while (dst_index < src_end && m_chunks[dst_index]->size() == m_chunk_capacity) dst_index++;
+                if (dst_index + 1 >= src_end) break;
+
+                chunk* dst = m_chunks[dst_index];
+                chunk* src = m_chunks[src_end - 1];
+                uint32_t count = std::min<size_t>({m_chunk_capacity - dst->size(), src->size(), max_rows - moved});
+                uint32_t dst_offset = dst->size();
+                uint32_t src_offset = src->size() - count;
+                for (auto& type: m_notnull_components)
+                {
+                    byte* dst_data = component_address(dst, dst_offset, type);
+                    byte* src_data = component_address(src, src_offset, type);
+                    for (uint32_t i = 0; i < count; i++)
+                        type.move_constructor(dst_data + i * type.size(), src_data + i * type.size());
+                    if constexpr (DESTROY_MOVED_COMPONENTS)
+                        type.destructor(src_data, count);
+                }
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    entity e = src->entities()[src_offset + i];
+                    dst->entities()[dst_offset + i] = e;
+                    record_move(e, {dst_index, dst_offset + i});
+                }
+                dst->increase_size(count);
+                src->decrease_size(count);
+                moved += count;
             }
+            release_empty_chunks();
+            notify_moves();
+            return moved;
         }
 
+    private:
+        //free the empty chunks at the back and rebuild the free chunk list, lowest index on top
+        void release_empty_chunks()
+        {
+            while (!m_chunks.empty() && m_chunks.back()->size() == 0)
+            {
+                deallocate_chunk(m_chunks.back());
+                m_chunks.pop_back();
+            }
+            m_free_chunks = {};
+            for (uint32_t chunk_index = m_chunks.size(); chunk_index-- > 0;)
+            {
+                if (m_chunks[chunk_index]->size() < m_chunk_capacity)
+                    m_free_chunks.emplace(m_chunks[chunk_index], chunk_index);
+            }
+        }
+
+    public:
+
     private:
         static byte* component_address(chunk* chunk, uint32_t chunk_offset, uint32_t comp_offset, uint32_t comp_size)
         {
@@ -913,6 +1203,74 @@ namespace hyecs
             return deallocate_accessor(*this, entities_table_offsets);
         }
 
+        //the last rows of the table, at most max_count and within the last non-empty chunk
+        //used to shrink the table from the back without leaving holes
+        void tail_rows(size_t max_count, vector<entity>& entities, vector<table_offset_t>& offsets) const
+        {
+            assert(m_free_indices.empty());
+            entities.clear();
+            offsets.clear();
+            for (uint32_t chunk_index = m_chunks.size(); chunk_index-- > 0;)
+            {
+                const chunk* chunk = m_chunks[chunk_index];
+                if (chunk->size() == 0) continue;
+                uint32_t count = std::min(max_count, chunk->size());
+                for (uint32_t chunk_offset = chunk->size() - count; chunk_offset < chunk->size(); chunk_offset++)
+                {
+                    entities.push_back(chunk->entities()[chunk_offset]);
+                    offsets.push_back(table_offset({chunk_index, chunk_offset}));
+                }
+                return;
+            }
+        }
+
+        //drop the rows given by tail_rows, the components are expected to be moved out already
+        //no remove event is sent
+        void pop_tail_rows(size_t count)
+        {
+            for (uint32_t chunk_index = m_chunks.size(); chunk_index-- > 0;)
+            {
+                chunk* chunk = m_chunks[chunk_index];
+                if (chunk->size() == 0) continue;
+                assert(count <= chunk->size());
+                if (chunk->size() == m_chunk_capacity)
+                    m_free_chunks.emplace(chunk, chunk_index);
+                if constexpr (DESTROY_MOVED_COMPONENTS)
+                {
+                    for (auto& type: m_notnull_components)
+                        type.destructor(component_address(chunk, chunk->size() - count, type), count);
+                }
+                chunk->decrease_size(count);
+                m_entity_count -= count;
+                return;
+            }
+            assert(count == 0);
+        }
+
+        size_t chunk_size() const { return m_chunk_size; }
+
+        size_t chunk_capacity() const { return m_chunk_capacity; }
+
+        size_t chunk_count() const { return m_chunks.size(); }
+
+        //bytes of an entity row, entity included
+        size_t row_size() const
+        {
+            size_t size = sizeof(entity);
+            for (auto& type: m_notnull_components) size += type.size();
+            return size;
+        }
+
+        size_t used_bytes() const { return m_entity_count * row_size(); }
+
+        size_t reserved_bytes() const { return m_chunks.size() * m_chunk_size; }
+
+        //chunk list and hole mask
+        size_t index_memory_usage() const
+        {
+            return m_chunks.capacity() * sizeof(chunk*) + m_free_indices.memory_usage();
+        }
+
         size_t entity_count() const
         {
             ASSERTION_CODE(
@@ -961,11 +1319,10 @@ namespace hyecs
         // }
 
     private:
-        //using Callable = function<void(entity, sequence_ref<void*>)>;
         template<typename Callable>
-        void dynamic_for_each_impl(Callable func, sequence_cref<uint32_t> component_indices, sequence_ref<void*> address_cache)
+        void dynamic_for_each_impl(Callable& func, sequence_cref<uint32_t> component_indices, sequence_ref<void*> address_cache)
         {
-            using params = typename function_traits<Callable>::args;
+            using params = typename function_traits<std::decay_t<Callable>>::args;
             constexpr bool query_entity = params::template contains<entity>;
             constexpr bool query_storage_key = params::template contains<storage_key>;
             assert(address_cache.size() == component_indices.size());
@@ -973,7 +1330,7 @@ namespace hyecs
             for (uint32_t chunk_index = 0; chunk_index < m_chunks.size(); chunk_index++)
             {
                 auto chunk = m_chunks[chunk_index];
-                for (uint32_t chunk_offset = 0; chunk_offset < chunk->size(); chunk_offset++)
+                for_each_row(chunk_index, [&](uint32_t chunk_offset)
                 {
                     for (uint32_t i = 0; i < component_indices.size(); i++)
                     {
@@ -1003,7 +1360,7 @@ namespace hyecs
                             func(address_cache);
                         }
                     }
-                }
+                });
             }
         }
 
@@ -1013,43 +1370,54 @@ namespace hyecs
         {
             auto invoker = system_callable_invoker(std::forward<Callable>(func));
 
-            for (uint32_t chunk_index = 0; chunk_index < m_chunks.size(); chunk_index++)
+            invoker.specialize(component_indices, entity_count(), [&](auto resolution)
             {
-                auto chunk = m_chunks[chunk_index];
-                for (uint32_t chunk_offset = 0; chunk_offset < chunk->size(); chunk_offset++)
+                for (uint32_t chunk_index = 0; chunk_index < m_chunks.size(); chunk_index++)
                 {
-                    invoker.invoke(
-                            [&] { return chunk->entities()[chunk_offset]; },
-                            [&] { return storage_key(m_table_index, table_offset({chunk_index, chunk_offset})); },
-                            [&](auto type, size_t index) { return component_address(chunk, chunk_offset, component_indices[index]); }
-                    );
+                    auto chunk = m_chunks[chunk_index];
+                    for_each_row(chunk_index, [&](uint32_t chunk_offset)
+                    {
+                        invoker.template invoke<decltype(resolution)::value>(
+                                [&] { return chunk->entities()[chunk_offset]; },
+                                [&] { return storage_key(m_table_index, table_offset({chunk_index, chunk_offset})); },
+                                [&](auto type, size_t index) { return component_address(chunk, chunk_offset, component_indices[index]); }
+                        );
+                    });
                 }
-            }
+            });
         }
 
 
-        void dynamic_for_each(sequence_cref<uint32_t> component_indices, function<void(entity, sequence_ref<void*>)> func)
+        //func takes (entity, storage_key, sequence_ref<void*>), the entity and the key are optional
+        template<typename Callable>
+        void dynamic_for_each(sequence_cref<uint32_t> component_indices, Callable&& func)
         {
-            vector<void*> address_cache(component_indices.size());
+            access_buffer<void*> address_cache(component_indices.size());
             dynamic_for_each_impl(func, component_indices, address_cache);
         }
 
-        void dynamic_for_each(sequence_cref<uint32_t> component_indices, function<void(sequence_ref<void*>)> func)
+        //func takes (sequence_cref<entity>, sequence_cref<void*> columns, sequence_cref<uint32_t> strides, uint32_t count)
+        //once per run of live rows in a chunk, the component i of the row r is at columns[i] + r * strides[i]
+        template<typename Callable>
+        void dynamic_for_each_batch(sequence_cref<uint32_t> component_indices, Callable&& func)
         {
-            vector<void*> address_cache(component_indices.size());
-            dynamic_for_each_impl(func, component_indices, address_cache);
-        }
+            access_buffer<void*> columns(component_indices.size());
+            access_buffer<uint32_t> strides(component_indices.size());
+            for (uint32_t i = 0; i < component_indices.size(); i++)
+                strides[i] = m_notnull_components[component_indices[i]].size();
 
-        void dynamic_for_each(sequence_cref<uint32_t> component_indices, function<void(entity, storage_key, sequence_ref<void*>)> func)
-        {
-            vector<void*> address_cache(component_indices.size());
-            dynamic_for_each_impl(func, component_indices, address_cache);
-        }
-
-        void dynamic_for_each(sequence_cref<uint32_t> component_indices, function<void(storage_key, sequence_ref<void*>)> func)
-        {
-            vector<void*> address_cache(component_indices.size());
-            dynamic_for_each_impl(func, component_indices, address_cache);
+            for (uint32_t chunk_index = 0; chunk_index < m_chunks.size(); chunk_index++)
+            {
+                auto chunk = m_chunks[chunk_index];
+                for_each_run(chunk_index, [&](uint32_t begin, uint32_t end)
+                {
+                    for (uint32_t i = 0; i < component_indices.size(); i++)
+                        columns[i] = component_address(chunk, begin, m_notnull_components[component_indices[i]]);
+                    auto entities = chunk->entities();
+                    func(sequence_cref<entity>(entities.begin() + begin, entities.begin() + end),
+                         sequence_cref<void*>(columns), sequence_cref<uint32_t>(strides), end - begin);
+                });
+            }
         }
 
         void get_component_indices(
@@ -1077,6 +1445,12 @@ namespace hyecs
             return sorted_sequence_cref(m_notnull_components);
         }
 
+        //the address of one component of a row, component_index is in the notnull components
+        byte* component_address(storage_key key, uint32_t component_index)
+        {
+            return component_address(chunk_index_offset(key.get_table_offset()), component_index);
+        }
+
         void components_addresses(
                 storage_key key,
                 sequence_cref<uint32_t> component_indices,
@@ -1084,9 +1458,15 @@ namespace hyecs
         {
             auto [chunk_index, chunk_offset] = chunk_index_offset(key.get_table_offset());
             chunk* chunk = m_chunks[chunk_index];
-            for (uint32_t i: component_indices)
+            for (uint32_t i = 0; i < component_indices.size(); i++)
             {
-                auto& type = m_notnull_components[i];
+                //an optional component the table does not have
+                if (component_indices[i] == absent_component_index)
+                {
+                    addresses[i] = nullptr;
+                    continue;
+                }
+                auto& type = m_notnull_components[component_indices[i]];
                 byte* data = component_address(chunk, chunk_offset, type.offset(), type.size());
                 addresses[i] = data;
             }
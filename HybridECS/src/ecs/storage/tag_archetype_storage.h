@@ -29,10 +29,26 @@ namespace hyecs
 			{
 				notify_storage_chunk_convert();
 			});
+			//swap-backs and compaction of the shared table move the rows of this archetype too
+			m_untag_storage->add_callback_on_entities_move(
+				[this](sequence_cref<entity> entities, sequence_cref<storage_key> keys)
+				{
+					notify_entities_move(entities, keys);
+				});
 		}
 
+		archetype_index archetype() const { return m_index; }
+
 		dense_map<entity, storage_key>& entities() { return m_entities; }
 
+		tag_archetype_memory_info memory_info() const
+		{
+			tag_archetype_memory_info info;
+			info.entity_count = m_entities.size();
+			info.index_bytes = m_entities.memory_usage() + m_tag_storages.capacity() * sizeof(component_storage*);
+			return info;
+		}
+
 		void add_callback_on_entity_add(function<void(entity, storage_key)> callback)
 		{
 			for (auto [e, key] : m_entities)
@@ -57,6 +73,13 @@ namespace hyecs
 			}
 		}
 
+		void notify_entities_move(sequence_cref<entity> entities, sequence_cref<storage_key> keys)
+		{
+			for (size_t i = 0; i < entities.size(); i++)
+				if (m_entities.contains(entities[i]))
+					m_entities.at(entities[i]) = keys[i];
+		}
+
 		void notify_storage_sparse_convert()
 		{
 			//todo if this needed?
@@ -108,6 +131,21 @@ namespace hyecs
 			}
 		}
 
+		//destructs the tag and the untag components of the entities, all entities must be in this archetype
+		void destroy_entities(sequence_cref<entity> entities)
+		{
+			for (auto e : entities)
+			{
+				storage_key key = m_entities.at(e);
+				m_entities.erase(e);
+				for (auto& on_remove : m_on_entity_remove)
+					on_remove(e, key);
+			}
+			for (auto storage : m_tag_storages)
+				storage->erase_components(entities);
+			m_untag_storage->destroy_entities(entities);
+		}
+
 		template <typename SeqParam>
 		class allocate_accessor
 		{
@@ -15,6 +15,7 @@ namespace hyecs
         generic::move_constructor_ptr_t m_move_constructor;
         generic::destructor_ptr_t m_destructor;
 		type_hash m_hash;
+		uint32_t m_id;//dense index, assigned at registration
 		bit_key m_bit_id;
 		component_group_index m_group;//todo
         generic::type_flags m_flags : generic::type_flags_count;
@@ -33,13 +34,15 @@ namespace hyecs
               m_move_constructor(type_index.move_constructor_ptr()),
               m_destructor(type_index.destructor_ptr()),
               m_hash(type_index.hash()),
-              m_bit_id(seqence_index_allocator.allocate()),
+              m_id(seqence_index_allocator.allocate()),
+              m_bit_id(m_id),
               m_flags(type_index.flags()),
               m_is_tag(is_tag),
               m_group(group){}
 
         const char* name() const { return m_type_index.name(); }
         bool is_tag() const { return m_is_tag; }
+        uint32_t id() const { return m_id; }
         bit_key bit_key() const { return m_bit_id; }
 		component_group_index group() const { return m_group; }
 		explicit operator const generic::type_index() const { return m_type_index; }
@@ -192,6 +195,14 @@ namespace hyecs
         }
 
     public:
+        uint32_t id(this auto&& self) requires (requires { self.m_id; })
+        {
+            return self.m_id;
+        }
+        uint32_t id(this auto&& self) requires (!requires { self.m_id; }) && (requires { self.m_info; })
+        {
+            return self.m_info->id();
+        }
         struct bit_key bit_key(this auto&& self) requires (requires { self.m_bit_id; })
         {
             return self.m_bit_id;
@@ -40,6 +40,7 @@
 
 #include <format>
 #include <bit>
+#include <chrono>
 
 
 #include <ranges>
@@ -1,5 +1,8 @@
 ﻿#include "pch.h"
 
+//allocation accounting of the test executable, see test_steady_state_alloc.cpp
+#include "core/alloc_counter_hook.h"
+
 int main()
 {
 
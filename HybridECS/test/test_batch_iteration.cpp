@@ -0,0 +1,149 @@
+#include "pch.h"
+
+#include "ecs/static_data_registry.h"
+#include "ecs/type/component_group.h"
+#include "../test_util/ut.hpp"
+
+using namespace hyecs;
+
+namespace test_batch_iteration
+{
+#define CONCATENATE_DIRECT(a, b) a##b
+#define CONCATENATE(a, b) CONCATENATE_DIRECT(a, b)
+#define ANON CONCATENATE(_ecs_register_, __COUNTER__)
+
+    constexpr auto group_batch = named_component_group<"Group Batch">();
+    ecs_rtti_group_register ANON(group_batch);
+
+    struct P
+    {
+        int x;
+    };
+
+    struct V
+    {
+        int x;
+    };
+
+    struct Level : tag_component
+    {
+        int level;
+    };
+
+    ecs_rtti_register<P, group_batch> ANON;
+    ecs_rtti_register<V, group_batch> ANON;
+    ecs_rtti_register<Level, group_batch> ANON;
+
+    struct register_idents
+    {
+        enum
+        {
+            main,
+        };
+    };
+
+    class batch_registry : public immediate_data_registry<register_idents::main>
+    {
+        using immediate_data_registry::immediate_data_registry;
+    };
+}
+
+namespace ut = boost::ut;
+
+static ut::suite test_suite = []
+{
+    using namespace ut;
+    using namespace test_batch_iteration;
+
+    //compares the batch pass with the per entity pass of the query, returns the longest run
+    static auto check_batches = [](batch_registry& registry, query& q, size_t expected_rows)
+    {
+        auto types = registry.component_types<P, V>();
+        auto& access = q.get_access_info(types);
+
+        unordered_map<entity, int> expected;
+        q.dynamic_for_each(access, [&](entity e, sequence_ref<void*> data)
+        {
+            auto [p, v] = data.cast_tuple<P*, V*>();
+            expected[e] = p->x * 10 + v->x;
+        });
+        expect(expected.size() == expected_rows);
+
+        size_t batch_count = 0;
+        size_t row_count = 0;
+        uint32_t longest = 0;
+        q.dynamic_for_each_batch(access, [&](sequence_cref<entity> batch_entities, sequence_cref<void*> columns,
+                                             sequence_cref<uint32_t> strides, uint32_t count)
+        {
+            expect(batch_entities.size() == count);
+            expect(strides[0] == sizeof(P) && strides[1] == sizeof(V));
+            for (uint32_t r = 0; r < count; r++)
+            {
+                auto p = reinterpret_cast<P*>(static_cast<std::byte*>(columns[0]) + r * strides[0]);
+                auto v = reinterpret_cast<V*>(static_cast<std::byte*>(columns[1]) + r * strides[1]);
+                auto iter = expected.find(batch_entities[r]);
+                expect(iter != expected.end() && iter->second == p->x * 10 + v->x);
+            }
+            batch_count++;
+            row_count += count;
+            longest = std::max(longest, count);
+        });
+        expect(row_count == expected_rows);
+        expect(batch_count < row_count);
+        return longest;
+    };
+
+    "batch iteration visits the rows of the per entity iteration"_test = []
+    {
+        batch_registry registry(ecs_global_rtti_context::register_context());
+
+        //a chunk table and a tag archetype over it
+        vector<entity> entities(4000);
+        registry.emplace_static(entities, P{1}, V{2});
+        vector<entity> few(8);
+        registry.emplace_static(few, P{3}, V{4}, Level{{}, 5});
+
+        auto& q = registry.get_query({{registry.component_types<P, V>()}, {}, {}});
+        expect(check_batches(registry, q, 4008) > 1_u);
+    };
+
+    "batch iteration splits the runs on the holes of a table"_test = []
+    {
+        batch_registry registry(ecs_global_rtti_context::register_context());
+
+        //the rows of a fresh table follow the emplace order
+        vector<entity> entities(4000);
+        registry.emplace_static(entities, P{1}, V{2});
+        auto& q = registry.get_query({{registry.component_types<P, V>()}, {}, {}});
+
+        //scattered holes, some around the 64 row words of the hole mask
+        vector<entity> destroyed;
+        for (size_t row: {5, 63, 64, 65, 127, 128, 300, 301, 302, 1500, 3999})
+            destroyed.push_back(entities[row]);
+        auto components = registry.component_types<P, V>();
+        registry.destroy(sorted_sequence_cref<component_type_index>(components.begin(), components.end()), destroyed);
+
+        //the run between the holes 128 and 300 is joined across the words
+        expect(check_batches(registry, q, entities.size() - destroyed.size()) > 64_u);
+    };
+
+    "batch iteration joins the consecutive slots of a sparse archetype"_test = []
+    {
+        batch_registry registry(ecs_global_rtti_context::register_context());
+        storage_policy sparse;
+        sparse.select = [](const storage_policy_context&) { return storage_layout::sparse; };
+        registry.set_storage_policy(sparse);
+
+        vector<entity> entities(2000);
+        registry.emplace_static(entities, P{1}, V{2});
+        vector<entity> destroyed;
+        for (size_t i = 0; i < entities.size(); i += 97)
+            destroyed.push_back(entities[i]);
+        auto components = registry.component_types<P, V>();
+        registry.destroy(sorted_sequence_cref<component_type_index>(components.begin(), components.end()), destroyed);
+
+        auto& q = registry.get_query({{registry.component_types<P, V>()}, {}, {}});
+        uint32_t longest = check_batches(registry, q, entities.size() - destroyed.size());
+        expect(longest > 1_u && longest <= column_run_builder::max_run_rows);
+    };
+};
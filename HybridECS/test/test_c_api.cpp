@@ -0,0 +1,229 @@
+#include "pch.h"
+
+#include "capi/hyecs_c.h"
+#include "../test_util/ut.hpp"
+
+using namespace hyecs;
+
+namespace test_c_api
+{
+    struct position
+    {
+        float x, y;
+    };
+
+    struct velocity
+    {
+        float x, y;
+    };
+
+    int g_handle_copies = 0;
+    int g_handle_destroys = 0;
+
+    //a component with host lifetime callbacks, moved with memcpy
+    struct handle
+    {
+        int value;
+    };
+
+    void* handle_copy(void* dest, const void* src)
+    {
+        g_handle_copies++;
+        return std::memcpy(dest, src, sizeof(handle));
+    }
+
+    void handle_destroy(void* addr)
+    {
+        boost::ut::expect(static_cast<handle*>(addr)->value == 7);
+        g_handle_destroys++;
+    }
+
+    struct integrate_state
+    {
+        size_t rows = 0;
+        size_t batches = 0;
+    };
+
+    void integrate(void* user_data, const hyecs_entity*, void* const* columns, const uint32_t* strides, uint32_t count)
+    {
+        auto& state = *static_cast<integrate_state*>(user_data);
+        for (uint32_t r = 0; r < count; r++)
+        {
+            auto& p = *reinterpret_cast<position*>(static_cast<std::byte*>(columns[0]) + r * strides[0]);
+            auto& v = *reinterpret_cast<velocity*>(static_cast<std::byte*>(columns[1]) + r * strides[1]);
+            p.x += v.x;
+            p.y += v.y;
+        }
+        state.rows += count;
+        state.batches++;
+    }
+
+    struct mass
+    {
+        float value;
+    };
+
+    struct order_state
+    {
+        float first;
+        float second;
+        size_t rows = 0;
+    };
+
+    //reads the first float of the two accessed components
+    void check_order(void* user_data, const hyecs_entity*, void* const* columns, const uint32_t* strides, uint32_t count)
+    {
+        auto& state = *static_cast<order_state*>(user_data);
+        for (uint32_t r = 0; r < count; r++)
+        {
+            auto first = *reinterpret_cast<float*>(static_cast<std::byte*>(columns[0]) + r * strides[0]);
+            auto second = *reinterpret_cast<float*>(static_cast<std::byte*>(columns[1]) + r * strides[1]);
+            boost::ut::expect(first == state.first && second == state.second);
+        }
+        state.rows += count;
+    }
+}
+
+namespace ut = boost::ut;
+
+static ut::suite test_suite = []
+{
+    using namespace ut;
+    using namespace test_c_api;
+
+    "c api spawn, iterate in batches and destroy"_test = []
+    {
+        hyecs_world* world = hyecs_world_create();
+        expect(world != nullptr);
+
+        hyecs_component_desc position_desc{"c_api::position", "c_api", sizeof(position), alignof(position)};
+        hyecs_component_desc velocity_desc{"c_api::velocity", "c_api", sizeof(velocity), alignof(velocity)};
+        hyecs_component_desc handle_desc{"c_api::handle", "c_api", sizeof(handle), alignof(handle), 0,
+                                         handle_copy, nullptr, handle_destroy};
+        hyecs_component p_id, v_id, h_id;
+        expect(hyecs_component_register(world, &position_desc, &p_id) == HYECS_OK);
+        expect(hyecs_component_register(world, &velocity_desc, &v_id) == HYECS_OK);
+        expect(hyecs_component_register(world, &handle_desc, &h_id) == HYECS_OK);
+        expect(hyecs_component_register(world, &position_desc, &p_id) == HYECS_DUPLICATE_COMPONENT);
+
+        position p0{1, 2};
+        velocity v0{0.5f, -1};
+        handle h0{7};
+        //the components in any order
+        hyecs_component moving[] = {v_id, p_id};
+        const void* moving_values[] = {&v0, &p0};
+        vector<hyecs_entity> movers(3000);
+        expect(hyecs_spawn(world, moving, 2, moving_values, movers.data(), uint32_t(movers.size())) == HYECS_OK);
+
+        hyecs_component owned[] = {p_id, v_id, h_id};
+        const void* owned_values[] = {nullptr, &v0, &h0};
+        vector<hyecs_entity> owners(40);
+        expect(hyecs_spawn(world, owned, 3, owned_values, owners.data(), uint32_t(owners.size())) == HYECS_OK);
+        expect(g_handle_copies == 40_i);
+
+        hyecs_query* q = nullptr;
+        hyecs_component all[] = {p_id, v_id};
+        expect(hyecs_query_get(world, all, 2, nullptr, 0, &q) == HYECS_OK);
+        hyecs_component access[] = {p_id, v_id};
+        integrate_state state;
+        expect(hyecs_query_for_each_batch(world, q, access, 2, integrate, &state) == HYECS_OK);
+        expect(state.rows == 3040_u);
+        expect(state.batches < state.rows);
+
+        //the zeroed positions moved by one step, the others by one step from p0
+        size_t zero_based = 0;
+        expect(hyecs_query_for_each_batch(world, q, access, 1,
+                                          [](void* user_data, const hyecs_entity*, void* const* columns, const uint32_t* strides, uint32_t count)
+                                          {
+                                              for (uint32_t r = 0; r < count; r++)
+                                              {
+                                                  auto& p = *reinterpret_cast<position*>(static_cast<std::byte*>(columns[0]) + r * strides[0]);
+                                                  if (p.x == 0.5f && p.y == -1) ++*static_cast<size_t*>(user_data);
+                                                  else expect(p.x == 1.5f && p.y == 1);
+                                              }
+                                          }, &zero_based) == HYECS_OK);
+        expect(zero_based == 40_u);
+
+        expect(hyecs_destroy(world, owned, 3, owners.data(), uint32_t(owners.size())) == HYECS_OK);
+        expect(g_handle_destroys >= 40_i);
+        expect(hyecs_destroy(world, moving, 2, movers.data(), 1000) == HYECS_OK);
+        state = {};
+        expect(hyecs_query_for_each_batch(world, q, access, 2, integrate, &state) == HYECS_OK);
+        expect(state.rows == 2000_u);
+
+        hyecs_world_destroy(world);
+    };
+
+    "c api columns follow the order of each access list"_test = []
+    {
+        hyecs_world* world = hyecs_world_create();
+        hyecs_component_desc position_desc{"c_api::order_position", "c_api_order", sizeof(position), alignof(position)};
+        hyecs_component_desc mass_desc{"c_api::order_mass", "c_api_order", sizeof(mass), alignof(mass)};
+        hyecs_component p_id, m_id;
+        expect(hyecs_component_register(world, &position_desc, &p_id) == HYECS_OK);
+        expect(hyecs_component_register(world, &mass_desc, &m_id) == HYECS_OK);
+
+        position p0{3, 4};
+        mass m0{5};
+        hyecs_component spawned[] = {p_id, m_id};
+        const void* values[] = {&p0, &m0};
+        vector<hyecs_entity> entities(2000);
+        expect(hyecs_spawn(world, spawned, 2, values, entities.data(), uint32_t(entities.size())) == HYECS_OK);
+
+        hyecs_query* q = nullptr;
+        expect(hyecs_query_get(world, spawned, 2, nullptr, 0, &q) == HYECS_OK);
+
+        //the same components in the other order on the same query
+        hyecs_component position_first[] = {p_id, m_id};
+        order_state state{3, 5};
+        expect(hyecs_query_for_each_batch(world, q, position_first, 2, check_order, &state) == HYECS_OK);
+        expect(state.rows == 2000_u);
+
+        hyecs_component mass_first[] = {m_id, p_id};
+        state = {5, 3};
+        expect(hyecs_query_for_each_batch(world, q, mass_first, 2, check_order, &state) == HYECS_OK);
+        expect(state.rows == 2000_u);
+
+        state = {3, 5};
+        expect(hyecs_query_for_each_batch(world, q, position_first, 2, check_order, &state) == HYECS_OK);
+        expect(state.rows == 2000_u);
+
+        hyecs_world_destroy(world);
+    };
+
+    "c api rejects invalid arguments"_test = []
+    {
+        hyecs_world* world = hyecs_world_create();
+        hyecs_component_desc a_desc{"c_api::a", "c_api_first", sizeof(int), alignof(int)};
+        hyecs_component_desc b_desc{"c_api::b", "c_api_second", sizeof(int), alignof(int)};
+        hyecs_component_desc bad_desc{"c_api::bad", nullptr, 4, 3};
+        hyecs_component a_id, b_id, bad_id;
+        expect(hyecs_component_register(world, &a_desc, &a_id) == HYECS_OK);
+        expect(hyecs_component_register(world, &b_desc, &b_id) == HYECS_OK);
+        expect(hyecs_component_register(world, &bad_desc, &bad_id) == HYECS_INVALID_ARGUMENT);
+
+        hyecs_component repeated[] = {a_id, a_id};
+        hyecs_entity e;
+        expect(hyecs_spawn(world, repeated, 2, nullptr, &e, 1) == HYECS_INVALID_ARGUMENT);
+        hyecs_component unknown = 100;
+        expect(hyecs_spawn(world, &unknown, 1, nullptr, &e, 1) == HYECS_INVALID_ARGUMENT);
+
+        hyecs_query* q = nullptr;
+        hyecs_component both[] = {a_id, b_id};
+        expect(hyecs_query_get(world, both, 2, nullptr, 0, &q) == HYECS_CROSS_GROUP_QUERY);
+
+        //the access components must be in the query, the query must be of the world
+        hyecs_batch_fn noop = [](void*, const hyecs_entity*, void* const*, const uint32_t*, uint32_t) {};
+        expect(hyecs_spawn(world, &a_id, 1, nullptr, &e, 1) == HYECS_OK);
+        expect(hyecs_query_get(world, &a_id, 1, nullptr, 0, &q) == HYECS_OK);
+        expect(hyecs_query_for_each_batch(world, q, &a_id, 1, noop, nullptr) == HYECS_OK);
+        expect(hyecs_query_for_each_batch(world, q, &b_id, 1, noop, nullptr) == HYECS_INVALID_ARGUMENT);
+        expect(hyecs_query_for_each_batch(world, q, both, 2, noop, nullptr) == HYECS_INVALID_ARGUMENT);
+        hyecs_world* other_world = hyecs_world_create();
+        hyecs_component other_a_id;
+        expect(hyecs_component_register(other_world, &a_desc, &other_a_id) == HYECS_OK);
+        expect(hyecs_query_for_each_batch(other_world, q, &other_a_id, 1, noop, nullptr) == HYECS_INVALID_ARGUMENT);
+        hyecs_world_destroy(other_world);
+        hyecs_world_destroy(world);
+    };
+};
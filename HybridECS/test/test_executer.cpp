@@ -0,0 +1,265 @@
+#include "pch.h"
+
+#include "ecs/static_data_registry.h"
+#include "ecs/type/component_group.h"
+#include "../test_util/ut.hpp"
+
+using namespace hyecs;
+
+namespace test_executer
+{
+#define CONCATENATE_DIRECT(a, b) a##b
+#define CONCATENATE(a, b) CONCATENATE_DIRECT(a, b)
+#define ANON CONCATENATE(_ecs_register_, __COUNTER__)
+
+    constexpr auto group_executer = named_component_group<"Group Executer">();
+    ecs_rtti_group_register ANON(group_executer);
+
+    struct P
+    {
+        int x;
+    };
+
+    struct V
+    {
+        int x;
+    };
+
+    struct Mass
+    {
+        int x;
+    };
+
+    struct Frozen
+    {
+        int x;
+    };
+
+    struct Marker : tag_component
+    {
+        int level;
+    };
+
+    struct Instance
+    {
+        int data[4];
+    };
+
+    ecs_rtti_register<P, group_executer> ANON;
+    ecs_rtti_register<V, group_executer> ANON;
+    ecs_rtti_register<Mass, group_executer> ANON;
+    ecs_rtti_register<Frozen, group_executer> ANON;
+    ecs_rtti_register<Marker, group_executer> ANON;
+    ecs_rtti_register<Instance, group_executer> ANON;
+
+    struct register_idents
+    {
+        enum
+        {
+            main,
+        };
+    };
+
+    class executer_registry : public immediate_data_registry<register_idents::main>
+    {
+        using immediate_data_registry::immediate_data_registry;
+    };
+}
+
+namespace ut = boost::ut;
+
+static ut::suite test_suite = []
+{
+    using namespace ut;
+    using namespace test_executer;
+    using namespace hyecs::query_parameter;
+
+    "executer resolves filters, optional and write parameters"_test = []
+    {
+        executer_registry registry(ecs_global_rtti_context::register_context());
+
+        vector<entity> plain(100);
+        registry.emplace_static(plain, P{0}, V{2});
+        vector<entity> heavy(50);
+        registry.emplace_static(heavy, P{0}, V{2}, Mass{3});
+        vector<entity> frozen(20);
+        registry.emplace_static(frozen, P{0}, V{2}, Frozen{});
+        vector<entity> marked(10);
+        registry.emplace_static(marked, P{0}, V{2}, Mass{3}, Marker{{}, 1});
+
+        executer_builder builder(registry);
+
+        size_t moved = 0;
+        size_t with_mass = 0;
+        auto integrate = builder.register_executer([&](P& p, const V& v, optional<const Mass> mass, none_of<Frozen>)
+        {
+            if (mass) with_mass++;
+            p.x += v.x * (mass ? mass->x : 1);
+            moved++;
+        });
+        integrate();
+        expect(moved == 160_u);
+        expect(with_mass == 60_u);
+
+        //archetypes added after the registration are reached by the query
+        vector<entity> late(5);
+        registry.emplace_static(late, P{0}, V{2}, Mass{1}, Frozen{});
+
+        size_t written = 0;
+        auto overwrite = builder.register_executer([&](const V& v, write<P> p, any_of<Mass, Frozen>)
+        {
+            p = P{v.x * 10};
+            written++;
+        });
+        overwrite();
+        expect(written == 85_u);
+
+        unordered_map<entity, int> positions;
+        auto collect = builder.register_executer([&](entity e, const P& p)
+        {
+            positions[e] = p.x;
+        });
+        collect();
+        expect(positions.size() == 185_u);
+        for (auto e: plain) expect(positions[e] == 2);
+        for (auto e: heavy) expect(positions[e] == 20);
+        for (auto e: frozen) expect(positions[e] == 20);
+        for (auto e: marked) expect(positions[e] == 20);
+        for (auto e: late) expect(positions[e] == 20);
+    };
+
+    "executer resolves optional and variant components per storage"_test = []
+    {
+        executer_registry registry(ecs_global_rtti_context::register_context());
+
+        vector<entity> heavy(30);
+        registry.emplace_static(heavy, P{0}, Mass{3});
+        vector<entity> frozen(20);
+        registry.emplace_static(frozen, P{0}, Frozen{4});
+        vector<entity> both(10);
+        registry.emplace_static(both, P{0}, Mass{3}, Frozen{4});
+        vector<entity> marked(8);
+        registry.emplace_static(marked, P{0}, Marker{{}, 5});
+        vector<entity> marked_heavy(4);
+        registry.emplace_static(marked_heavy, P{0}, Mass{3}, Marker{{}, 5});
+
+        executer_builder builder(registry);
+
+        size_t mass_rows = 0;
+        size_t frozen_rows = 0;
+        auto weigh = builder.register_executer([&](P& p, variant<const Mass&, const Frozen&> v)
+        {
+            if (v.index() == 0) mass_rows++;
+            else frozen_rows++;
+            v.visit([&](const auto& component) { p.x = component.x; });
+        });
+        weigh();
+        //the first alternative the archetype has is held
+        expect(mass_rows == 44_u);
+        expect(frozen_rows == 20_u);
+
+        //a tag in the condition goes through the table tag queries
+        size_t marked_rows = 0;
+        size_t marked_with_mass = 0;
+        auto mark = builder.register_executer([&](const Marker& marker, optional<Mass> mass, P& p)
+        {
+            marked_rows++;
+            if (mass.has_value())
+            {
+                marked_with_mass++;
+                mass->x += marker.level;
+            }
+            p.x += marker.level;
+        });
+        mark();
+        expect(marked_rows == 12_u);
+        expect(marked_with_mass == 4_u);
+
+        unordered_map<entity, int> positions;
+        builder.register_executer([&](entity e, const P& p) { positions[e] = p.x; })();
+        for (auto e: heavy) expect(positions[e] == 3);
+        for (auto e: frozen) expect(positions[e] == 4);
+        for (auto e: both) expect(positions[e] == 3);
+        for (auto e: marked) expect(positions[e] == 5);
+        for (auto e: marked_heavy) expect(positions[e] == 8);
+    };
+
+    "write parameters do not read and stream large columns"_test = []
+    {
+        executer_registry registry(ecs_global_rtti_context::register_context());
+
+        //a column past the streaming threshold and one below it
+        vector<entity> large(memory::streaming_store_threshold / sizeof(Instance) + 16);
+        registry.emplace_static(large, P{7}, Instance{});
+        vector<entity> small(100);
+        registry.emplace_static(small, P{7}, Instance{}, Mass{1});
+
+        executer_builder builder(registry);
+        auto fill = builder.register_executer([](const P& p, write<Instance> out)
+        {
+            out = Instance{{p.x, p.x + 1, p.x + 2, p.x + 3}};
+        });
+        auto read_back = builder.register_executer([](const Instance& instance, P& p)
+        {
+            p.x = instance.data[0] + instance.data[3];
+        });
+
+        auto p_index = registry.get_component_index(type_hash::of<P>());
+        auto instance_index = registry.get_component_index(type_hash::of<Instance>());
+        expect(fill.access().reads == vector<component_type_index>{p_index});
+        expect(fill.access().writes == vector<component_type_index>{instance_index});
+        expect(read_back.access().reads_from(fill.access()));
+        expect(!fill.access().reads_from(read_back.access()));
+        expect(fill.access().depends_on(read_back.access()));
+
+        fill();
+        size_t filled = 0;
+        builder.register_executer([&](const Instance& instance)
+        {
+            expect(instance.data[0] == 7 && instance.data[3] == 10);
+            filled++;
+        })();
+        expect(filled == large.size() + small.size());
+
+        read_back();
+        size_t checked = 0;
+        builder.register_executer([&](const P& p)
+        {
+            expect(p.x == 17);
+            checked++;
+        })();
+        expect(checked == filled);
+    };
+
+    "executers on the same query keep their own parameter order"_test = []
+    {
+        executer_registry registry(ecs_global_rtti_context::register_context());
+
+        //components of different sizes, a column read as the other one is caught
+        vector<entity> plain(2000);
+        registry.emplace_static(plain, P{0}, Instance{{1, 2, 3, 4}});
+        vector<entity> heavy(100);
+        registry.emplace_static(heavy, P{0}, Instance{{1, 2, 3, 4}}, Mass{1});
+
+        executer_builder builder(registry);
+        auto forward = builder.register_executer([](P& p, const Instance& instance)
+        {
+            p.x = instance.data[3];
+        });
+        auto backward = builder.register_executer([](const Instance& instance, P& p)
+        {
+            p.x += instance.data[0];
+        });
+        forward();
+        backward();
+
+        size_t checked = 0;
+        builder.register_executer([&](const P& p, const Instance& instance)
+        {
+            expect(p.x == 5);
+            expect(instance.data[0] == 1 && instance.data[1] == 2 && instance.data[2] == 3 && instance.data[3] == 4);
+            checked++;
+        })();
+        expect(checked == plain.size() + heavy.size());
+    };
+};
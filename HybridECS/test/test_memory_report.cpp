@@ -0,0 +1,107 @@
+#include "pch.h"
+
+#include "ecs/static_data_registry.h"
+#include "ecs/type/component_group.h"
+#include "../test_util/ut.hpp"
+
+using namespace hyecs;
+
+namespace test_memory_report
+{
+#define CONCATENATE_DIRECT(a, b) a##b
+#define CONCATENATE(a, b) CONCATENATE_DIRECT(a, b)
+#define ANON CONCATENATE(_ecs_register_, __COUNTER__)
+
+    constexpr auto group_mem = named_component_group<"Group Memory">();
+    ecs_rtti_group_register ANON(group_mem);
+
+    struct P
+    {
+        int x;
+    };
+
+    struct V
+    {
+        int x;
+    };
+
+    ecs_rtti_register<P, group_mem> ANON;
+    ecs_rtti_register<V, group_mem> ANON;
+
+    struct register_idents
+    {
+        enum
+        {
+            main,
+        };
+    };
+
+    class memory_registry : public immediate_data_registry<register_idents::main>
+    {
+        using immediate_data_registry::immediate_data_registry;
+    };
+}
+
+namespace ut = boost::ut;
+
+static ut::suite test_suite = []
+{
+    using namespace ut;
+    using namespace test_memory_report;
+
+    "memory report"_test = []
+    {
+        memory_registry registry(ecs_global_rtti_context::register_context());
+        registry.get_query({{registry.component_types<P, V>()}, {}, {}});
+
+        auto find_archetype = [](const registry_memory_report& report, size_t entity_count)
+        {
+            return std::ranges::find_if(report.archetypes, [&](auto& info) { return info.entity_count == entity_count; });
+        };
+        auto find_storage = [](const registry_memory_report& report, std::string_view name)
+        {
+            return std::ranges::find_if(report.component_storages, [&](auto& info) { return info.name == name; });
+        };
+
+        vector<entity> entities(8);
+        registry.emplace_static(entities, P{1}, V{2});
+        {
+            auto report = registry.memory_report();
+            auto arch = find_archetype(report, 8);
+            expect(arch != report.archetypes.end());
+            expect(arch->layout == storage_layout::sparse);
+            expect(arch->chunk_count == 0_u);
+            auto p_storage = find_storage(report, "P");
+            expect(p_storage != report.component_storages.end());
+            expect(p_storage->dense_size == 8_u);
+            expect(p_storage->sparse_occupied_count == 8_u);
+            expect(p_storage->sparse_occupancy() > 0.0f);
+            expect(report.total_bytes() > 0_u);
+        }
+
+        entities.resize(4000);
+        registry.emplace_static(entities, P{1}, V{2});
+        {
+            auto report = registry.memory_report();
+            auto arch = find_archetype(report, 4008);
+            expect(arch != report.archetypes.end());
+            expect(arch->layout == storage_layout::chunk);
+            expect(arch->row_count == 4008_u);
+            expect(arch->chunk_count > 0_u);
+            expect(arch->used_bytes <= arch->reserved_bytes);
+            expect(arch->fill_ratio() > 0.0f && arch->fill_ratio() <= 1.0f);
+            expect(arch->hole_count == 0_u);
+            expect(find_storage(report, "P")->dense_size == 0_u);
+            expect(report.storage_key_count >= 4008_u);
+            expect(std::ranges::any_of(report.queries, [](auto& info)
+            {
+                return info.kind == query_memory_info::query_kind::query;
+            }));
+
+            auto json = report.to_json();
+            expect(json.front() == '{' && json.back() == '}');
+            expect(json.find("\"archetypes\":[") != std::string::npos);
+            expect(json.find("\"layout\":\"chunk\"") != std::string::npos);
+        }
+    };
+};
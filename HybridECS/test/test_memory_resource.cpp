@@ -0,0 +1,126 @@
+#include "pch.h"
+
+#include "ecs/static_data_registry.h"
+#include "ecs/type/component_group.h"
+#include "../test_util/ut.hpp"
+
+using namespace hyecs;
+
+namespace test_memory_resource
+{
+#define CONCATENATE_DIRECT(a, b) a##b
+#define CONCATENATE(a, b) CONCATENATE_DIRECT(a, b)
+#define ANON CONCATENATE(_ecs_register_, __COUNTER__)
+
+    constexpr auto group_world = named_component_group<"Group Memory Resource">();
+    ecs_rtti_group_register ANON(group_world);
+
+    struct P
+    {
+        int x;
+    };
+
+    struct V
+    {
+        int x;
+    };
+
+    ecs_rtti_register<P, group_world> ANON;
+    ecs_rtti_register<V, group_world> ANON;
+
+    struct register_idents
+    {
+        enum
+        {
+            main,
+        };
+    };
+
+    class world_registry : public immediate_data_registry<register_idents::main>
+    {
+        using immediate_data_registry::immediate_data_registry;
+    };
+
+    //forwards to new/delete and keeps the balance
+    class counting_resource : public std::pmr::memory_resource
+    {
+    public:
+        size_t live_bytes = 0;
+        size_t allocation_count = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+            live_bytes += bytes;
+            allocation_count++;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+        {
+            live_bytes -= bytes;
+            std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    void populate(world_registry& registry, size_t entity_count)
+    {
+        vector<entity> entities(entity_count);
+        registry.emplace_static(entities, P{1}, V{2});
+        auto& q = registry.get_query({{registry.component_types<P, V>()}, {}, {}});
+        auto& access = q.get_access_info(registry.component_types<P, V>());
+        int sum = 0;
+        q.dynamic_for_each(access, [&](entity, sequence_ref<void*> data)
+        {
+            auto [p, v] = data.cast_tuple<P*, V*>();
+            sum += p->x + v->x;
+        });
+        boost::ut::expect(sum == int(entity_count * 3));
+    }
+}
+
+namespace ut = boost::ut;
+
+static ut::suite test_suite = []
+{
+    using namespace ut;
+    using namespace test_memory_resource;
+
+    "registries allocate from their own resource"_test = []
+    {
+        counting_resource first_resource;
+        counting_resource second_resource;
+        {
+            world_registry first(ecs_global_rtti_context::register_context(), {}, &first_resource);
+            world_registry second(ecs_global_rtti_context::register_context(), {}, &second_resource);
+            expect(first.memory_resource() == &first_resource);
+            expect(memory::current_resource() == std::pmr::new_delete_resource());
+
+            populate(first, 4000);
+            size_t second_before = second_resource.allocation_count;
+            populate(second, 16);
+            expect(first_resource.live_bytes > 0_u);
+            expect(second_resource.allocation_count > second_before);
+        }
+        //everything went back to the resource it came from
+        expect(first_resource.live_bytes == 0_u);
+        expect(second_resource.live_bytes == 0_u);
+    };
+
+    "a monotonic world is released at once"_test = []
+    {
+        counting_resource upstream;
+        {
+            std::pmr::monotonic_buffer_resource world_memory(64 * 1024, &upstream);
+            {
+                world_registry world(ecs_global_rtti_context::register_context(), {}, &world_memory);
+                populate(world, 4000);
+            }
+            expect(upstream.live_bytes > 0_u);
+            world_memory.release();
+            expect(upstream.live_bytes == 0_u);
+        }
+    };
+};
@@ -0,0 +1,120 @@
+#include "pch.h"
+
+#include "ecs/static_data_registry.h"
+#include "ecs/type/component_group.h"
+#include "../test_util/ut.hpp"
+
+using namespace hyecs;
+
+namespace test_query_matching
+{
+#define CONCATENATE_DIRECT(a, b) a##b
+#define CONCATENATE(a, b) CONCATENATE_DIRECT(a, b)
+#define ANON CONCATENATE(_ecs_register_, __COUNTER__)
+
+    constexpr auto group_match = named_component_group<"Group Matching">();
+    ecs_rtti_group_register ANON(group_match);
+
+    struct A
+    {
+        int x;
+    };
+
+    struct B
+    {
+        int x;
+    };
+
+    struct C
+    {
+        int x;
+    };
+
+    struct T
+    {
+    };
+
+    struct U
+    {
+    };
+
+    ecs_rtti_register<A, group_match> ANON;
+    ecs_rtti_register<B, group_match> ANON;
+    ecs_rtti_register<C, group_match> ANON;
+    ecs_rtti_register<T, group_match> ANON;
+    ecs_rtti_register<U, group_match> ANON;
+
+    struct register_idents
+    {
+        enum
+        {
+            main,
+        };
+    };
+
+    class matching_registry : public immediate_data_registry<register_idents::main>
+    {
+        using immediate_data_registry::immediate_data_registry;
+    };
+}
+
+namespace ut = boost::ut;
+
+static ut::suite test_suite = []
+{
+    using namespace ut;
+    using namespace test_query_matching;
+
+    //the same queries registered before and after their archetypes match the same entities
+    auto check_matching = [](bool queries_first)
+    {
+        matching_registry registry(ecs_global_rtti_context::register_context());
+
+        auto emplace = [&]
+        {
+            vector<entity> entities(3);
+            registry.emplace_static(entities, A{1});
+            registry.emplace_static(entities, A{1}, B{2});
+            registry.emplace_static(entities, A{1}, B{2}, C{3});
+            registry.emplace_static(entities, A{1}, T{});
+            registry.emplace_static(entities, A{1}, B{2}, T{}, U{});
+            registry.emplace_static(entities, B{2}, T{}, U{});
+        };
+
+        auto get_queries = [&]
+        {
+            return std::array<query*, 4>{
+                &registry.get_query({{registry.component_types<A, B>()}, {}, {}}),
+                &registry.get_query({{registry.component_types<A>()}, {}, {registry.component_types<C>()}}),
+                &registry.get_query({{registry.component_types<A, T>()}, {}, {}}),
+                &registry.get_query({{registry.component_types<B, T, U>()}, {}, {}}),
+            };
+        };
+
+        std::array<query*, 4> queries;
+        if (queries_first)
+        {
+            queries = get_queries();
+            emplace();
+        }
+        else
+        {
+            emplace();
+            queries = get_queries();
+        }
+
+        auto count = [&](query& q, auto access)
+        {
+            int n = 0;
+            q.dynamic_for_each(q.get_access_info(access), [&](entity, sequence_ref<void*>) { n++; });
+            return n;
+        };
+        expect(count(*queries[0], registry.component_types<A, B>()) == 9_i);
+        expect(count(*queries[1], registry.component_types<A>()) == 12_i);
+        expect(count(*queries[2], registry.component_types<A>()) == 6_i);
+        expect(count(*queries[3], registry.component_types<B>()) == 6_i);
+    };
+
+    "queries before archetypes"_test = [=] { check_matching(true); };
+    "queries after archetypes"_test = [=] { check_matching(false); };
+};
@@ -0,0 +1,209 @@
+#include "pch.h"
+
+#include "ecs/static_data_registry.h"
+#include "ecs/type/component_group.h"
+#include "../test_util/ut.hpp"
+
+using namespace hyecs;
+
+namespace test_relation
+{
+#define CONCATENATE_DIRECT(a, b) a##b
+#define CONCATENATE(a, b) CONCATENATE_DIRECT(a, b)
+#define ANON CONCATENATE(_ecs_register_, __COUNTER__)
+
+    constexpr auto group_relation = named_component_group<"Group Relation">();
+    ecs_rtti_group_register ANON(group_relation);
+
+    struct Position
+    {
+        int x;
+    };
+
+    struct Health
+    {
+        int hp;
+    };
+
+    struct Weight
+    {
+        int w;
+    };
+
+    struct child_of
+    {
+    };
+
+    struct owns
+    {
+    };
+
+    ecs_rtti_register<Position, group_relation> ANON;
+    ecs_rtti_register<Health, group_relation> ANON;
+    ecs_rtti_register<Weight, group_relation> ANON;
+    ecs_rtti_register<child_of, group_relation> ANON;
+    ecs_rtti_register<owns, group_relation> ANON;
+
+    struct register_idents
+    {
+        enum
+        {
+            main,
+        };
+    };
+
+    class relation_registry : public immediate_data_registry<register_idents::main>
+    {
+        using immediate_data_registry::immediate_data_registry;
+    };
+}
+
+namespace ut = boost::ut;
+
+static ut::suite test_suite = []
+{
+    using namespace ut;
+    using namespace test_relation;
+    using namespace hyecs::query_parameter;
+
+    "relation storage keeps forward and reverse adjacency"_test = []
+    {
+        relation_registry registry(ecs_global_rtti_context::register_context());
+
+        vector<entity> parents(3);
+        registry.emplace_static(parents, Position{0});
+        vector<entity> children(9);
+        registry.emplace_static(children, Position{0});
+
+        for (size_t i = 0; i < children.size(); i++)
+            registry.add_relation<child_of>(children[i], parents[i % parents.size()]);
+        //a repeated pair is kept once
+        registry.add_relation<child_of>(children[0], parents[0]);
+
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            auto targets = registry.relation_targets<child_of>(children[i]);
+            expect(targets.size() == 1_u);
+            expect(targets[0] == parents[i % parents.size()]);
+        }
+        auto sources = registry.relation_sources<child_of>(parents[1]);
+        expect(sources.size() == 3_u);
+        expect(sources[0] == children[1] && sources[1] == children[4] && sources[2] == children[7]);
+
+        //the last edit of a pair decides
+        registry.remove_relation<child_of>(children[4], parents[1]);
+        registry.add_relation<child_of>(children[5], parents[0]);
+        registry.remove_relation<child_of>(children[5], parents[0]);
+        registry.add_relation<child_of>(children[5], parents[0]);
+        expect(registry.relation_sources<child_of>(parents[1]).size() == 2_u);
+        expect(registry.relation_targets<child_of>(children[5]).size() == 2_u);
+
+        //destroying an entity drops its pairs on both sides
+        auto components = registry.component_types<Position>();
+        auto position_only = sorted_sequence_cref<component_type_index>(components.begin(), components.end());
+        registry.destroy(position_only, sequence_cref<entity>(parents.data(), parents.data() + 1));
+        expect(registry.relation_targets<child_of>(children[0]).size() == 0_u);
+        expect(registry.relation_targets<child_of>(children[5]).size() == 1_u);
+        expect(registry.relation_sources<child_of>(parents[0]).size() == 0_u);
+        registry.destroy(position_only, sequence_cref<entity>(children.data() + 1, children.data() + 2));
+        expect(registry.relation_sources<child_of>(parents[1]).size() == 1_u);
+    };
+
+    "executer resolves the targets of a relation"_test = []
+    {
+        relation_registry registry(ecs_global_rtti_context::register_context());
+
+        vector<entity> parents(4);
+        registry.emplace_static(parents, Position{10}, Health{1});
+        vector<entity> plain_parents(2);
+        registry.emplace_static(plain_parents, Position{20});
+        vector<entity> children(24);
+        registry.emplace_static(children, Position{0});
+        vector<entity> orphans(5);
+        registry.emplace_static(orphans, Position{0});
+
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            entity parent = i % 3 == 0 ? plain_parents[i % plain_parents.size()] : parents[i % parents.size()];
+            registry.add_relation<child_of>(children[i], parent);
+        }
+
+        executer_builder builder(registry);
+        size_t followed = 0;
+        auto follow = builder.register_executer([&](Position& p, relation<child_of(const Position&, const Health&)> parent)
+        {
+            p.x = parent.get<0>().x + parent.get<1>().hp;
+            followed++;
+        });
+
+        auto position = registry.get_component_index(type_hash::of<Position>());
+        auto health = registry.get_component_index(type_hash::of<Health>());
+        auto relation_type = registry.get_component_index(type_hash::of<child_of>());
+        expect(std::ranges::find(follow.access().reads, relation_type) != follow.access().reads.end());
+        expect(std::ranges::find(follow.access().reads, health) != follow.access().reads.end());
+        expect(follow.access().writes == vector<component_type_index>{position});
+
+        follow();
+        //the children of the parents without health and the orphans are skipped
+        expect(followed == 16_u);
+
+        unordered_map<entity, int> positions;
+        builder.register_executer([&](entity e, const Position& p) { positions[e] = p.x; })();
+        for (size_t i = 0; i < children.size(); i++)
+            expect(positions[children[i]] == (i % 3 == 0 ? 0 : 11));
+        for (auto e: orphans) expect(positions[e] == 0);
+
+        //the relations edited after the registration are seen by the next call
+        registry.add_relation<child_of>(orphans[0], parents[0]);
+        registry.remove_relation<child_of>(children[1], parents[1]);
+        followed = 0;
+        follow();
+        expect(followed == 16_u);
+    };
+
+    "executer iterates all the targets of a multi relation"_test = []
+    {
+        relation_registry registry(ecs_global_rtti_context::register_context());
+
+        vector<entity> owners(3);
+        registry.emplace_static(owners, Health{0});
+        vector<entity> items(12);
+        registry.emplace_static(items, Weight{2}, Position{0});
+        vector<entity> loose(4);
+        registry.emplace_static(loose, Position{0});
+
+        //owner i owns i * 4 items and the loose entity i, which has no weight
+        size_t next_item = 0;
+        for (size_t owner_i = 0; owner_i < owners.size(); owner_i++)
+        {
+            for (size_t i = 0; i < owner_i * 4; i++)
+                registry.add_relation<owns>(owners[owner_i], items[next_item++]);
+            registry.add_relation<owns>(owners[owner_i], loose[owner_i]);
+        }
+
+        executer_builder builder(registry);
+        size_t visited_owners = 0;
+        builder.register_executer([&](Health& h, multi_relation<owns(const Weight&, Position&)> inventory)
+        {
+            visited_owners++;
+            h.hp = 0;
+            for (auto item: inventory)
+            {
+                h.hp += item.get<0>().w;
+                item.get<1>().x += 1;
+            }
+        })();
+        expect(visited_owners == 3_u);
+
+        unordered_map<entity, int> hp;
+        builder.register_executer([&](entity e, const Health& h) { hp[e] = h.hp; })();
+        expect(hp[owners[0]] == 0);
+        expect(hp[owners[1]] == 8);
+        expect(hp[owners[2]] == 16);
+
+        size_t moved = 0;
+        builder.register_executer([&](const Position& p, const Weight&) { moved += p.x; })();
+        expect(moved == 12_u);
+        builder.register_executer([&](const Position& p, none_of<Weight>) { expect(p.x == 0); })();
+    };
+};
@@ -0,0 +1,120 @@
+#include "pch.h"
+
+#include "ecs/static_data_registry.h"
+#include "ecs/type/component_group.h"
+#include "core/alloc_counter.h"
+#include "../test_util/ut.hpp"
+
+using namespace hyecs;
+
+namespace test_steady_state_alloc
+{
+#define CONCATENATE_DIRECT(a, b) a##b
+#define CONCATENATE(a, b) CONCATENATE_DIRECT(a, b)
+#define ANON CONCATENATE(_ecs_register_, __COUNTER__)
+
+    constexpr auto group_frame = named_component_group<"Group Steady State">();
+    ecs_rtti_group_register ANON(group_frame);
+
+    struct P
+    {
+        int x;
+    };
+
+    struct V
+    {
+        int x;
+    };
+
+    struct Level : tag_component
+    {
+        int level;
+    };
+
+    struct Marked
+    {
+    };
+
+    ecs_rtti_register<P, group_frame> ANON;
+    ecs_rtti_register<V, group_frame> ANON;
+    ecs_rtti_register<Level, group_frame> ANON;
+    ecs_rtti_register<Marked, group_frame> ANON;
+
+    struct register_idents
+    {
+        enum
+        {
+            main,
+        };
+    };
+
+    class frame_registry : public immediate_data_registry<register_idents::main>
+    {
+        using immediate_data_registry::immediate_data_registry;
+    };
+}
+
+namespace ut = boost::ut;
+
+//the hook is installed by _TEST_main.cpp
+static ut::suite test_suite = []
+{
+    using namespace ut;
+    using namespace test_steady_state_alloc;
+
+    "steady state frame allocates nothing"_test = []
+    {
+        expect(alloc::hooked());
+
+        frame_registry registry(ecs_global_rtti_context::register_context());
+
+        //full set, mixed and sparse table tag queries, and plain archetypes
+        vector<entity> entities(64);
+        registry.emplace_static(entities, P{1}, V{2});
+        registry.emplace_static(entities, P{1}, V{2}, Marked{});
+        registry.emplace_static(entities, P{1}, V{2}, Level{{}, 3});
+        registry.emplace_static(entities, P{1}, V{2}, Level{{}, 3}, Marked{});
+        registry.emplace_static(entities, P{1});
+
+        auto& q_pv = registry.get_query({{registry.component_types<P, V>()}, {}, {}});
+        auto& q_level = registry.get_query({{registry.component_types<P, Level>()}, {}, {}});
+        auto& q_marked = registry.get_query({{registry.component_types<V, Marked>()}, {}, {}});
+        auto& pv_access = q_pv.get_access_info(registry.component_types<P, V>());
+        auto& level_access = q_level.get_access_info(registry.component_types<P, Level>());
+        auto& marked_access = q_marked.get_access_info(registry.component_types<V>());
+        auto random_types = sorted_sequence_cref(sequence_cref(registry.component_types<P, V>()));
+        entity random_entity = entities[0];
+
+        int sum = 0;
+        auto frame = [&]
+        {
+            q_pv.dynamic_for_each(pv_access, [&](entity, sequence_ref<void*> data)
+            {
+                auto [p, v] = data.cast_tuple<P*, V*>();
+                p->x += v->x;
+                sum += p->x;
+            });
+            q_level.dynamic_for_each(level_access, [&](entity, sequence_ref<void*> data)
+            {
+                auto [p, level] = data.cast_tuple<P*, Level*>();
+                sum += p->x * level->level;
+            });
+            q_marked.dynamic_for_each(marked_access, [&](entity, sequence_ref<void*> data)
+            {
+                sum += static_cast<V*>(data[0])->x;
+            });
+            std::array<void*, 2> addresses;
+            registry.component_ramdom_access(random_entity, random_types, sequence_ref(addresses));
+            sum += static_cast<P*>(addresses[0])->x;
+        };
+
+        //the first frame may build caches
+        frame();
+
+        constexpr size_t frame_count = 16;
+        alloc::scope frames;
+        for (size_t i = 0; i < frame_count; i++) frame();
+        expect(frames.allocations() == 0_ull) << frames.allocations_per(frame_count) << "allocations per frame";
+        expect(sum != 0_i);
+    };
+};
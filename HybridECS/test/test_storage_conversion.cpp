@@ -0,0 +1,202 @@
+#include "pch.h"
+
+#include "ecs/static_data_registry.h"
+#include "ecs/type/component_group.h"
+#include "../test_util/ut.hpp"
+
+using namespace hyecs;
+
+namespace test_storage_conversion
+{
+#define CONCATENATE_DIRECT(a, b) a##b
+#define CONCATENATE(a, b) CONCATENATE_DIRECT(a, b)
+#define ANON CONCATENATE(_ecs_register_, __COUNTER__)
+
+    constexpr auto group_conv = named_component_group<"Group Conversion">();
+    ecs_rtti_group_register ANON(group_conv);
+
+    struct P
+    {
+        int x;
+    };
+
+    struct V
+    {
+        int x;
+    };
+
+    struct Tag
+    {
+    };
+
+    ecs_rtti_register<P, group_conv> ANON;
+    ecs_rtti_register<V, group_conv> ANON;
+    ecs_rtti_register<Tag, group_conv> ANON;
+
+    struct register_idents
+    {
+        enum
+        {
+            main,
+        };
+    };
+
+    class conversion_registry : public immediate_data_registry<register_idents::main>
+    {
+        using immediate_data_registry::immediate_data_registry;
+    };
+}
+
+namespace ut = boost::ut;
+
+static ut::suite test_suite = []
+{
+    using namespace ut;
+    using namespace test_storage_conversion;
+
+    "incremental conversion"_test = []
+    {
+        conversion_registry registry(ecs_global_rtti_context::register_context());
+        registry.set_incremental_storage_conversion(true);
+
+        auto& q = registry.get_query({{registry.component_types<P, V>()}, {}, {}});
+        auto& q_tag = registry.get_query({{registry.component_types<P, V, Tag>()}, {}, {}});
+        auto check = [&](auto& query, int expected_count)
+        {
+            int count = 0;
+            query.dynamic_for_each(query.get_access_info(registry.component_types<P, V>()),
+                                   [&](entity e, sequence_ref<void*> data)
+                                   {
+                                       auto [p, v] = data.cast_tuple<P*, V*>();
+                                       expect(p->x == 1 && v->x == 2);
+                                       count++;
+                                   });
+            expect(count == expected_count) << count << "!=" << expected_count;
+        };
+
+        auto emplace = [&](uint32_t count, bool tagged)
+        {
+            vector<entity> entities(count);
+            if (tagged) registry.emplace_static(entities, P{1}, V{2}, Tag{});
+            else registry.emplace_static(entities, P{1}, V{2});
+        };
+
+        emplace(8, false);
+        emplace(8, true);
+        expect(!registry.has_pending_storage_conversion());
+
+        //crossing the threshold starts the conversion but moves nothing
+        emplace(2000, false);
+        emplace(2000, true);
+        expect(registry.has_pending_storage_conversion());
+        check(q, 4016);
+        check(q_tag, 2008);
+
+        while (registry.has_pending_storage_conversion())
+        {
+            registry.step_storage_conversion(64);
+            check(q, 4016);
+            check(q_tag, 2008);
+        }
+        check(q, 4016);
+        check(q_tag, 2008);
+    };
+
+    "random access after compaction converts to sparse"_test = []
+    {
+        conversion_registry registry(ecs_global_rtti_context::register_context());
+
+        vector<entity> entities(4096);
+        registry.emplace_static(entities, P{1}, V{2});
+        vector<entity> destroyed(entities.begin(), entities.end() - 64);
+        vector<entity> survivors(entities.end() - 64, entities.end());
+        auto components = registry.component_types<P, V>();
+        auto sorted_components = sorted_sequence_cref<component_type_index>(components.begin(), components.end());
+        registry.destroy(sorted_components, destroyed);
+        expect(registry.memory_report().storage_key_count == survivors.size());
+
+        //the compacted table is below the sparse threshold, the keys of the table go with it
+        registry.compact_storages(std::chrono::seconds(10));
+        expect(registry.memory_report().storage_key_count == 0_u);
+
+        size_t p_i = components[0] == registry.get_component_index(type_hash::of<P>()) ? 0 : 1;
+        auto check = [&]
+        {
+            for (auto e: survivors)
+            {
+                std::array<void*, 2> addresses;
+                registry.component_ramdom_access(e, sorted_components, sequence_ref(addresses));
+                expect(static_cast<P*>(addresses[p_i])->x == 1 && static_cast<V*>(addresses[1 - p_i])->x == 2);
+            }
+        };
+        check();
+
+        //back to a table, the survivors are keyed again
+        vector<entity> refill(4096);
+        registry.emplace_static(refill, P{1}, V{2});
+        expect(registry.memory_report().storage_key_count == survivors.size() + refill.size());
+        check();
+    };
+
+    //the rows of a tagged archetype live in the table of its untagged archetype, the queries created after
+    //the rows were moved read the keys kept by the tag archetype
+    static auto tag_query_after_moves = [](bool destroy_tagged)
+    {
+        conversion_registry registry(ecs_global_rtti_context::register_context());
+
+        vector<entity> plain(2048);
+        registry.emplace_static(plain, P{0}, V{0});
+        vector<entity> tagged(2048);
+        registry.emplace_static(tagged, P{0}, V{0}, Tag{});
+
+        auto& q = registry.get_query({{registry.component_types<P, V>()}, {}, {}});
+        unordered_map<entity, int> values;
+        int next_value = 0;
+        q.dynamic_for_each(q.get_access_info(registry.component_types<P, V>()),
+                           [&](entity e, sequence_ref<void*> data)
+                           {
+                               auto [p, v] = data.cast_tuple<P*, V*>();
+                               p->x = v->x = ++next_value;
+                               values[e] = next_value;
+                           });
+
+        //every other row of the table is destroyed, the compaction moves the rows behind into the holes
+        vector<entity> destroyed;
+        vector<entity> kept;
+        auto& victims = destroy_tagged ? tagged : plain;
+        for (size_t i = 0; i < victims.size(); i++)
+            (i % 2 ? destroyed : kept).push_back(victims[i]);
+        if (destroy_tagged)
+        {
+            auto components = registry.component_types<P, V, Tag>();
+            registry.destroy(sorted_sequence_cref<component_type_index>(components.begin(), components.end()), destroyed);
+        }
+        else
+        {
+            auto components = registry.component_types<P, V>();
+            registry.destroy(sorted_sequence_cref<component_type_index>(components.begin(), components.end()), destroyed);
+        }
+        expect(registry.compact_storages(std::chrono::seconds(10)) > 0_u);
+
+        auto& q_tag = registry.get_query({{registry.component_types<P, V, Tag>()}, {}, {}});
+        size_t count = 0;
+        q_tag.dynamic_for_each(q_tag.get_access_info(registry.component_types<P, V>()),
+                               [&](entity e, sequence_ref<void*> data)
+                               {
+                                   auto [p, v] = data.cast_tuple<P*, V*>();
+                                   expect(p->x == values[e] && v->x == values[e]);
+                                   count++;
+                               });
+        expect(count == (destroy_tagged ? kept.size() : tagged.size()));
+    };
+
+    "tag query created after compaction"_test = []
+    {
+        tag_query_after_moves(false);
+    };
+
+    "tag query created after destroying tagged entities"_test = []
+    {
+        tag_query_after_moves(true);
+    };
+};
@@ -0,0 +1,209 @@
+#include "pch.h"
+
+#include "ecs/static_data_registry.h"
+#include "ecs/type/component_group.h"
+#include "../test_util/ut.hpp"
+
+using namespace hyecs;
+
+namespace test_system_fusion
+{
+#define CONCATENATE_DIRECT(a, b) a##b
+#define CONCATENATE(a, b) CONCATENATE_DIRECT(a, b)
+#define ANON CONCATENATE(_ecs_register_, __COUNTER__)
+
+    constexpr auto group_fusion = named_component_group<"Group Fusion">();
+    ecs_rtti_group_register ANON(group_fusion);
+
+    struct P
+    {
+        int x;
+    };
+
+    struct V
+    {
+        int x;
+    };
+
+    struct Limit
+    {
+        int max;
+    };
+
+    struct Level : tag_component
+    {
+        int level;
+    };
+
+    ecs_rtti_register<P, group_fusion> ANON;
+    ecs_rtti_register<V, group_fusion> ANON;
+    ecs_rtti_register<Limit, group_fusion> ANON;
+    ecs_rtti_register<Level, group_fusion> ANON;
+
+    struct register_idents
+    {
+        enum
+        {
+            main,
+        };
+    };
+
+    class fusion_registry : public immediate_data_registry<register_idents::main>
+    {
+        using immediate_data_registry::immediate_data_registry;
+    };
+}
+
+namespace ut = boost::ut;
+
+static ut::suite test_suite = []
+{
+    using namespace ut;
+    using namespace test_system_fusion;
+
+    "fused systems apply each system to its own archetypes in order"_test = []
+    {
+        fusion_registry registry(ecs_global_rtti_context::register_context());
+
+        vector<entity> free_movers(3000);
+        registry.emplace_static(free_movers, P{1}, V{2});
+        vector<entity> limited(500);
+        registry.emplace_static(limited, P{1}, V{2}, Limit{2});
+        vector<entity> leveled(8);
+        registry.emplace_static(leveled, P{1}, V{2}, Level{{}, 1});
+
+        auto moving_types = registry.component_types<P, V>();
+        auto limited_types = registry.component_types<P, V, Limit>();
+        auto clamp_access = registry.component_types<P, Limit>();
+        auto& moving = registry.get_query({{moving_types}, {}, {}});
+        auto& clamped = registry.get_query({{limited_types}, {}, {}});
+
+        size_t integrated_rows = 0;
+        size_t clamped_rows = 0;
+        fused_systems chain(moving);
+        chain.add(moving, moving_types, [&](sequence_cref<entity>, sequence_cref<void*> columns,
+                                            sequence_cref<uint32_t> strides, uint32_t count)
+             {
+                 for (uint32_t r = 0; r < count; r++)
+                 {
+                     auto p = reinterpret_cast<P*>(static_cast<std::byte*>(columns[0]) + r * strides[0]);
+                     auto v = reinterpret_cast<V*>(static_cast<std::byte*>(columns[1]) + r * strides[1]);
+                     p->x += v->x;
+                 }
+                 integrated_rows += count;
+             })
+             .add(clamped, clamp_access, [&](sequence_cref<entity>, sequence_cref<void*> columns,
+                                             sequence_cref<uint32_t> strides, uint32_t count)
+             {
+                 for (uint32_t r = 0; r < count; r++)
+                 {
+                     auto p = reinterpret_cast<P*>(static_cast<std::byte*>(columns[0]) + r * strides[0]);
+                     auto limit = reinterpret_cast<Limit*>(static_cast<std::byte*>(columns[1]) + r * strides[1]);
+                     //the integration of the row is already applied
+                     expect(p->x == 3);
+                     p->x = std::min(p->x, limit->max);
+                 }
+                 clamped_rows += count;
+             });
+        expect(chain.system_count() == 2_u);
+        chain.run();
+        expect(integrated_rows == 3508_u);
+        expect(clamped_rows == 500_u);
+
+        unordered_map<entity, int> positions;
+        auto& access = moving.get_access_info(moving_types);
+        moving.dynamic_for_each(access, [&](entity e, sequence_ref<void*> data)
+        {
+            positions[e] = static_cast<P*>(data[0])->x;
+        });
+        for (auto e: free_movers) expect(positions[e] == 3);
+        for (auto e: limited) expect(positions[e] == 2);
+        for (auto e: leveled) expect(positions[e] == 3);
+    };
+
+    "a tag query system keeps its place in the chain"_test = []
+    {
+        fusion_registry registry(ecs_global_rtti_context::register_context());
+
+        vector<entity> movers(2000);
+        registry.emplace_static(movers, P{1}, V{2});
+        vector<entity> leveled(1000);
+        registry.emplace_static(leveled, P{1}, V{2}, Level{{}, 3});
+
+        auto moving_types = registry.component_types<P, V>();
+        auto level_access = registry.unsorted_component_types<P, Level>();
+        auto& moving = registry.get_query({{moving_types}, {}, {}});
+        auto& scaled = registry.get_query({{registry.component_types<P, V, Level>()}, {}, {}});
+        expect(!scaled.tag_table_queries().empty());
+
+        size_t scaled_rows = 0;
+        fused_systems chain(moving);
+        //the leveled rows are scaled before the integration reaches them
+        chain.add(scaled, level_access, [&](sequence_cref<entity>, sequence_cref<void*> columns,
+                                            sequence_cref<uint32_t> strides, uint32_t count)
+             {
+                 for (uint32_t r = 0; r < count; r++)
+                 {
+                     auto p = reinterpret_cast<P*>(static_cast<std::byte*>(columns[0]) + r * strides[0]);
+                     auto level = reinterpret_cast<Level*>(static_cast<std::byte*>(columns[1]) + r * strides[1]);
+                     expect(p->x == 1);
+                     p->x *= level->level;
+                 }
+                 scaled_rows += count;
+             })
+             .add(moving, moving_types, [&](sequence_cref<entity>, sequence_cref<void*> columns,
+                                            sequence_cref<uint32_t> strides, uint32_t count)
+             {
+                 for (uint32_t r = 0; r < count; r++)
+                 {
+                     auto p = reinterpret_cast<P*>(static_cast<std::byte*>(columns[0]) + r * strides[0]);
+                     auto v = reinterpret_cast<V*>(static_cast<std::byte*>(columns[1]) + r * strides[1]);
+                     p->x += v->x;
+                 }
+             });
+        chain.run();
+        expect(scaled_rows == 1000_u);
+
+        unordered_map<entity, int> positions;
+        moving.dynamic_for_each(moving.get_access_info(moving_types), [&](entity e, sequence_ref<void*> data)
+        {
+            positions[e] = static_cast<P*>(data[0])->x;
+        });
+        for (auto e: movers) expect(positions[e] == 3);
+        for (auto e: leveled) expect(positions[e] == 5);
+    };
+
+    "fused systems read the columns in the order of their own access list"_test = []
+    {
+        fusion_registry registry(ecs_global_rtti_context::register_context());
+
+        vector<entity> movers(3000);
+        registry.emplace_static(movers, P{1}, V{2});
+
+        auto position_first = registry.unsorted_component_types<P, V>();
+        auto velocity_first = registry.unsorted_component_types<V, P>();
+        auto& moving = registry.get_query({{registry.component_types<P, V>()}, {}, {}});
+
+        size_t checked_rows = 0;
+        fused_systems chain(moving);
+        chain.add(moving, position_first, [&](sequence_cref<entity>, sequence_cref<void*> columns,
+                                              sequence_cref<uint32_t> strides, uint32_t count)
+             {
+                 for (uint32_t r = 0; r < count; r++)
+                     reinterpret_cast<P*>(static_cast<std::byte*>(columns[0]) + r * strides[0])->x += 10;
+             })
+             .add(moving, velocity_first, [&](sequence_cref<entity>, sequence_cref<void*> columns,
+                                              sequence_cref<uint32_t> strides, uint32_t count)
+             {
+                 for (uint32_t r = 0; r < count; r++)
+                 {
+                     auto v = reinterpret_cast<V*>(static_cast<std::byte*>(columns[0]) + r * strides[0]);
+                     auto p = reinterpret_cast<P*>(static_cast<std::byte*>(columns[1]) + r * strides[1]);
+                     expect(v->x == 2 && p->x == 11);
+                 }
+                 checked_rows += count;
+             });
+        chain.run();
+        expect(checked_rows == 3000_u);
+    };
+};
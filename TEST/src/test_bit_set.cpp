@@ -0,0 +1,123 @@
+#include "container/bit_set.h"
+
+#include "include.h"
+
+using namespace hyecs;
+
+namespace ut = boost::ut;
+
+namespace
+{
+    bit_set make_set(std::initializer_list<uint32_t> indices)
+    {
+        bit_set set;
+        for (auto i: indices) set.insert(bit_key(i));
+        return set;
+    }
+}
+
+static ut::suite _ = []
+{
+    using namespace ut;
+
+    "bit_set_inline"_test = []
+    {
+        MemoryLeakDetector detector;
+
+        //one block of 256 bits at any offset stays inline
+        for (uint32_t base: {0u, 256u, 10240u, 1u << 20})
+        {
+            auto set = make_set({base + 1, base + 31, base + 32, base + 255});
+            expect(set.heap_bytes() == 0_u);
+            expect(set.contains(bit_key(base + 1)));
+            expect(set.contains(bit_key(base + 255)));
+            expect(!set.contains(bit_key(base + 2)));
+            expect(!set.contains(bit_key(base + 256)));
+            expect(!set.contains(bit_key(0x7fffffff)));
+
+            auto subset = make_set({base + 31, base + 255});
+            expect(set.contains(subset));
+            expect(!subset.contains(set));
+            expect(set.contains_any(subset));
+            expect(!set.contains_any(make_set({base + 2})));
+        }
+    };
+
+    "bit_set_sparse"_test = []
+    {
+        MemoryLeakDetector detector;
+
+        auto set = make_set({3, 10000, 600, 20000, 257});
+        expect(set.heap_bytes() > 0_u);
+        for (uint32_t i: {3u, 257u, 600u, 10000u, 20000u})
+            expect(set.contains(bit_key(i))) << i;
+        for (uint32_t i: {4u, 256u, 601u, 9999u, 15000u, 30000u})
+            expect(!set.contains(bit_key(i))) << i;
+
+        expect(set.contains(make_set({20000, 3})));
+        expect(set.contains(make_set({10000})));
+        expect(!set.contains(make_set({10000, 10001})));
+        expect(!set.contains(make_set({15000})));
+        expect(set.contains(bit_set()));
+        expect(!bit_set().contains(set));
+
+        expect(set.contains_any(make_set({15000, 20000})));
+        expect(set.contains_any(make_set({257})));
+        expect(!set.contains_any(make_set({15000, 30000, 4})));
+        expect(!set.contains_any(bit_set()));
+        expect(set.none_of(make_set({1, 2})));
+
+        //the insertion order does not matter
+        expect(set == make_set({20000, 10000, 600, 257, 3}));
+        expect(!(set == make_set({20000, 10000, 600, 257})));
+    };
+
+    "bit_set_erase"_test = []
+    {
+        MemoryLeakDetector detector;
+
+        auto set = make_set({5, 10000});
+        set.erase(bit_key(10000));
+        set.erase(bit_key(40000));
+        expect(!set.contains(bit_key(10000)));
+        //the emptied block is kept but does not count
+        expect(set == make_set({5}));
+        expect(make_set({5}) == set);
+        expect(make_set({5}).contains(set));
+        expect(!set.contains_any(make_set({10000})));
+    };
+
+    "bit_set_copy_move"_test = []
+    {
+        MemoryLeakDetector detector;
+
+        auto sparse = make_set({1, 1000, 100000});
+        auto inline_set = make_set({7});
+
+        bit_set copy = sparse;
+        expect(copy == sparse);
+        copy.insert(bit_key(2000));
+        expect(!sparse.contains(bit_key(2000)));
+
+        bit_set moved = std::move(copy);
+        expect(moved.contains(bit_key(2000)));
+        expect(moved.contains(sparse));
+
+        //sparse to inline and back
+        moved = inline_set;
+        expect(moved == inline_set);
+        expect(moved.heap_bytes() == 0_u);
+        moved = sparse;
+        expect(moved == sparse);
+        moved = std::move(inline_set);
+        expect(moved == make_set({7}));
+        moved.insert(bit_key(50000));
+        expect(moved == make_set({7, 50000}));
+
+        //a copy keeps the emptied block and still compares equal
+        auto erased = make_set({1, 1000});
+        erased.erase(bit_key(1000));
+        bit_set copy_erased = erased;
+        expect(copy_erased == make_set({1}));
+    };
+};
@@ -0,0 +1,77 @@
+#include "container/chunk_arena.h"
+#include "container/raw_segmented_vector.h"
+#include "ut.hpp"
+
+using namespace hyecs;
+
+namespace ut = boost::ut;
+
+static ut::suite _ = []
+{
+    using namespace ut;
+
+    "chunk arena reuse"_test = []
+    {
+        chunk_arena arena;
+        std::byte* a = arena.allocate(2048);
+        std::byte* b = arena.allocate(2048);
+        expect(a != b);
+        expect(reinterpret_cast<uintptr_t>(a) % 2048 == 0);
+        expect(reinterpret_cast<uintptr_t>(b) % 2048 == 0);
+        expect(arena.allocated_bytes() == 4096);
+        arena.deallocate(a, 2048);
+        //same size class reuses the freed chunk
+        expect(arena.allocate(1500) == a);
+        arena.deallocate(a, 1500);
+        arena.deallocate(b, 2048);
+        expect(arena.allocated_bytes() == 0);
+        expect(arena.slab_count() == 1);
+    };
+
+    "chunk arena counts oversized chunks"_test = []
+    {
+        chunk_arena arena;
+        const size_t size = chunk_arena::max_chunk_size * 2;
+        std::byte* ptr = arena.allocate(size);
+        //taken from the system directly, not from a slab
+        expect(arena.slab_count() == 0);
+        expect(arena.allocated_bytes() == size);
+        arena.deallocate(ptr, size);
+        expect(arena.allocated_bytes() == 0);
+    };
+
+    "chunk arena page alignment"_test = []
+    {
+        chunk_arena arena({.slab_size = 1024 * 1024, .huge_pages = true});
+        vector<std::byte*> chunks;
+        for (int i = 0; i < 64; i++)
+        {
+            std::byte* ptr = arena.allocate(64 * 1024);
+            expect(reinterpret_cast<uintptr_t>(ptr) % chunk_arena::page_size == 0);
+            std::memset(ptr, i, 64 * 1024);
+            chunks.push_back(ptr);
+        }
+        expect(arena.slab_count() >= 4);
+        for (auto ptr: chunks)
+            arena.deallocate(ptr, 64 * 1024);
+        size_t reserved = arena.reserved_bytes();
+        for (int i = 0; i < 64; i++)
+            chunks[i] = arena.allocate(64 * 1024);
+        expect(arena.reserved_bytes() == reserved);
+        for (auto ptr: chunks)
+            arena.deallocate(ptr, 64 * 1024);
+    };
+
+    "segmented vector on arena"_test = []
+    {
+        chunk_arena arena;
+        {
+            raw_segmented_vector vec(sizeof(uint64_t), alignof(uint64_t), &arena);
+            for (uint64_t i = 0; i < 10000; i++)
+                *static_cast<uint64_t*>(vec.allocate_value().first) = i;
+            expect(vec.size() == 10000);
+            expect(arena.allocated_bytes() != 0);
+        }
+        expect(arena.allocated_bytes() == 0);
+    };
+};
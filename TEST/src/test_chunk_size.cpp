@@ -0,0 +1,28 @@
+#include "ecs/storage/table.h"
+#include "ut.hpp"
+
+using namespace hyecs;
+
+namespace ut = boost::ut;
+
+static ut::suite _ = []
+{
+    using namespace ut;
+
+    "chunk size policy"_test = []
+    {
+        chunk_size_policy policy;
+        //small rows stay at the minimum size
+        expect(policy.chunk_size(12) == component_table_chunk_traits::min_size);
+        //larger rows grow the chunk to hold the target count
+        expect(policy.chunk_size(200) == 32 * 1024);
+        expect(chunk_size_policy::chunk_capacity(policy.chunk_size(200), 200) >= 128 - 1);
+        //clamped to the maximum
+        expect(policy.chunk_size(4096) == component_table_chunk_traits::max_size);
+        //a row larger than the maximum still fits once
+        expect(chunk_size_policy::chunk_capacity(policy.chunk_size(100 * 1024), 100 * 1024) == 1);
+
+        chunk_size_policy small{.target_entity_count = 16};
+        expect(small.chunk_size(200) == 4 * 1024);
+    };
+};
@@ -0,0 +1,59 @@
+#include "container/container.h"
+#include "ut.hpp"
+
+using namespace hyecs;
+
+namespace ut = boost::ut;
+
+static ut::suite _ = []
+{
+    using namespace ut;
+
+    "frame arena bump and rewind"_test = []
+    {
+        memory::frame_arena arena(4096);
+        auto begin = arena.mark();
+        void* a = arena.allocate(100, 8);
+        void* b = arena.allocate(100, 64);
+        expect(a != b);
+        expect(reinterpret_cast<uintptr_t>(b) % 64 == 0);
+        //the latest allocation is given back
+        arena.deallocate(b, 100);
+        expect(arena.allocate(100, 64) == b);
+        arena.rewind(begin);
+        expect(arena.allocate(100, 8) == a);
+        expect(arena.reserved_bytes() == 4096);
+    };
+
+    "frame arena keeps blocks across frames"_test = []
+    {
+        memory::frame_arena arena(1024);
+        auto frame = [&]
+        {
+            memory::frame_scope scope(arena);
+            vector<uint64_t, memory::frame_allocator<uint64_t>> values{memory::frame_allocator<uint64_t>(arena)};
+            for (uint64_t i = 0; i < 5000; i++) values.push_back(i);
+            for (uint64_t i = 0; i < 5000; i++) expect(values[i] == i);
+            //oversized for a block
+            std::byte* large = static_cast<std::byte*>(arena.allocate(8192));
+            std::memset(large, 0xAB, 8192);
+        };
+        frame();
+        size_t reserved = arena.reserved_bytes();
+        expect(reserved > 0);
+        for (int i = 0; i < 8; i++) frame();
+        expect(arena.reserved_bytes() == reserved);
+        arena.reset();
+        frame();
+        expect(arena.reserved_bytes() == reserved);
+    };
+
+    "access buffer spills to the frame arena"_test = []
+    {
+        memory::frame_scope scope;
+        access_buffer<void*> buffer(access_inline_capacity * 4, nullptr);
+        for (auto& ptr: buffer) expect(ptr == nullptr);
+        memory::frame_vector<int> ints{1, 2, 3};
+        expect(ints.size() == 3);
+    };
+};
@@ -0,0 +1,66 @@
+#include "ecs/storage/storage_policy.h"
+#include "ut.hpp"
+
+using namespace hyecs;
+
+namespace ut = boost::ut;
+
+namespace
+{
+    storage_layout select(const auto& policy, storage_layout layout, size_t entity_count, const storage_access_profile& profile)
+    {
+        return policy(storage_policy_context{
+                .layout = layout,
+                .entity_count = entity_count,
+                .chunk_capacity = 100,
+                .component_count = 2,
+                .profile = profile
+        });
+    }
+}
+
+static ut::suite _ = []
+{
+    using namespace ut;
+
+    "threshold storage policy"_test = []
+    {
+        threshold_storage_policy policy;
+        storage_access_profile profile;
+        expect(select(policy, storage_layout::sparse, 100, profile) == storage_layout::sparse);
+        expect(select(policy, storage_layout::sparse, 101, profile) == storage_layout::chunk);
+        expect(select(policy, storage_layout::chunk, 50, profile) == storage_layout::chunk);
+        expect(select(policy, storage_layout::chunk, 49, profile) == storage_layout::sparse);
+    };
+
+    "adaptive storage policy hysteresis"_test = []
+    {
+        adaptive_storage_policy policy;
+        storage_access_profile profile;
+        expect(select(policy, storage_layout::sparse, 101, profile) == storage_layout::chunk);
+        expect(select(policy, storage_layout::chunk, 24, profile) == storage_layout::sparse);
+        //each conversion widens the band
+        profile.conversion_count = 2;
+        expect(select(policy, storage_layout::sparse, 101, profile) == storage_layout::sparse);
+        expect(select(policy, storage_layout::sparse, 401, profile) == storage_layout::chunk);
+        expect(select(policy, storage_layout::chunk, 24, profile) == storage_layout::chunk);
+        expect(select(policy, storage_layout::chunk, 6, profile) == storage_layout::sparse);
+    };
+
+    "adaptive storage policy random access"_test = []
+    {
+        adaptive_storage_policy policy;
+        storage_access_profile profile;
+        profile.record_sequential(1000);
+        profile.record_random(5000);
+        //random access dominated archetype stays sparse up to random_sparse_limit chunks
+        expect(select(policy, storage_layout::sparse, 300, profile) == storage_layout::sparse);
+        expect(select(policy, storage_layout::sparse, 401, profile) == storage_layout::chunk);
+        profile.record_sequential(10000);
+        expect(select(policy, storage_layout::sparse, 300, profile) == storage_layout::chunk);
+
+        profile.decay(1000);
+        expect(profile.sequential_access == 5500);
+        expect(profile.random_access == 2500);
+    };
+};
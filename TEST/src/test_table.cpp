@@ -263,6 +263,83 @@ static ut::suite _ = []
             expect(key_map.contains(e));
         }
     };
+
+    "table compaction"_test = [&]
+    {
+        MemoryLeakDetector detector;
+
+        table table(comp_seq);
+
+        vector<entity> entities;
+        for (uint32_t i = 0; i < 10240; i++)
+            entities.push_back(entity{i, 0});
+
+        unordered_map<entity, storage_key> key_map;
+        auto accessor = table.get_allocate_accessor(sequence_ref(entities).as_const(), [&](entity e, storage_key key)
+        {
+            key_map.insert({e, key});
+        });
+        auto entity_iter = entities.begin();
+        for (auto& component_accessor: accessor)
+        {
+            int i = 0;
+            for (void* addr: component_accessor)
+            {
+                if (component_accessor.comparable().hash() == type_hash::of<A>()) new(addr) A{i, i + 1, i + 2, i + 3};
+                else new(addr) B{i, i + 1, i + 2, i + 3};
+                i++;
+            }
+        }
+        accessor.notify_construct_finish();
+        table.bind_on_entities_move([&](sequence_cref<entity> moved, sequence_cref<storage_key> keys)
+        {
+            for (size_t i = 0; i < moved.size(); i++)
+                key_map[moved[i]] = keys[i];
+        });
+
+        //keep every 10th entity
+        vector<storage_key::table_offset_t> deallocate_keys;
+        for (uint32_t i = 0; i < 10240; i++)
+        {
+            if (i % 10 == 0) continue;
+            deallocate_keys.push_back(key_map[entities[i]].get_table_offset());
+            key_map.erase(entities[i]);
+        }
+        auto deallocate_accessor = table.get_deallocate_accessor(deallocate_keys);
+        deallocate_accessor.destruct();
+
+        //iteration skips the holes before they are swapped back
+        expect(table.hole_count() == 10240 - 1024);
+        uint32_t live_count = 0;
+        uint32_t a_index = components[0] == c1 ? 0 : 1;
+        table.dynamic_for_each(sequence_cref(&a_index, &a_index + 1), [&](entity e, sequence_ref<void*> addresses)
+        {
+            expect(e.id() % 10 == 0 && ((A*) addresses[0])->a == int(e.id()));
+            live_count++;
+        });
+        expect(live_count == 1024);
+
+        const size_t chunk_count = table.chunk_count();
+        expect(!table.is_compact());
+        //budgeted steps, the swap-back of the holes is bounded too
+        expect(table.compact(100) == 100);
+        expect(table.has_holes());
+        while (!table.is_compact())
+            expect(table.compact(100) <= 100);
+
+        expect(table.entity_count() == 1024);
+        expect(table.chunk_count() == (1024 + table.chunk_capacity() - 1) / table.chunk_capacity());
+        expect(table.chunk_count() < chunk_count);
+
+        vector<void*> addresses(1);
+        for (auto& [e, key]: key_map)
+        {
+            table.components_addresses(key, sequence_cref(&a_index, &a_index + 1), addresses);
+            A* a = (A*) addresses[0];
+            expect(a->a == int(e.id())) << "entity : " << e.id() << " a : " << a->a;
+        }
+    };
+
     "leak test"_test = []
     {
         expect(B::object_counter == 0)
@@ -0,0 +1,65 @@
+#include "core/trace.h"
+
+#include "include.h"
+
+#include <sstream>
+#include <thread>
+
+using namespace hyecs;
+
+namespace ut = boost::ut;
+
+//the trace points only exist in a HYECS_TRACE build
+#if defined(HYECS_TRACE)
+
+static ut::suite _ = []
+{
+    using namespace ut;
+
+    "trace_chrome_json"_test = []
+    {
+        trace::clear();
+        {
+            HYECS_TRACE_SCOPE("test::outer");
+            HYECS_TRACE_SCOPE_COUNT("test::inner", 42);
+        }
+        std::thread worker([]
+        {
+            HYECS_TRACE_SCOPE("test::worker");
+        });
+        worker.join();
+
+        std::ostringstream os;
+        trace::write_chrome_trace(os);
+        auto json = os.str();
+        expect(json.starts_with("{\"traceEvents\":[")) << json;
+        expect(json.ends_with("]}"));
+        expect(json.find("\"name\":\"test::outer\"") != std::string::npos);
+        expect(json.find("\"name\":\"test::worker\"") != std::string::npos);
+        expect(json.find("\"args\":{\"entities\":42}") != std::string::npos);
+
+        //a flush takes the events
+        std::ostringstream again;
+        trace::write_chrome_trace(again);
+        expect(again.str() == "{\"traceEvents\":[]}");
+    };
+
+    "trace_ring_wrap"_test = []
+    {
+        trace::clear();
+        for (size_t i = 0; i < trace::thread_buffer::capacity + 10; i++)
+        {
+            HYECS_TRACE_SCOPE("test::wrap");
+        }
+        std::ostringstream os;
+        trace::write_chrome_trace(os);
+        //only the latest events of the ring are kept, less the oldest slot a push in flight could be writing
+        auto json = os.str();
+        size_t count = 0;
+        for (size_t pos = json.find("test::wrap"); pos != std::string::npos; pos = json.find("test::wrap", pos + 1))
+            count++;
+        expect(count == trace::thread_buffer::capacity - 1);
+    };
+};
+
+#endif
@@ -12,4 +12,11 @@ includes('HybridECS/test_util')
 target('Test')
     set_languages('c++23')
     set_kind('binary')
-    add_files('Test/src/*.cpp')
\ No newline at end of file
+    add_files('Test/src/*.cpp')
+
+target('Bench')
+    set_languages('c++23')
+    set_kind('binary')
+    set_optimize('fastest')
+    add_includedirs('HybridECS/src', 'BENCH/src')
+    add_files('BENCH/src/*.cpp')